@@ -0,0 +1,93 @@
+/*!
+   \file metrics.c
+   \brief Sort based error rate, KS statistic and Cohen's d, see metrics.h
+*/
+
+#include "metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+
+
+// Sorted copy of a distribution, with its mean and sample variance (Welford)
+static double *sortedCopy(const double *dist, size_t count, double *mean, double *variance) {
+  double *sorted = malloc(count * sizeof(double));
+  if (sorted == NULL) {
+    return NULL;
+  }
+  double m = 0., squares = 0.;
+  for (size_t i = 0; i < count; i++) {
+    double delta = dist[i] - m;
+    m += delta / (i + 1);
+    squares += delta * (dist[i] - m);
+    sorted[i] = dist[i];
+  }
+  *mean = m;
+  *variance = count > 1 ? squares / (count - 1) : 0.;
+  qsort(sorted, count, sizeof(double), compareDoubles);
+  return sorted;
+}
+
+
+
+int computeMetrics(const double *dist1, size_t count1, const double *dist2, size_t count2, PcdMetrics *metrics) {
+  if ((count1 == 0) || (count2 == 0)) {
+    return -1;
+  }
+  double mean1, mean2, variance1, variance2;
+  double *sorted1 = sortedCopy(dist1, count1, &mean1, &variance1);
+  double *sorted2 = sortedCopy(dist2, count2, &mean2, &variance2);
+  if ((sorted1 == NULL) || (sorted2 == NULL)) {
+    free(sorted1);
+    free(sorted2);
+    return -1;
+  }
+
+  double pooled = sqrt((variance1 + variance2) / 2.);
+  metrics->cohenD = ((count1 > 1) && (count2 > 1) && (pooled > 0.)) ? fabs(mean1 - mean2) / pooled : 0.;
+
+  // Either distribution may be the low one. With dist1 low, the errors at a
+  // threshold v are the timings of dist1 above v and of dist2 below v. A
+  // timing equal to v is never an error, so no threshold between two values
+  // does better than one of the values.
+  size_t below1 = 0, below2 = 0; // Timings < v
+  size_t upTo1 = 0, upTo2 = 0; // Timings <= v
+  size_t bestErrors = count1 + count2;
+  double bestThreshold = sorted1[0];
+  double ks = 0.;
+  while ((upTo1 < count1) || (upTo2 < count2)) {
+    double v;
+    if (upTo1 == count1) v = sorted2[upTo2];
+    else if (upTo2 == count2) v = sorted1[upTo1];
+    else v = fmin(sorted1[upTo1], sorted2[upTo2]);
+    below1 = upTo1;
+    below2 = upTo2;
+    while ((upTo1 < count1) && (sorted1[upTo1] == v)) upTo1++;
+    while ((upTo2 < count2) && (sorted2[upTo2] == v)) upTo2++;
+
+    size_t low1Errors = (count1 - upTo1) + below2;
+    size_t low2Errors = (count2 - upTo2) + below1;
+    size_t errors = low1Errors < low2Errors ? low1Errors : low2Errors;
+    if (errors < bestErrors) {
+      bestErrors = errors;
+      bestThreshold = v;
+    }
+    double distance = fabs((double) upTo1 / count1 - (double) upTo2 / count2);
+    if (distance > ks) ks = distance;
+  }
+  metrics->errorRate = (double) bestErrors / (count1 + count2);
+  metrics->threshold = bestThreshold;
+  metrics->ks = ks;
+
+  free(sorted1);
+  free(sorted2);
+  return 1;
+}
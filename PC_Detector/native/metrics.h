@@ -0,0 +1,43 @@
+/*!
+   \file metrics.h
+   \brief Native metrics of PC-Detector, loaded by pc_detector.py with ctypes.
+          The error rate of two distributions is the one of the best threshold
+          between them. Instead of sweeping thresholds, both distributions are
+          sorted and walked once in a merge: the best threshold is one of their
+          values, and the errors at a value follow from the counts of the
+          values below it. The same pass gives the Kolmogorov-Smirnov
+          statistic, and Cohen's d is computed while copying the timings.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+
+
+/*!
+   \struct PcdMetrics
+   \brief Metrics of two distributions of timings
+*/
+typedef struct {
+  double errorRate; // Lowest rate of misclassified timings, in [0, 1]
+  double threshold; // Threshold of that error rate
+  double cohenD; // Absolute effect size, 0 if undefined
+  double ks; // Largest distance between the two empirical CDFs
+} PcdMetrics;
+
+
+
+/*!
+   \fn int computeMetrics(const double *dist1, size_t count1, const double *dist2, size_t count2, PcdMetrics *metrics)
+   \brief Computes every metric of two distributions, in O(n log n)
+   \param dist1 First distribution, left untouched
+   \param count1 Its number of timings (> 0)
+   \param dist2 Second distribution, left untouched
+   \param count2 Its number of timings (> 0)
+   \param metrics Output
+   \return 1 if ok, -1 if a distribution is empty or on allocation failure
+*/
+int computeMetrics(const double *dist1, size_t count1, const double *dist2, size_t count2, PcdMetrics *metrics);
+
+#endif
@@ -0,0 +1,120 @@
+/** This code is inspired by the code of Alday et al from https://github.com/bbbrumley/portsmash
+*
+*   Copyright 2018-2019 Alejandro Cabrera Aldaya, Billy Bob Brumley, Sohaib ul Hassan, Cesar Pereida García and Nicola Tuveri
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+**/
+#define _GNU_SOURCE
+#include "pcd.h"
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+static const char *socketPath = PCD_SOCKET;
+
+
+
+// Answers the commands of a client until it leaves or sends quit
+// Returns 0 if it sent quit, 1 otherwise
+int serveClient(int client) {
+  FILE *fp = fdopen(client, "r+");
+  if (fp == NULL) {
+    close(client);
+    return 1;
+  }
+  char line[64];
+  int quit = 0;
+  while (!quit && (fgets(line, sizeof(line), fp) != NULL)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    int port = findPort(line);
+    if (port == PCD_UNKNOWN) {
+      fprintf(fp, "error\n");
+    }
+    else if (port == PCD_QUIT) {
+      fprintf(fp, "ok %ld\n", switchPort(PCD_IDLE));
+      quit = 1;
+    }
+    else {
+      fprintf(fp, "ok %ld\n", switchPort(port));
+    }
+    fflush(fp);
+  }
+  // A client that leaves without a word does not leave the ports contended
+  if (!quit) switchPort(PCD_IDLE);
+  fclose(fp);
+  return !quit;
+}
+
+
+
+void stopDaemon(int signum) {
+  unlink(socketPath);
+  _exit(0);
+}
+
+
+
+int main(int argc, char *argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "s:h")) != -1) {
+    switch (opt) {
+      case 's': socketPath = optarg; break;
+      default:
+        printf("Usage: %s [-s socket]\n", argv[0]);
+        printf("\t-s socket\tPath of the Unix socket of the commands (default %s)\n", PCD_SOCKET);
+        return 1;
+    }
+  }
+
+  struct sockaddr_un address = {0};
+  address.sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", socketPath);
+    return 1;
+  }
+  strcpy(address.sun_path, socketPath);
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(socketPath);
+  if ((server == -1) || (bind(server, (struct sockaddr *) &address, sizeof(address)) == -1) || (listen(server, 1) == -1)) {
+    perror("Cannot listen on the socket");
+    return 1;
+  }
+  signal(SIGINT, stopDaemon);
+  signal(SIGTERM, stopDaemon);
+
+  int cpus[PCD_MAX_SPAM_THREADS];
+  startSpamThreads(cpus, coreSlots(cpus, PCD_MAX_SPAM_THREADS));
+  printf("Listening on %s\n", socketPath);
+  fflush(stdout);
+
+  int running = 1;
+  while (running) {
+    int client = accept(server, NULL, NULL);
+    if (client == -1) {
+      continue;
+    }
+    running = serveClient(client);
+  }
+  stopSpamThreads();
+  close(server);
+  unlink(socketPath);
+  return 0;
+}
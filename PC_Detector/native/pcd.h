@@ -0,0 +1,98 @@
+/** This code is inspired by the code of Alday et al from https://github.com/bbbrumley/portsmash
+*
+*   Copyright 2018-2019 Alejandro Cabrera Aldaya, Billy Bob Brumley, Sohaib ul Hassan, Cesar Pereida García and Nicola Tuveri
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+**/
+#ifndef PCD_H
+#define PCD_H
+
+/*!
+   \file pcd.h
+   \brief Port spam daemon of PC-Detector.
+          A single process keeps a spam thread pinned on each physical core,
+          and switches the port they contend (or idle) on the commands of
+          pc_detector.py, over a Unix socket. Each command is a line: idle, 0,
+          1, 23, 5, 6 (the port) or quit. The daemon answers "ok <ns>" once
+          every thread runs the new kernel, with the time the switch took, or
+          "error" for an unknown command.
+          Spam threads run bursts of PCD_BURST repetitions and check the
+          command between two of them, idle threads sleep on a futex.
+          The threads live in pcdSpam.c, so that pcd_native (pcdNative.c)
+          contends the ports the same way, in process.
+*/
+
+#define PCD_BURST 16 // Repetitions between two checks of the command, a few us
+#define PCD_SOCKET "pcd.sock"
+#define PCD_MAX_SPAM_THREADS 256
+
+// Ports that are not an execution port
+#define PCD_IDLE -1
+#define PCD_QUIT -2
+#define PCD_UNKNOWN -3
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+// Same loops as the spam_port* of the single port binaries, for a number of repetitions
+extern void spam_port0_n(uint64_t repetitions);
+extern void spam_port1_n(uint64_t repetitions);
+extern void spam_port23_n(uint64_t repetitions);
+extern void spam_port5_n(uint64_t repetitions);
+extern void spam_port6_n(uint64_t repetitions);
+
+
+
+/*!
+   \fn int findPort(const char *name)
+   \return The port of a command (0, 1, 23, 5 or 6), PCD_IDLE, PCD_QUIT or
+           PCD_UNKNOWN
+*/
+int findPort(const char *name);
+
+
+
+/*!
+   \fn const char *portName(int port)
+   \return The command of a port (see findPort), NULL if it is unknown
+*/
+const char *portName(int port);
+
+
+
+/*!
+   \fn int startSpamThreads(const int *cpus, int count)
+   \brief Starts idle spam threads, one pinned on each of the given CPUs
+          (usually one per physical core)
+   \return 1 if ok, -1 if count is not in [1, PCD_MAX_SPAM_THREADS]
+*/
+int startSpamThreads(const int *cpus, int count);
+
+
+
+/*!
+   \fn long switchPort(int port)
+   \brief Switches every spam thread to a port (see findPort)
+   \return The time the switch took in ns, once every thread runs the port
+*/
+long switchPort(int port);
+
+
+
+/*!
+   \fn int stopSpamThreads()
+   \brief Stops and joins the spam threads
+*/
+int stopSpamThreads();
+#endif
+
+#endif
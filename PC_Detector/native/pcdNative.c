@@ -0,0 +1,158 @@
+/*!
+   \file pcdNative.c
+   \brief Times wasm2c compiled spam modules under port contention, see
+          pcdNative.h.
+          For each module, prints a json line with the timings (in ms, like
+          performance.now) of each port: {"module": path, "control": [...],
+          "p0": [...], ...}.
+*/
+#define _GNU_SOURCE
+#include "pcdNative.h"
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <getopt.h>
+#include <pthread.h>
+
+
+typedef struct {
+  void *library;
+  PcdInit init;
+  PcdSpam spam;
+  PcdFree free;
+} NativeModule;
+
+
+
+int loadModule(const char *path, NativeModule *module) {
+  module->library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (module->library == NULL) {
+    fprintf(stderr, "Cannot load %s: %s\n", path, dlerror());
+    return -1;
+  }
+  module->init = (PcdInit) dlsym(module->library, "pcdInit");
+  module->spam = (PcdSpam) dlsym(module->library, "pcdSpam");
+  module->free = (PcdFree) dlsym(module->library, "pcdFree");
+  if ((module->init == NULL) || (module->spam == NULL) || (module->free == NULL)) {
+    fprintf(stderr, "%s is not a PC-Detector module\n", path);
+    dlclose(module->library);
+    return -1;
+  }
+  return 1;
+}
+
+
+
+// Times count calls of the spam function while the spam threads contend a port
+int timeModule(NativeModule *module, int port, int count) {
+  struct timespec start, end;
+  switchPort(port);
+  module->spam(); // Warm up
+  for (int i = 0; i < count; i++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    module->spam();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double duration = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("%s%.6f", i == 0 ? "" : ", ", duration);
+  }
+  return 1;
+}
+
+
+
+int usage(char *name) {
+  printf("Usage: %s [-n count] [-c cpu] [-s cpus] [-p ports] [-r seed] module.so...\n", name);
+  printf("\t-n count\tTimings per port (default %i)\n", PCD_NATIVE_COUNT);
+  printf("\t-c cpu\t\tCPU of the timing thread, an SMT sibling of a spam thread (default %i, -1 finds it in the topology)\n", PCD_TIMER_CPU);
+  printf("\t-s cpus\t\tComma separated CPUs of the spam threads (default one per physical core)\n");
+  printf("\t-p ports\tComma separated ports to contend, idle for the control (default %s)\n", PCD_NATIVE_PORTS);
+  printf("\t-r seed\t\tSeed of the parameters of the spam functions (default 1)\n");
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  int count = PCD_NATIVE_COUNT;
+  int timerCpu = PCD_TIMER_CPU;
+  char portList[64] = PCD_NATIVE_PORTS;
+  char *cpuList = NULL;
+  unsigned int seed = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:c:s:p:r:h")) != -1) {
+    switch (opt) {
+      case 'n': count = atoi(optarg); break;
+      case 'c': timerCpu = atoi(optarg); break;
+      case 's': cpuList = optarg; break;
+      case 'p': snprintf(portList, sizeof(portList), "%s", optarg); break;
+      case 'r': seed = strtoul(optarg, NULL, 10); break;
+      default: return usage(argv[0]);
+    }
+  }
+  if ((count <= 0) || (optind == argc)) {
+    return usage(argv[0]);
+  }
+
+  int ports[8];
+  int portCount = 0;
+  for (char *name = strtok(portList, ","); name != NULL; name = strtok(NULL, ",")) {
+    int port = findPort(name);
+    if ((port == PCD_UNKNOWN) || (port == PCD_QUIT) || (portCount == 8)) {
+      fprintf(stderr, "Invalid port %s\n", name);
+      return usage(argv[0]);
+    }
+    ports[portCount++] = port;
+  }
+
+  int spamCpus[PCD_MAX_SPAM_THREADS];
+  int spamCount = 0;
+  if (cpuList == NULL) {
+    spamCount = coreSlots(spamCpus, PCD_MAX_SPAM_THREADS);
+  }
+  else {
+    for (char *cpu = strtok(cpuList, ","); (cpu != NULL) && (spamCount < PCD_MAX_SPAM_THREADS); cpu = strtok(NULL, ",")) {
+      spamCpus[spamCount++] = atoi(cpu);
+    }
+  }
+
+  if (timerCpu < 0) {
+    timerCpu = siblingCpu(spamCpus[0]);
+  }
+  if (timerCpu < 0) {
+    fprintf(stderr, "CPU %i has no SMT sibling for the timing thread, give one with -c\n", spamCpus[0]);
+    return 1;
+  }
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(timerCpu, &cpuset);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+    fprintf(stderr, "Warning: cannot pin the timing thread on CPU %i\n", timerCpu);
+  }
+  if (startSpamThreads(spamCpus, spamCount) != 1) {
+    return usage(argv[0]);
+  }
+
+  for (int m = optind; m < argc; m++) {
+    NativeModule module;
+    if ((loadModule(argv[m], &module) != 1) || (module.init(seed) != 1)) {
+      continue;
+    }
+    printf("{\"module\": \"%s\"", argv[m]);
+    for (int p = 0; p < portCount; p++) {
+      printf(", \"%s%s\": [", ports[p] == PCD_IDLE ? "control" : "p", ports[p] == PCD_IDLE ? "" : portName(ports[p]));
+      timeModule(&module, ports[p], count);
+      printf("]");
+    }
+    printf("}\n");
+    fflush(stdout);
+    switchPort(PCD_IDLE);
+    module.free();
+    dlclose(module.library);
+  }
+  stopSpamThreads();
+  return 0;
+}
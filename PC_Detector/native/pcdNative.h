@@ -0,0 +1,49 @@
+/*!
+   \file pcdNative.h
+   \brief Browserless backend of PC-Detector.
+          make native compiles each wasm spam module of wasm_generator.py to
+          native code with wabt's wasm2c, along with the host file
+          wasm_generator.py writes for it, into build/native/<module>.so.
+          pcd_native loads the modules and times their spam function on a
+          thread pinned on PCD_TIMER_CPU, while the spam threads of pcdSpam.c
+          contend each port, like testInstruction does in the browser.
+          A host file exports the functions below, under the same name in
+          every module.
+*/
+
+#ifndef PCDNATIVE_H
+#define PCDNATIVE_H
+
+#include "pcd.h"
+
+#define PCD_TIMER_CPU -1 // An SMT sibling of the first spam thread, -1 finds it in the topology
+#define PCD_NATIVE_COUNT 1000 // Timings per port, TEST_NUMBER of web/PCDetector.js
+#define PCD_NATIVE_PORTS "idle,0,1,23,5,6"
+
+
+
+/*!
+   \fn int pcdInit(unsigned int seed)
+   \brief Instantiates the module and draws the random parameters of its
+          spam function
+   \return 1 if ok, -1 otherwise
+*/
+typedef int (*PcdInit)(unsigned int seed);
+
+
+
+/*!
+   \fn void pcdSpam()
+   \brief Calls the spam function once
+*/
+typedef void (*PcdSpam)();
+
+
+
+/*!
+   \fn void pcdFree()
+   \brief Frees the instance of the module
+*/
+typedef void (*PcdFree)();
+
+#endif
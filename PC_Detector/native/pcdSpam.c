@@ -0,0 +1,148 @@
+/** This code is inspired by the code of Alday et al from https://github.com/bbbrumley/portsmash
+*
+*   Copyright 2018-2019 Alejandro Cabrera Aldaya, Billy Bob Brumley, Sohaib ul Hassan, Cesar Pereida García and Nicola Tuveri
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+**/
+#define _GNU_SOURCE
+#include "pcd.h"
+
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+
+typedef void (*SpamKernel)(uint64_t repetitions);
+
+// Ports and their spam loop
+static const struct {
+  const char *name;
+  SpamKernel spam;
+} ports[] = {
+  {"0", spam_port0_n}, {"1", spam_port1_n}, {"23", spam_port23_n}, {"5", spam_port5_n}, {"6", spam_port6_n}
+};
+#define PORT_COUNT (int) (sizeof(ports) / sizeof(ports[0]))
+
+static atomic_int targetPort = PCD_IDLE; // Index in ports, or PCD_IDLE/PCD_QUIT
+static atomic_uint generation; // Incremented for every command, futex word of the idle threads
+static atomic_uint acknowledged; // Threads running the last command, futex word of switchPort
+
+static pthread_t threads[PCD_MAX_SPAM_THREADS];
+static int spamThreadCount;
+
+
+
+static void futexWait(atomic_uint *word, unsigned int value) {
+  syscall(SYS_futex, (unsigned int *) word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void futexWake(atomic_uint *word) {
+  syscall(SYS_futex, (unsigned int *) word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+
+
+int findPort(const char *name) {
+  if (strcmp(name, "idle") == 0) return PCD_IDLE;
+  if (strcmp(name, "quit") == 0) return PCD_QUIT;
+  for (int p = 0; p < PORT_COUNT; p++) {
+    if (strcmp(name, ports[p].name) == 0) return p;
+  }
+  return PCD_UNKNOWN;
+}
+
+
+
+const char *portName(int port) {
+  if (port == PCD_IDLE) return "idle";
+  if (port == PCD_QUIT) return "quit";
+  return ((port >= 0) && (port < PORT_COUNT)) ? ports[port].name : NULL;
+}
+
+
+
+void *spamThread(void *vargp) {
+  unsigned int seen = 0;
+  int port = PCD_IDLE;
+  while (1) {
+    unsigned int current = atomic_load(&generation);
+    if (current != seen) {
+      // The port is written before the generation, and the next command
+      // waits for every thread to acknowledge this one
+      seen = current;
+      port = atomic_load(&targetPort);
+      if (atomic_fetch_add(&acknowledged, 1) == spamThreadCount - 1) {
+        futexWake(&acknowledged);
+      }
+      if (port == PCD_QUIT) {
+        return NULL;
+      }
+    }
+    if (port == PCD_IDLE) {
+      futexWait(&generation, seen);
+    }
+    else {
+      ports[port].spam(PCD_BURST);
+    }
+  }
+}
+
+
+
+long switchPort(int port) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  atomic_store(&acknowledged, 0);
+  atomic_store(&targetPort, port);
+  atomic_fetch_add(&generation, 1);
+  futexWake(&generation);
+  unsigned int count;
+  while ((count = atomic_load(&acknowledged)) < spamThreadCount) {
+    futexWait(&acknowledged, count);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return ((long) (end.tv_sec - start.tv_sec)) * 1000000000 + (end.tv_nsec - start.tv_nsec);
+}
+
+
+
+int startSpamThreads(const int *cpus, int count) {
+  if ((count <= 0) || (count > PCD_MAX_SPAM_THREADS)) {
+    return -1;
+  }
+  spamThreadCount = count;
+  cpu_set_t cpuset;
+  for (int threadNumber = 0; threadNumber < count; threadNumber++) {
+    pthread_create(&threads[threadNumber], NULL, spamThread, NULL);
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpus[threadNumber], &cpuset);
+    pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
+  }
+  switchPort(PCD_IDLE); // Every thread is up
+  return 1;
+}
+
+
+
+int stopSpamThreads() {
+  switchPort(PCD_QUIT);
+  for (int threadNumber = 0; threadNumber < spamThreadCount; threadNumber++) {
+    pthread_join(threads[threadNumber], NULL);
+  }
+  return 1;
+}
@@ -17,6 +17,7 @@
 #define _GNU_SOURCE
 #define _OPEN_THREADS
 #include "pcd_P0.h"
+#include "topology.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,15 +39,17 @@ void *spamPort0(void *vargp) {
 
 int multiThreadedSpamPort0() {
   cpu_set_t cpuset;
-  pthread_t threads[PHY_CORE];
+  int cpus[TOPOLOGY_MAX_CORES];
+  int threadCount = coreSlots(cpus, TOPOLOGY_MAX_CORES);
+  pthread_t threads[TOPOLOGY_MAX_CORES];
 
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+  for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
     pthread_create(&threads[threadNumber], NULL, spamPort0, NULL);
     CPU_ZERO(&cpuset);
-    CPU_SET(threadNumber, &cpuset);
+    CPU_SET(cpus[threadNumber], &cpuset);
     pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
   }
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+  for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
     pthread_join(threads[threadNumber], NULL);
   }
   return 1;
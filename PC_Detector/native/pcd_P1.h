@@ -18,7 +18,6 @@
 #define PCD_P1_H
 
 
-#define PHY_CORE 4
 #define SPY_NUM_TIMINGS (1<<16)
 
 #ifndef __ASSEMBLER__
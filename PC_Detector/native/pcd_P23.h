@@ -17,7 +17,6 @@
 #ifndef PCD_P23_H
 #define PCD_P23_H
 
-#define PHY_CORE 4
 #define SPY_NUM_TIMINGS (1<<16)
 
 #ifndef __ASSEMBLER__
@@ -16,7 +16,8 @@
 **/
 #define _GNU_SOURCE
 #define _OPEN_THREADS
-#include "pcd_P0.h"
+#include "pcd_P6.h"
+#include "topology.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -29,30 +30,32 @@
 
 
 
-void *spamPort0(void *vargp) {
+void *spamPort6(void *vargp) {
   while(1) {
-    spam_port0();
+    spam_port6();
   }
   return NULL;
 }
 
-int multiThreadedSpamPort0() {
+int multiThreadedSpamPort6() {
   cpu_set_t cpuset;
-  pthread_t threads[PHY_CORE];
+  int cpus[TOPOLOGY_MAX_CORES];
+  int threadCount = coreSlots(cpus, TOPOLOGY_MAX_CORES);
+  pthread_t threads[TOPOLOGY_MAX_CORES];
 
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
-    pthread_create(&threads[threadNumber], NULL, spamPort0, NULL);
+  for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
+    pthread_create(&threads[threadNumber], NULL, spamPort6, NULL);
     CPU_ZERO(&cpuset);
-    CPU_SET(threadNumber, &cpuset);
+    CPU_SET(cpus[threadNumber], &cpuset);
     pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
   }
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+  for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
     pthread_join(threads[threadNumber], NULL);
   }
   return 1;
 }
 
 int main() {
-  multiThreadedSpamPort0();
+  multiThreadedSpamPort6();
   return 1;
 }
@@ -14,15 +14,14 @@
 *   See the License for the specific language governing permissions and
 *   limitations under the License.
 **/
-#ifndef PCD_P0_H
-#define PCD_P0_H
+#ifndef PCD_P6_H
+#define PCD_P6_H
 
-#define PHY_CORE 4
 #define SPY_NUM_TIMINGS (1<<16)
 
 #ifndef __ASSEMBLER__
 #include <stdint.h>
-extern void spam_port0();
+extern void spam_port6();
 #endif
 
 #endif
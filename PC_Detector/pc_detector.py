@@ -14,12 +14,16 @@ from selenium.webdriver.firefox.firefox_binary import FirefoxBinary
 import plotly.graph_objects as go
 import subprocess
 import os
+import socket
+import ctypes
+import bisect
 import time
 import csv
 import math
 import json
 import statistics
 import sys
+import signal
 import argparse
 import numpy as np
 import instructions
@@ -28,6 +32,25 @@ import cpuinfo
 
 
 URL = "http://localhost:8000/PC_Detector/pc-detector.html"
+PCD_SOCKET = "pcd.sock" # Unix socket of the port spam daemon, see native/pcd.h
+METRICS_LIBRARY = "./build/libpcdmetrics.so" # Native metrics, see native/metrics.h
+TEST_NUMBER = 1000 # Number of test per setting per instruction, as in web/PCDetector.js
+NATIVE_DIR = "./build/native/" # Native versions of the wasm modules, see native/pcdNative.h
+CONTENTION_ERROR_RATE = 5 # Error rate between P1 and P5 under which an instruction creates contention
+
+# Sequential tests: timings are collected in batches until the verdict is settled
+SEQ_BATCH = 100 # Timings per port per round
+SEQ_MIN = 200 # Timings per port before any verdict
+SEQ_MAX = 4 * TEST_NUMBER # Budget of P1 and P5 for ambiguous instructions
+SEQ_ALPHA = 0.05 # Chance that a verdict stops on the wrong side, over all the looks at the timings
+SEQ_PRECISION = 0.01 # Relative half width of the mean of the other ports
+# Bonferroni bounds: each look of a setting spends SEQ_ALPHA / looks of its
+# budget, so the repeated looks keep the confidence of a single fixed-size test
+SEQ_VERDICT_LOOKS = (SEQ_MAX - SEQ_MIN) // SEQ_BATCH + 1
+SEQ_MEAN_LOOKS = (TEST_NUMBER - SEQ_MIN) // SEQ_BATCH + 1
+SEQ_Z_VERDICT = statistics.NormalDist().inv_cdf(1 - SEQ_ALPHA / (2 * SEQ_VERDICT_LOOKS))
+SEQ_Z_MEAN = statistics.NormalDist().inv_cdf(1 - SEQ_ALPHA / (2 * SEQ_MEAN_LOOKS))
+CONTENTION_D = 2 * statistics.NormalDist().inv_cdf(0.95) # Cohen's d of a 5% error rate between two normal distributions
 
 
 
@@ -37,6 +60,14 @@ caused by WebAssembly instructions.
 We use two main metrics:
  - Error rate: The percentage of error if we were to blindly ditinguish between two distributions.
  - Cohen's d: a statistical metric to measure the distance between two distributions.
+We also report the Kolmogorov-Smirnov statistic, the largest distance between
+the empirical CDFs of the two distributions.
+
+get_metrics computes them natively (native/metrics.c, built with make metrics)
+when the library is there, and falls back on the python functions below
+otherwise. The native error rate is exact: it tries every value of the
+distributions as a threshold instead of a grid of steps of 0.01, so it can be
+slightly lower than the python one.
 '''
 
 
@@ -123,8 +154,76 @@ def cohen_d(dist1, dist2):
 
 
 
-def get_metrics(D1, D2):
-    ''' Compute all metrics for two given distributions.
+def ks_statistic(dist1, dist2):
+    ''' Computes the Kolmogorov-Smirnov statistic of two distributions.
+
+    Parameters:
+    dist1(list[int]): distribution of timings.
+    dist2(list[int]): distribution of timings.
+
+    Returns:
+    float: The largest distance between the empirical CDFs.
+    '''
+    sorted1, sorted2 = sorted(dist1), sorted(dist2)
+    return max(abs(bisect.bisect_right(sorted1, value) / len(sorted1) - bisect.bisect_right(sorted2, value) / len(sorted2))
+               for value in sorted1 + sorted2)
+
+
+
+class PcdMetrics(ctypes.Structure):
+    ''' Output of computeMetrics, see native/metrics.h '''
+    _fields_ = [('errorRate', ctypes.c_double), ('threshold', ctypes.c_double),
+                ('cohenD', ctypes.c_double), ('ks', ctypes.c_double)]
+
+
+
+def load_native_metrics(path = METRICS_LIBRARY):
+    ''' Load the native metrics library.
+
+    Parameters:
+    path(string): Path of the shared library.
+
+    Returns:
+    ctypes.CDLL: The library, None if it was not built.
+    '''
+    try:
+        library = ctypes.CDLL(path)
+    except OSError:
+        return None
+    library.computeMetrics.argtypes = [ctypes.POINTER(ctypes.c_double), ctypes.c_size_t,
+                                       ctypes.POINTER(ctypes.c_double), ctypes.c_size_t, ctypes.POINTER(PcdMetrics)]
+    library.computeMetrics.restype = ctypes.c_int
+    return library
+
+NATIVE_METRICS = load_native_metrics()
+
+
+
+def native_metrics(D1, D2):
+    ''' Compute all metrics for two given distributions with the native library.
+
+    Parameters:
+    D1(list[int]): distribution of timings.
+    D2(list[int]): distribution of timings.
+
+    Returns:
+    dict: Object containing metrics about the two distributions.
+    '''
+    array1 = (ctypes.c_double * len(D1))(*D1)
+    array2 = (ctypes.c_double * len(D2))(*D2)
+    metrics = PcdMetrics()
+    if NATIVE_METRICS.computeMetrics(array1, len(D1), array2, len(D2), ctypes.byref(metrics)) != 1:
+        raise ValueError("Cannot compute the metrics of empty distributions")
+    return {
+        'error_rate': int(metrics.errorRate*100),
+        'cohen_d': metrics.cohenD,
+        'ks': metrics.ks,
+    }
+
+
+
+def python_metrics(D1, D2):
+    ''' Compute all metrics for two given distributions in python.
 
     Parameters:
     D1(list[int]): distribution of timings.
@@ -142,9 +241,55 @@ def get_metrics(D1, D2):
         'error_rate': er,
         # 'ratio': ratio,
         'cohen_d': cohend,
+        'ks': ks_statistic(D1, D2),
      }
 
 
+
+def get_metrics(D1, D2):
+    ''' Compute all metrics for two given distributions, natively if possible.
+
+    Parameters:
+    D1(list[int]): distribution of timings.
+    D2(list[int]): distribution of timings.
+
+    Returns:
+    dict: Object containing metrics about the two distributions.
+    '''
+    if NATIVE_METRICS is not None:
+        return native_metrics(D1, D2)
+    return python_metrics(D1, D2)
+
+
+
+def bench_metrics(json_file):
+    ''' Time the native and python metrics on the P1/P5 pairs of a result file,
+    and report the pairs they disagree on.
+
+    Parameters:
+    json_file(string): Path to the output of the test function.
+    '''
+    if NATIVE_METRICS is None:
+        print("No native metrics in {}, run make metrics first".format(METRICS_LIBRARY))
+        return
+    with open(json_file, 'r') as input:
+        data = json.load(input)
+    native_time, python_time = 0, 0
+    for experiment in data['data']:
+        start = time.perf_counter()
+        native = native_metrics(experiment['p1'], experiment['p5'])
+        native_time += time.perf_counter() - start
+        start = time.perf_counter()
+        reference = python_metrics(experiment['p1'], experiment['p5'])
+        python_time += time.perf_counter() - start
+        if (native['error_rate'] > reference['error_rate'] or abs(native['cohen_d'] - reference['cohen_d']) > 1e-9
+            or abs(native['ks'] - reference['ks']) > 1e-9):
+            print("{}: native {} \t python {}".format(experiment['instruction'], native, reference))
+    print("{} instructions: native {:.3f} s \t python {:.3f} s \t speedup {:.0f}x".format(
+        len(data['data']), native_time, python_time, python_time / max(native_time, 1e-9)))
+
+
+
 ##################################### TESTS ####################################
 
 def get_driver(browser_s):
@@ -172,91 +317,500 @@ def get_driver(browser_s):
 
 
 
-def test_instruction_port(instruction, port, driver):
+class PortSpammer:
+    ''' Handle to the native port spam daemon (./build/pcd).
+    The daemon keeps a spam thread pinned on each physical core for the whole
+    run, and switches the port they contend in a few microseconds, instead of
+    a process being started and killed for every port of every instruction.
+    '''
+
+    def __init__(self, socket_path = PCD_SOCKET):
+        ''' Start the daemon and connect to it.
+
+        Parameters:
+        socket_path(string): Path of the Unix socket of the daemon.
+        '''
+        self.daemon = subprocess.Popen(["./build/pcd", "-s", socket_path]) # Don't forget to make first
+        self.connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        for attempt in range(100): # The daemon creates the socket once its threads are up
+            try:
+                self.connection.connect(socket_path)
+                break
+            except (FileNotFoundError, ConnectionRefusedError):
+                time.sleep(0.01)
+        else:
+            self.daemon.terminate()
+            raise RuntimeError("Cannot connect to the port spam daemon on {}".format(socket_path))
+        self.stream = self.connection.makefile('rw')
+
+    def command(self, line):
+        ''' Send a command to the daemon and wait for its acknowledgement.
+
+        Parameters:
+        line(string): idle, quit or a port (0, 1, 23, 5 or 6).
+
+        Returns:
+        int: Time the threads took to switch, in ns.
+        '''
+        self.stream.write(line + '\n')
+        self.stream.flush()
+        answer = self.stream.readline().split()
+        if len(answer) != 2 or answer[0] != 'ok':
+            raise RuntimeError("The port spam daemon refused the command {}".format(line))
+        return int(answer[1])
+
+    def set_port(self, port):
+        ''' Contend a port, once this returns every spam thread runs on it.
+
+        Parameters:
+        port(int): Port to spam. Can be 0, 1, 23, 5, 6 or None to stop spamming.
+
+        Returns:
+        int: Time the threads took to switch, in ns.
+        '''
+        return self.command('idle' if port is None else str(port))
+
+    def close(self):
+        ''' Stop the spam threads and the daemon. '''
+        try:
+            self.command('quit')
+        finally:
+            self.connection.close()
+            self.daemon.wait()
+
+
+
+class Stress:
+    ''' Handle to stress workers pinned on some CPUs, by default the ones of
+    the spam threads (core_slots).
+    The workers are started once and paused between the timings that need
+    them, so a sequential test does not fork them again for every batch.
+    '''
+
+    def __init__(self, cpus = None):
+        ''' Start the workers, paused.
+
+        Parameters:
+        cpus(list[int]): CPUs of the workers, one each.
+        '''
+        cpus = core_slots() if cpus is None else cpus
+        # Own process group, so the signals reach the workers stress forks
+        self.process = subprocess.Popen(["taskset", "-c", ",".join([str(cpu) for cpu in cpus]), "stress", "-c", str(len(cpus))], start_new_session = True)
+        time.sleep(0.1) # Let stress fork its workers
+        self.pause()
+
+    def run(self):
+        ''' Resume the workers. '''
+        os.killpg(self.process.pid, signal.SIGCONT)
+
+    def pause(self):
+        ''' Stop the workers until run. '''
+        os.killpg(self.process.pid, signal.SIGSTOP)
+
+    def close(self):
+        ''' Kill the workers. '''
+        os.killpg(self.process.pid, signal.SIGKILL)
+        self.process.wait()
+
+
+
+def test_instruction_port(instruction, port, driver, spammer, count = TEST_NUMBER, stress = None):
     '''Run test for an instruction, while creating contention or not on a port.
 
     Parameters:
     instruction(str): tested instruction.
-    port(int): Port to spam. Can be 1, 5 or None for control experiment.
+    port(int): Port to spam. Can be 0, 1, 23, 5, 6, 'stress' or None for control experiment.
     driver(selenium.webdriver): A handle to the tested browser.
+    spammer(PortSpammer): A handle to the port spam daemon.
+    count(int): Number of timings.
+    stress(Stress): Workers of the stress port, started for this test only if None.
 
     Returns:
     list[int]: Timings of the experiment.
     '''
-    if (port == 0):
-        native_spam = subprocess.Popen(["./build/pcd_P0"]) # Don't forget to make first
-    elif (port == 1):
-        native_spam = subprocess.Popen(["./build/pcd_P1"])
-    elif (port == 23):
-        native_spam = subprocess.Popen(["./build/pcd_P23"])
-    elif (port == 5):
-        native_spam = subprocess.Popen(["./build/pcd_P5"])
-    elif (port == 6):
-        native_spam = subprocess.Popen(["./build/pcd_P6"])
-    elif (port == 'stress'):
-        native_spam = subprocess.Popen(["taskset", "-c", "0-3", "stress", "-c", "4"])
-    time.sleep(1)
+    if (port == 'stress'):
+        spammer.set_port(None)
+        workers = Stress() if stress is None else stress
+        workers.run()
+    else:
+        spammer.set_port(port) # Returns once every thread spams the port
     try:
         if instruction in instructions.PUNOP: #Difference in quotes, maybe i should unify it.
-            mean_timings = driver.execute_script("""return testInstruction({})""".format(instruction))
+            mean_timings = driver.execute_script("""return testInstruction({}, {})""".format(instruction, count))
         else:
-            mean_timings = driver.execute_script("""return testInstruction("{}")""".format(instruction))
+            mean_timings = driver.execute_script("""return testInstruction("{}", {})""".format(instruction, count))
     finally:
         if port == 'stress':
-            subprocess.Popen(["pkill","stress"])
-        elif port != None:
-            native_spam.terminate() #Kill the native process
+            if stress is None:
+                workers.close()
+            else:
+                workers.pause()
+        else:
+            spammer.set_port(None)
 
     return mean_timings
 
 
 
-def test_instruction(instruction, driver):
+def test_instruction(instruction, driver, spammer):
     ''' Test all ports for an instruction and compute metrics.
 
     Parameters:
     instruction(string): Name of the tested instrucionts.
     driver(selenium.webdriver): A handle to the tested browser.
+    spammer(PortSpammer): A handle to the port spam daemon.
 
     Returns:
     dict: A dict containing all timings and metrics.
     '''
     results = {}
     results['instruction'] = instruction
-    results['control'] = test_instruction_port(instruction, None, driver)
-    results['p0'] = test_instruction_port(instruction, 0, driver)
-    results['p1'] = test_instruction_port(instruction, 1, driver)
-    results['p23'] = test_instruction_port(instruction, 23, driver)
-    results['p5'] = test_instruction_port(instruction, 5, driver)
-    results['p6'] = test_instruction_port(instruction, 6, driver)
-    results['stress'] = test_instruction_port(instruction, 'stress', driver)
+    results['control'] = test_instruction_port(instruction, None, driver, spammer)
+    results['p0'] = test_instruction_port(instruction, 0, driver, spammer)
+    results['p1'] = test_instruction_port(instruction, 1, driver, spammer)
+    results['p23'] = test_instruction_port(instruction, 23, driver, spammer)
+    results['p5'] = test_instruction_port(instruction, 5, driver, spammer)
+    results['p6'] = test_instruction_port(instruction, 6, driver, spammer)
+    results['stress'] = test_instruction_port(instruction, 'stress', driver, spammer)
+    results['metrics'] = get_metrics(results['p1'], results['p5'])
+    return results
+
+
+
+def contention_settled(p1_timings, p5_timings):
+    ''' Check whether the P1/P5 verdict of an instruction is settled.
+    The verdict is settled when the confidence interval of Cohen's d is
+    entirely above or below CONTENTION_D, the effect size of the 5% error rate
+    find_pc reports contention under (for normal distributions). The interval
+    is the Bonferroni one of SEQ_VERDICT_LOOKS looks (SEQ_Z_VERDICT), so that
+    stopping at the first settled look still errs with SEQ_ALPHA at most.
+
+    Parameters:
+    p1_timings(list[int]): Timings under P1 contention.
+    p5_timings(list[int]): Timings under P5 contention.
+
+    Returns:
+    bool: True if more timings would not change the verdict.
+    '''
+    n1, n2 = len(p1_timings), len(p5_timings)
+    d = get_metrics(p1_timings, p5_timings)['cohen_d']
+    half_width = SEQ_Z_VERDICT * math.sqrt((n1 + n2) / (n1 * n2) + d ** 2 / (2 * (n1 + n2)))
+    return d - half_width > CONTENTION_D or d + half_width < CONTENTION_D
+
+
+
+def mean_settled(timings):
+    ''' Check whether the mean of timings is known within SEQ_PRECISION.
+
+    Parameters:
+    timings(list[int]): Timings of a port.
+
+    Returns:
+    bool: True if the confidence interval of the mean, Bonferroni over the
+    SEQ_MEAN_LOOKS looks, is narrow enough.
+    '''
+    return SEQ_Z_MEAN * statistics.stdev(timings) / math.sqrt(len(timings)) <= SEQ_PRECISION * abs(statistics.mean(timings))
+
+
+
+def test_instruction_sequential(instruction, driver, spammer):
+    ''' Test all ports for an instruction, with as few timings as needed.
+    Ports are timed in rounds of SEQ_BATCH timings. After SEQ_MIN timings, P1
+    and P5 stop once the verdict is settled (contention_settled), or after
+    SEQ_MAX timings for ambiguous instructions. The other ports only serve the
+    plots: they stop once their mean is precise (mean_settled), or after
+    TEST_NUMBER timings.
+
+    Parameters:
+    instruction(string): Name of the tested instrucionts.
+    driver(selenium.webdriver): A handle to the tested browser.
+    spammer(PortSpammer): A handle to the port spam daemon.
+
+    Returns:
+    dict: A dict containing all timings and metrics, as test_instruction.
+    '''
+    ports = {'control': None, 'p0': 0, 'p1': 1, 'p23': 23, 'p5': 5, 'p6': 6, 'stress': 'stress'}
+    results = {name: [] for name in ports}
+    results['instruction'] = instruction
+    active = list(ports)
+    stress = Stress() # Paused between the batches of the stress port
+    try:
+        while active:
+            for name in active: # Interleaved, so a drift of the timings hits every port alike
+                results[name] += test_instruction_port(instruction, ports[name], driver, spammer, SEQ_BATCH, stress)
+            settled = []
+            for name in active:
+                count = len(results[name])
+                if count < SEQ_MIN:
+                    continue
+                if name in ['p1', 'p5']:
+                    if count >= SEQ_MAX or contention_settled(results['p1'], results['p5']):
+                        settled.append(name)
+                elif count >= TEST_NUMBER or mean_settled(results[name]):
+                    settled.append(name)
+            if 'stress' in settled:
+                stress.close()
+                stress = None
+            active = [name for name in active if name not in settled]
+    finally:
+        if stress is not None:
+            stress.close()
     results['metrics'] = get_metrics(results['p1'], results['p5'])
+    results['samples'] = {name: len(results[name]) for name in ports}
+    return results
+
+
+
+def native_module(instruction):
+    ''' Path of the native version of the wasm module of an instruction.
+
+    Parameters:
+    instruction(string): Name of the instruction, or pair of instructions for a PUNOP.
+
+    Returns:
+    string: Path of the shared library built by make native.
+    '''
+    if isinstance(instruction, list):
+        return "{}{}_{}_spam.so".format(NATIVE_DIR, instruction[0], instruction[1])
+    return "{}{}_spam.so".format(NATIVE_DIR, instruction)
+
+
+
+def cpu_list(text):
+    ''' Parse a list of logical CPUs of sysfs, e.g. 0,4 or 0-7.
+
+    Parameters:
+    text(string): The content of the sysfs file.
+
+    Returns:
+    list[int]: The logical CPUs.
+    '''
+    cpus = []
+    for part in text.strip().split(','):
+        if part:
+            bounds = part.split('-')
+            cpus += range(int(bounds[0]), int(bounds[-1]) + 1)
+    return cpus
+
+
+
+def sibling_lists():
+    ''' Read the SMT siblings of every online logical CPU in sysfs, as the
+    topology module of shared/native does. TOPOLOGY_ROOT replaces
+    /sys/devices/system/cpu, e.g. with a fake tree.
+
+    Returns:
+    list[list[int]]: The siblings of each physical core, one list per core.
+    '''
+    cores = set()
+    cpu_dir = os.environ.get("TOPOLOGY_ROOT", "/sys/devices/system/cpu")
+    online_file = "{}/online".format(cpu_dir)
+    if os.path.isfile(online_file):
+        with open(online_file, 'r') as input:
+            online = cpu_list(input.read())
+    else: # The logical CPUs of the cpu<n> folders
+        online = [int(cpu[3:]) for cpu in os.listdir(cpu_dir) if re.fullmatch("cpu[0-9]+", cpu)]
+    for cpu in online:
+        siblings_file = "{}/cpu{}/topology/thread_siblings_list".format(cpu_dir, cpu)
+        if os.path.isfile(siblings_file):
+            with open(siblings_file, 'r') as input:
+                cores.add(tuple(cpu_list(input.read())))
+        else: # Without topology, each CPU is its own core
+            cores.add((cpu,))
+    return sorted([list(siblings) for siblings in cores])
+
+
+
+def smt_pairs():
+    ''' Find the pairs of SMT siblings, one per physical core, in sysfs.
+
+    Returns:
+    list[tuple[int]]: The two first logical CPUs of each physical core with SMT.
+    '''
+    return [(siblings[0], siblings[1]) for siblings in sibling_lists() if len(siblings) >= 2]
+
+
+
+def core_slots():
+    ''' Find one logical CPU per physical core, where the spam threads run.
+
+    Returns:
+    list[int]: The first SMT sibling of each physical core, [0] without sysfs.
+    '''
+    try:
+        slots = [siblings[0] for siblings in sibling_lists()]
+    except OSError:
+        slots = []
+    return slots if slots else [0]
+
+
+
+def start_native(modules, ports, pair = None):
+    ''' Start timing native modules with pcd_native.
+
+    Parameters:
+    modules(list[string]): Paths of the modules.
+    ports(string): Comma separated ports to contend, idle for the control.
+    pair(tuple[int]): SMT siblings of the timing thread and of the single spam
+    thread. By default, the spam threads run on every physical core.
+
+    Returns:
+    subprocess.Popen: The pcd_native process, see read_native.
+    '''
+    command = ["./build/pcd_native", "-n", str(TEST_NUMBER), "-p", ports]
+    if pair is not None:
+        command += ["-c", str(pair[0]), "-s", str(pair[1])]
+    return subprocess.Popen(command + modules, stdout=subprocess.PIPE, universal_newlines=True)
+
+
+
+def read_native(process):
+    ''' Wait for a pcd_native process and read its timings.
+
+    Parameters:
+    process(subprocess.Popen): The process of start_native.
+
+    Returns:
+    dict: The timings of each port of each module, by module path.
+    '''
+    output = process.communicate()[0]
+    timings = {}
+    for line in output.splitlines():
+        module = json.loads(line)
+        timings[module.pop('module')] = module
+    return timings
+
+
+
+def run_native(modules, ports, pairs = []):
+    ''' Time native modules with pcd_native, split among core pairs.
+    Port contention stays in a physical core, so each pair times its share of
+    the modules while its own spam thread contends its sibling, concurrently
+    with the other pairs.
+
+    Parameters:
+    modules(list[string]): Paths of the modules.
+    ports(string): Comma separated ports to contend, idle for the control.
+    pairs(list[tuple[int]]): SMT siblings to run on, see smt_pairs. If empty,
+    a single process times every module, with spam threads on every physical core.
+
+    Returns:
+    dict: The timings of each port of each module, by module path.
+    '''
+    if not pairs:
+        return read_native(start_native(modules, ports))
+    processes = [start_native(modules[k::len(pairs)], ports, pair) for k, pair in enumerate(pairs) if modules[k::len(pairs)]]
+    timings = {}
+    for process in processes:
+        timings.update(read_native(process))
+    return timings
+
+
+
+def test_native(instruction_list, pairs = []):
+    ''' Test instructions without a browser, on the native version of their
+    wasm module (make native). The timings have the format of test_instruction.
+    Headless, and in parallel on several physical cores, it screens all
+    instructions in minutes.
+    Candidates can then be confirmed in the browser (see contention_candidates).
+
+    Parameters:
+    instruction_list(list[string]): Tested instructions.
+    pairs(list[tuple[int]]): SMT siblings to test instructions on in parallel, see run_native.
+
+    Returns:
+    list[dict]: The result of each instruction with a native module.
+    '''
+    modules = [native_module(instruction) for instruction in instruction_list]
+    missing = [module for module in modules if not os.path.isfile(module)]
+    if missing:
+        print("{} instructions have no native module, run make native first".format(len(missing)))
+    modules = [module for module in modules if module not in missing]
+    timings = run_native(modules, "idle,0,1,23,5,6", pairs)
+    # Stress the siblings the spam threads would run on
+    stress = Stress([pair[1] for pair in pairs] if pairs else None)
+    stress.run()
+    try:
+        stress_timings = run_native(modules, "idle", pairs)
+    finally:
+        stress.close()
+    results = []
+    for instruction in instruction_list:
+        module = native_module(instruction)
+        if module not in timings:
+            continue
+        res_instr = {'instruction': instruction}
+        res_instr.update(timings[module])
+        res_instr['stress'] = stress_timings[module]['control']
+        res_instr['metrics'] = get_metrics(res_instr['p1'], res_instr['p5'])
+        results.append(res_instr)
     return results
 
 
 
-def pc_tester(browser='firefox', output_file = ""):
+def contention_candidates(json_file):
+    ''' List the instructions a result file suspects of contention, e.g. to
+    confirm the results of the native backend in a browser.
+
+    Parameters:
+    json_file(string): Path to the output of the test function.
+
+    Returns:
+    list[string]: The instructions with a P1/P5 error rate under CONTENTION_ERROR_RATE.
+    '''
+    with open(json_file, 'r') as input:
+        data = json.load(input)
+    return [experiment['instruction'] for experiment in data['data']
+            if get_metrics(experiment['p1'], experiment['p5'])['error_rate'] < CONTENTION_ERROR_RATE]
+
+
+
+def pc_tester(browser='firefox', output_file = "", sequential = False, candidates = "", jobs = 1):
     ''' Main function of PC-Detector.
     It handles all the test for all instructions and output the result in a json file.
 
     Parameters:
-    browser(string): The name of the browser. Either firefox or chrome.
+    browser(string): The name of the browser. Either firefox, chrome, or native for the browserless backend.
     output_file(string): Name of the json output file. By default it contains the tested browser and cpu.
+    sequential(bool): Stop timing each port once its verdict is settled (see test_instruction_sequential).
+    candidates(string): Only test the instructions suspected of contention in this result file. By default all instructions are tested.
+    jobs(int): With the native backend, number of physical cores testing instructions in parallel, 0 for all of them.
     '''
+    instruction_list = instructions.ALLOP
+    if candidates != "":
+        instruction_list = contention_candidates(candidates)
     results = {}
     cpu_re = re.search("i[0-9]-[0-9]{4}[A-Z]", cpuinfo.get_cpu_info()['brand_raw']) #Hope it works well i am bad at regex :(
     cpu_s = cpu_re.group()
     results['browser'] = browser
     results['cpu'] = cpu_s
     results['data'] = []
+    if browser == 'native':
+        pairs = []
+        if jobs != 1:
+            pairs = smt_pairs()
+            if jobs > 0:
+                pairs = pairs[:jobs]
+            print("Testing on {} physical cores in parallel: {}".format(len(pairs), pairs))
+        results['data'] = test_native(instruction_list, pairs)
+        instruction_list = []
     counter = 1
-    for instruction in instructions.ALLOP:
-        print("{}/{} - {}%: Testing {}; ".format(counter,len(instructions.ALLOP), math.floor(counter/len(instructions.ALLOP)*100), instruction))
-        driver = get_driver(browser)
-        res_instr = test_instruction(instruction,driver)
-        driver.close()
-        results['data'].append(res_instr)
-        counter+=1
+    spammer = PortSpammer() if instruction_list else None
+    try:
+        for instruction in instruction_list:
+            print("{}/{} - {}%: Testing {}; ".format(counter,len(instruction_list), math.floor(counter/len(instruction_list)*100), instruction))
+            driver = get_driver(browser)
+            if sequential:
+                res_instr = test_instruction_sequential(instruction,driver,spammer)
+                print("\tTimings per port: {}".format(res_instr['samples']))
+            else:
+                res_instr = test_instruction(instruction,driver,spammer)
+            driver.close()
+            results['data'].append(res_instr)
+            counter+=1
+    finally:
+        if spammer is not None:
+            spammer.close()
     if output_file == "":
         output_file = "pcd_{}_{}.json".format(browser, cpu_s)
     with open(output_file, 'w') as file:
@@ -287,7 +841,7 @@ def find_pc(json_file):
             pc = "P1"
         else:
             pc = P5
-        if stats['error_rate'] < 5:
+        if stats['error_rate'] < CONTENTION_ERROR_RATE:
             print("{}: Suspected contention: {} \t Error rate: {} \t Cohen's d: {}".format(instruction, pc,  stats['error_rate'], stats['cohen_d']))
 
 
@@ -344,10 +898,14 @@ def plot_hist(json_file):
 
 def parse_arguments():
     parser = argparse.ArgumentParser()
-    parser.add_argument('-b', '--browser', help=' Select evaluated browser. Can be firefox, chrome or safari. Default is firefox', type=str, default='firefox', choices = ['chrome', 'firefox', 'safari'])
+    parser.add_argument('-b', '--browser', help=' Select evaluated browser. Can be firefox, chrome, safari or native for the browserless backend. Default is firefox', type=str, default='firefox', choices = ['chrome', 'firefox', 'safari', 'native'])
     parser.add_argument('-p', '--plot', help='Plot all graphs in the output file. Default is false', action='store_true',default=False)
     parser.add_argument('-t', '--test', help='Test all supported instructions and outputs result in the output file. Default is false', action='store_true',default=False)
     parser.add_argument('-s', '--stats', help='Print stats about instructions causing port contention. Default is false', action='store_true',default=False)
+    parser.add_argument('-q', '--sequential', help='With -t, stop timing a port as soon as its verdict is settled. Default is false', action='store_true',default=False)
+    parser.add_argument('-c', '--candidates', help='With -t, only test the instructions suspected of contention in this json file, e.g. the output of -b native', type=str, default="")
+    parser.add_argument('-j', '--jobs', help='With -b native, number of physical cores testing instructions in parallel, 0 for all of them. Default is 1', type=int, default=1)
+    parser.add_argument('-m', '--bench-metrics', help='Time the native and python metrics on the output file. Default is false', action='store_true',default=False)
     parser.add_argument('-o', '--output', help='Json output file, default is ./results.json',type = str, default = "")
     args = parser.parse_args()
     return args
@@ -367,10 +925,12 @@ if __name__ == '__main__':
         cpu_s = cpu_re.group()
         output_file = "pcd_{}_{}.json".format(args.browser, cpu_s)
     if args.test:
-        pc_tester(browser, output_file)
+        pc_tester(browser, output_file, args.sequential, args.candidates, args.jobs)
     if args.plot:
         plot_hist(output_file)
     if args.stats:
         find_pc(output_file)
-    if not (args.test or args.plot or args.stats):
+    if args.bench_metrics:
+        bench_metrics(output_file)
+    if not (args.test or args.plot or args.stats or args.bench_metrics):
         print("No action selected, use -t to run tests and/or -p to plot results")
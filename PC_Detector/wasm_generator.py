@@ -8,7 +8,8 @@ in most tools of this project.
 Keep in mind this only creates the file, not build them.
 To build them, you can use the make tool.
 
-All the created wat files are stored in the wasm folder.
+All the created wat files are stored in the wasm folder, along with the host
+files of their native version (see native/pcdNative.h).
 
 '''
 import instructions
@@ -232,12 +233,95 @@ def create_spam_files(lines):
 
 
 
+################################# NATIVE HOSTS #################################
+''' These functions create the host files of the browserless backend of
+PC-Detector (see native/pcdNative.h).
+make native compiles each wasm module to C with wasm2c, under the module name
+spam, and links it with its host file. The host file instantiates the module,
+draws the random parameters of the spam function like web/PCDetector.js, and
+exports it to pcd_native.
+'''
+
+# Expression of a random parameter of each wasm type, as drawn by web/PCDetector.js
+RANDOM_PARAM = {
+    'i8': '(u32) (rand() % (1 << 7))',
+    'i16': '(u32) (rand() % (1 << 15))',
+    'i32': '(u32) rand()',
+    'i64': '((u64) rand() << 32) | (u64) rand()',
+    'f32': '(f32) (rand() % (1 << 30))',
+    'f64': '(f64) (rand() % (1 << 30))',
+}
+
+# Type of wasm2c of each wasm type
+C_TYPE = {'i8': 'u32', 'i16': 'u32', 'i32': 'u32', 'i64': 'u64', 'f32': 'f32', 'f64': 'f64'}
+
+
+def spam_signature(instruction):
+    ''' Find the parameters of the spam function of an instruction, as written
+    by the functions above.
+
+    Parameters:
+    instruction(str): Name of the instruction, or pair of instructions for a PUNOP.
+
+    Returns:
+    list[str]: The wasm type of each parameter. The result has the type of the last.
+    '''
+    if isinstance(instruction, list):
+        return [instruction[1][:3]]
+    if instruction in instructions.VOP:
+        if instruction[0] == 'v':
+            return ['i64'] * 2
+        (num_type, param_count) = parse_vshape(instruction[:5])
+        return [num_type] * int(param_count)
+    return [instruction[:3]]
+
+
+def host_code(instruction, module):
+    ''' Creates a string containing the host file of a wasm2c module.
+
+    Parameters:
+    instruction(str): Name of the instruction, or pair of instructions for a PUNOP.
+    module(str): Name of the module, e.g. i64.ctz_spam.
+
+    Returns:
+    string: The code to dump in the host file.
+    '''
+    params = spam_signature(instruction)
+    result = C_TYPE[params[-1]]
+    code = "// Generated by wasm_generator.py, do not edit\n\n"
+    code += "#include <stdlib.h>\n#include \"pcdNative.h\"\n#include \"{}.h\"\n\n".format(module)
+    code += "static w2c_spam instance;\n"
+    for k, type in enumerate(params):
+        code += "static {} p{};\n".format(C_TYPE[type], k)
+    code += "static volatile {} sink; // Keeps the result alive\n\n".format(result)
+    code += "int pcdInit(unsigned int seed) {\n\tsrand(seed);\n"
+    for k, type in enumerate(params):
+        code += "\tp{} = {};\n".format(k, RANDOM_PARAM[type])
+    code += "\twasm_rt_init();\n\twasm2c_spam_instantiate(&instance);\n\treturn 1;\n}\n\n"
+    code += "void pcdSpam() {\n\tsink = w2c_spam_spam(&instance, "
+    code += ", ".join(["p{}".format(k) for k in range(len(params))]) + ");\n}\n\n"
+    code += "void pcdFree() {\n\twasm2c_spam_free(&instance);\n\twasm_rt_free();\n}\n"
+    return code
+
+
+def create_host_files():
+    ''' Create the host files of all instructions with a wat file '''
+    for instruction in instructions.UNOP + instructions.BINOP + instructions.PUNOP + instructions.VOP:
+        if isinstance(instruction, list):
+            module = "{}_{}_spam".format(instruction[0], instruction[1])
+        else:
+            module = "{}_spam".format(instruction)
+        create_file(host_code(instruction, module), "{}{}_host.c".format(SRCDIR, module))
+
+
+
 ##################################### MAIN #####################################
 
 def wasm_generator(lines = 1000000,):
     if not os.path.isdir("./wasm"):
         os.mkdir("./wasm")
     create_spam_files(lines)
+    create_host_files()
 
 
 def parse_arguments():
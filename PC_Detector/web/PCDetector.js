@@ -7,6 +7,7 @@
 
 
 const TEST_NUMBER = 1000 // Number of test per setting per instruction
+const spamCache = new Map(); // Spam function and parameter of each instruction, see initInstruction
 
 
 /* --------------------------------------------------------------------------
@@ -106,20 +107,22 @@ async function initMemopSpam(instruction) {
 
 
 /**
- * testInstruction - Time the execution of a function repeatedly calling an
- * instruction.
- *
- * This is the main function of the web-component of PC-Detector.
- * By calling it in the different setting (P1 contention, p5 contention or control),
- * we can determine if the tested isntruciton creates contention.
+ * initInstruction - Instantiate the spam function of an instruction and draw
+ * its random parameter.
+ * They are cached, so the batches of a sequential test (see pc_detector.py)
+ * time the same function with the same parameter, without instantiating it
+ * again for every batch.
  *
  * This is an async function. Use it with await.
  *
  * @param  {String} instruction The name of the tested instruction.
- * @return {Array[Number]}      All the timings of the experiment.
+ * @return {Object}             The spam function and its parameter.
  */
-async function testInstruction(instruction) {
-
+async function initInstruction(instruction) {
+  const key = String(instruction);
+  if (spamCache.has(key)) {
+    return spamCache.get(key);
+  }
   // First, we instantiate the spam function, i.e the function repeatedly
   // calling our instruction
   if ((UNOP.includes(instruction)) || (BINOP.includes(instruction)))  {
@@ -208,6 +211,30 @@ async function testInstruction(instruction) {
     }
   }
 
+  const initialized = {spam: spam, param: param};
+  spamCache.set(key, initialized);
+  return initialized;
+}
+
+
+
+/**
+ * testInstruction - Time the execution of a function repeatedly calling an
+ * instruction.
+ *
+ * This is the main function of the web-component of PC-Detector.
+ * By calling it in the different setting (P1 contention, p5 contention or control),
+ * we can determine if the tested isntruciton creates contention.
+ *
+ * This is an async function. Use it with await.
+ *
+ * @param  {String} instruction The name of the tested instruction.
+ * @param  {Number} count       Number of timings, TEST_NUMBER by default.
+ * @return {Array[Number]}      All the timings of the experiment.
+ */
+async function testInstruction(instruction, count = TEST_NUMBER) {
+  var {spam, param} = await initInstruction(instruction);
+
   var timings = [];
   var start, end;
   /*
@@ -223,7 +250,7 @@ async function testInstruction(instruction) {
   * on Chrome, it is highly sufficient to measure the differences in this case.
   */
   if (VOP.includes(instruction)) {
-    for (var i = 0; i < TEST_NUMBER; i++ ) {
+    for (var i = 0; i < count; i++ ) {
       start = performance.now();
       spam(...param);
       end = performance.now();
@@ -231,7 +258,7 @@ async function testInstruction(instruction) {
     }
   }
   else {
-    for (var i = 0; i < TEST_NUMBER; i++ ) {
+    for (var i = 0; i < count; i++ ) {
       start = performance.now();
       spam(param);
       end = performance.now();
@@ -3,6 +3,7 @@
 #include "toy_example.h"
 #include "p1_spam.h"
 #include "p5_spam.h"
+#include "topology.h"
 
 
 #include <stdio.h>
@@ -35,28 +36,32 @@ int toyExample(int bit) {
   // while(1) {spam_port1();}
   if (bit == 0) {
     cpu_set_t cpuset;
-    pthread_t threads[PHY_CORE];
+    int cpus[TOPOLOGY_MAX_CORES];
+    int threadCount = coreSlots(cpus, TOPOLOGY_MAX_CORES);
+    pthread_t threads[TOPOLOGY_MAX_CORES];
 
-    for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+    for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
       pthread_create(&threads[threadNumber], NULL, spamPort1Wrapper, NULL);
       CPU_ZERO(&cpuset);
-      CPU_SET(threadNumber, &cpuset);
+      CPU_SET(cpus[threadNumber], &cpuset);
       pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
     }
-    for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+    for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
       pthread_join(threads[threadNumber], NULL);
     }
   }
   else if (bit == 1) {
     cpu_set_t cpuset;
-    pthread_t threads[PHY_CORE];
-    for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+    int cpus[TOPOLOGY_MAX_CORES];
+    int threadCount = coreSlots(cpus, TOPOLOGY_MAX_CORES);
+    pthread_t threads[TOPOLOGY_MAX_CORES];
+    for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
       pthread_create(&threads[threadNumber], NULL, spamPort5Wrapper, NULL);
       CPU_ZERO(&cpuset);
-      CPU_SET(threadNumber, &cpuset);
+      CPU_SET(cpus[threadNumber], &cpuset);
       pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
     }
-    for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
+    for (int threadNumber = 0; threadNumber < threadCount; threadNumber++) {
       pthread_join(threads[threadNumber], NULL);
     }
   }
@@ -2,8 +2,6 @@
 #define TOY_EXAMPLE_H
 
 
-#define PHY_CORE 4
-
 #define SPY_NUM_TIMINGS (1<<9) //Size of event to detect modify this 
 
 
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+
+
+''' This module generates the family of native contention and timing kernels,
+and the table the registry of native/kernelRegistry.h dispatches on.
+The Makefile runs it before building the binaries that use the registry.
+
+Every kernel is a loop of repetitions. A repetition is `unroll` times the
+instruction on each of its independent chains, between two lfence, exactly
+like spam_port1 and read_timings:
+ - kernel_<instruction>_u<unroll>_spam(repetitions) contends the ports of the
+   instruction for the given number of repetitions.
+ - kernel_<instruction>_u<unroll>_time(buffer, passCount) times passCount
+   repetitions, and writes one word per repetition in buffer: the start TSC in
+   the low 32 bits, the end TSC in the high 32 bits.
+
+The generated files are stored in the build folder.
+'''
+import argparse
+import os
+
+
+OBJDIR = './build/'
+
+# Instructions of the kernels: the ports they contend (on Intel cores since
+# Skylake), the CPU feature they need (a name of __builtin_cpu_supports), and
+# one instruction per independent dependency chain
+INSTRUCTIONS = {
+    'crc32': {'ports': '1', 'feature': 'sse4.2', 'chains': ['crc32 %r8, %r8', 'crc32 %r9, %r9', 'crc32 %r10, %r10']},
+    'popcnt': {'ports': '1', 'feature': 'popcnt', 'chains': ['popcnt %r8, %r8', 'popcnt %r9, %r9', 'popcnt %r10, %r10']},
+    'imul': {'ports': '1', 'feature': None, 'chains': ['imul %r8, %r8', 'imul %r9, %r9', 'imul %r10, %r10']},
+    'aesimc': {'ports': '0', 'feature': 'aes', 'chains': ['aesimc %xmm0, %xmm1', 'aesimc %xmm2, %xmm3', 'aesimc %xmm4, %xmm5']},
+    'vpermd': {'ports': '5', 'feature': 'avx2', 'chains': ['vpermd %ymm0, %ymm1, %ymm0', 'vpermd %ymm2, %ymm3, %ymm2', 'vpermd %ymm4, %ymm5, %ymm4']},
+    'load': {'ports': '23', 'feature': None, 'chains': ['mov (%rsp), %r8', 'mov (%rsp), %r9', 'mov (%rsp), %r10']},
+    'jmp': {'ports': '6', 'feature': None, 'chains': ['jmp 2f\n2:', 'jmp 3f\n3:', 'jmp 4f\n4:']},
+}
+
+FEATURES = {None: 'KERNEL_FEATURE_NONE', 'sse4.2': 'KERNEL_FEATURE_SSE42', 'popcnt': 'KERNEL_FEATURE_POPCNT',
+            'aes': 'KERNEL_FEATURE_AES', 'avx2': 'KERNEL_FEATURE_AVX2'}
+
+UNROLLS = [16, 48, 96]
+REFERENCE_UNROLL = 48 # Of spam_port1 and read_timings
+
+
+
+def kernel_name(instruction, unroll):
+    return '{}_u{}'.format(instruction, unroll)
+
+
+def write_body(file, instruction, unroll):
+    ''' Writes a repetition: the chains of the instruction, unrolled '''
+    file.write('lfence\n')
+    file.write('.rept {}\n'.format(unroll))
+    for chain in INSTRUCTIONS[instruction]['chains']:
+        file.write(chain + '\n')
+    file.write('.endr\n')
+
+
+def write_spam(file, instruction, unroll):
+    ''' Writes the contention kernel, a copy of spam_port1_n '''
+    symbol = 'kernel_{}_spam'.format(kernel_name(instruction, unroll))
+    file.write('.global {}\n.p2align 4\n{}:\n'.format(symbol, symbol))
+    file.write('mov %rdi, %rcx\n\n.p2align 4\n1:\n')
+    write_body(file, instruction, unroll)
+    file.write('lfence\ndec %rcx\njnz 1b\n')
+    if INSTRUCTIONS[instruction]['feature'] == 'avx2':
+        file.write('vzeroupper\n')
+    file.write('ret\n\n')
+
+
+def write_time(file, instruction, unroll):
+    ''' Writes the timing kernel, a copy of read_timings_n '''
+    symbol = 'kernel_{}_time'.format(kernel_name(instruction, unroll))
+    file.write('.global {}\n.p2align 4\n{}:\n'.format(symbol, symbol))
+    file.write('mov %rsi, %rcx\n\n.p2align 4\n1:\n')
+    file.write('lfence\nrdtsc # rdx:rax\nmov %rax, %rsi\n')
+    write_body(file, instruction, unroll)
+    file.write('lfence\nrdtsc\nshl $32, %rax\nor %rsi, %rax\nmov %rax, (%rdi)\nadd $8, %rdi\n')
+    file.write('dec %rcx\njnz 1b\n')
+    if INSTRUCTIONS[instruction]['feature'] == 'avx2':
+        file.write('vzeroupper\n')
+    file.write('ret\n\n')
+
+
+def create_kernels(instructions, unrolls, output = OBJDIR + 'kernels.S'):
+    ''' Creates the assembly file of the kernels.
+
+    Parameters:
+    instructions(list[str]): Keys of INSTRUCTIONS
+    unrolls(list[int]): Unroll factors, one kernel of each kind per instruction and unroll
+    output(string): The name of the output file. Default is ./build/kernels.S
+    '''
+    with open(output, 'w') as file:
+        file.write('# Generated by kernel_generator.py, do not edit\n\n.text\n\n')
+        for instruction in instructions:
+            for unroll in unrolls:
+                write_spam(file, instruction, unroll)
+                write_time(file, instruction, unroll)
+        file.write('.section .note.GNU-stack,"",@progbits\n')
+
+
+def create_table(instructions, unrolls, output = OBJDIR + 'kernelTable.c'):
+    ''' Creates the C table of the kernels, see native/kernelRegistry.h.
+    The default repetitions of a kernel run as many instructions as
+    spam_port1(SENDER_REP).
+
+    Parameters:
+    instructions(list[str]): Keys of INSTRUCTIONS
+    unrolls(list[int]): Unroll factors
+    output(string): The name of the output file. Default is ./build/kernelTable.c
+    '''
+    with open(output, 'w') as file:
+        file.write('// Generated by kernel_generator.py, do not edit\n\n')
+        file.write('#include "../native/kernelRegistry.h"\n#include "../native/config.h"\n\n')
+        for instruction in instructions:
+            for unroll in unrolls:
+                name = kernel_name(instruction, unroll)
+                file.write('extern void kernel_{}_spam(uint64_t repetitions);\n'.format(name))
+                file.write('extern void kernel_{}_time(uint64_t *buffer, uint64_t passCount);\n'.format(name))
+        file.write('\nconst KernelInfo kernelTable[] = {\n')
+        for instruction in instructions:
+            info = INSTRUCTIONS[instruction]
+            for unroll in unrolls:
+                name = kernel_name(instruction, unroll)
+                file.write('  {{"{}", "{}", "{}", {}, {}, {}, (SENDER_REP * {} + {} - 1) / {}, kernel_{}_spam, kernel_{}_time}},\n'.format(
+                    name, instruction, info['ports'], FEATURES[info['feature']], unroll, len(info['chains']),
+                    REFERENCE_UNROLL, unroll, unroll, name, name))
+        file.write('};\n\nconst int kernelCount = sizeof(kernelTable) / sizeof(kernelTable[0]);\n')
+
+
+##################################### MAIN #####################################
+
+def kernel_generator(instructions = list(INSTRUCTIONS), unrolls = UNROLLS):
+    if not os.path.isdir(OBJDIR):
+        os.mkdir(OBJDIR)
+    create_kernels(instructions, unrolls)
+    create_table(instructions, unrolls)
+
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-i', '--instructions', help='Instructions of the kernels, among {}. Default is all of them'.format(', '.join(INSTRUCTIONS)),
+                        nargs='+', choices=list(INSTRUCTIONS), default=list(INSTRUCTIONS))
+    parser.add_argument('-u', '--unrolls', help='Unroll factors of the kernels. Default is {}'.format(' '.join(map(str, UNROLLS))),
+                        nargs='+', type=int, default=UNROLLS)
+    args = parser.parse_args()
+    return args
+
+
+if __name__ == '__main__':
+    args = parse_arguments()
+    print("Creating {} kernels in {}kernels.S".format(2 * len(args.instructions) * len(args.unrolls), OBJDIR))
+    kernel_generator(args.instructions, args.unrolls)
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 /*!
@@ -33,7 +34,8 @@ int compareCluster ( const void * first, const void * second ) {
 
 /*!
    \fn int removeIndex(MicroCluster microClusters[], int mcLen, int index)
-   Pop an index from the list of microClusters
+   Pop an index from the list of microClusters. The caller updates the number of
+   microClusters.
    \param[in] microClusters Array of MicroCluster of fixed size.
    \param[in] mcLen Number of MicroClusters in the array.
    \param[in] index Index of the MicroCluster to be removed.
@@ -42,16 +44,52 @@ int compareCluster ( const void * first, const void * second ) {
 */
 int removeIndex(MicroCluster microClusters[], int mcLen, int index){
   if (index < mcLen) { // Check for boundaries
-    for (int i = index; i < mcLen; i++) {
-      microClusters[i] = microClusters[i+1]; // Shift all the microclusters to the left
-    }
-    mcLen--; // Update the size
+    // Shift all the microclusters to the left
+    memmove(&microClusters[index], &microClusters[index + 1], (mcLen - index - 1) * sizeof(MicroCluster));
     return 1;
   }
   return -1;
 }
 
 
+/*!
+   \fn int insertOrdered(MicroCluster microClusters[], int mcLen, MicroCluster mc)
+   Inserts a microCluster in an array sorted by center_x, after the ones with
+   the same center. The caller updates the number of microClusters.
+   \return Index of the inserted microCluster
+*/
+int insertOrdered(MicroCluster microClusters[], int mcLen, MicroCluster mc) {
+  int index = mcLen;
+  while ((index > 0) && (microClusters[index - 1].center_x > mc.center_x)) {
+    index--;
+  }
+  memmove(&microClusters[index + 1], &microClusters[index], (mcLen - index) * sizeof(MicroCluster));
+  microClusters[index] = mc;
+  return index;
+}
+
+
+/*!
+   \fn int restoreOrder(MicroCluster microClusters[], int mcLen, int index)
+   Moves a microCluster whose center changed back to its place in an array
+   sorted by center_x. Centers move by small steps, so it is usually not moved.
+   \return New index of the microCluster
+*/
+int restoreOrder(MicroCluster microClusters[], int mcLen, int index) {
+  MicroCluster mc = microClusters[index];
+  while ((index + 1 < mcLen) && (microClusters[index + 1].center_x < mc.center_x)) {
+    microClusters[index] = microClusters[index + 1];
+    index++;
+  }
+  while ((index > 0) && (microClusters[index - 1].center_x > mc.center_x)) {
+    microClusters[index] = microClusters[index - 1];
+    index--;
+  }
+  microClusters[index] = mc;
+  return index;
+}
+
+
 /*!
    \fn int initMCArray(MicroCluster mcs[])
    Initiate the array of MC with "fake" mc (x and y to -1)
@@ -69,6 +107,32 @@ int initMCArray(MicroCluster mcs[]) {
 }
 
 
+/*!
+   \fn long double decayFunction(DenStream *ds, long double t)
+   Computes the decay factor based on a given time.
+          We use it to lower the weight of old clusters.
+   \param *ds Pointer to the DenStream object
+   \param t Current time (ie the number of added samples)
+   \return Decay Factor
+*/
+long double decayFunction(DenStream *ds, long double t) {
+  return powl(2., (-1. * ds->lambda) * t);
+}
+
+
+/*!
+   \fn long double outlierThreshold(DenStream *ds, long double age)
+   Minimal weight of an o micro cluster created age samples ago. Ages below
+   DECAY_TABLE_SIZE are read from the table filled by initDenStream.
+*/
+long double outlierThreshold(DenStream *ds, long double age) {
+  if ((age >= 0) & (age < DECAY_TABLE_SIZE)) {
+    return ds->xiTable[(unsigned) age];
+  }
+  return (decayFunction(ds, age + ds->tp) - 1) / (decayFunction(ds, ds->tp) - 1);
+}
+
+
 /*!
    \fn int initDenStream(DenStream *ds, long double lambda, long double eps, long double beta, long double mu)
    Initates the DenStream Detector
@@ -107,6 +171,9 @@ int initDenStream(DenStream *ds, long double lambda, long double eps, long doubl
     ds->oMicroClusters[i] = mc;
     ds->pMicroClusters[i] = mc;
   }
+  for (int age = 0; age < DECAY_TABLE_SIZE; age++) {
+    ds->xiTable[age] = (decayFunction(ds, age + ds->tp) - 1) / (decayFunction(ds, ds->tp) - 1);
+  }
   return 1;
 }
 
@@ -187,6 +254,9 @@ int merging(DenStream *ds, Sample s) {
   int success = -1;
   if (nearestPMCIndex != -1) { // We have a mc, can we merge it ?
     success = tryMerge(ds, s, ds->pMicroClusters, nearestPMCIndex);
+    if (success == 1) { // Its center moved, keep the array sorted
+      restoreOrder(ds->pMicroClusters, ds->pLen, nearestPMCIndex);
+    }
   }
   if (success == -1) { // We couldn't merge it, lets try a o-microcluster
     int nearestOMCIndex = getNearestMicroCluster(s, ds->oMicroClusters, ds->oLen);
@@ -198,7 +268,7 @@ int merging(DenStream *ds, Sample s) {
       // We did insert it to a o-micro-cluster!
       // Can we upgrade the o cluster to a c-micro-cluster ?
       if (ds->oMicroClusters[nearestOMCIndex].weight > ds->beta * ds-> mu) {
-        ds->pMicroClusters[ds->pLen++] = ds->oMicroClusters[nearestOMCIndex];
+        insertOrdered(ds->pMicroClusters, ds->pLen++, ds->oMicroClusters[nearestOMCIndex]);
         removeIndex(ds->oMicroClusters, ds->oLen--, nearestOMCIndex);
       }
     }
@@ -217,19 +287,6 @@ int merging(DenStream *ds, Sample s) {
 }
 
 
-/*!
-   \fn long double decayFunction(DenStream *ds, long double t)
-   Computes the decay factor based on a given time.
-          We use it to lower the weight of old clusters.
-   \param *ds Pointer to the DenStream object
-   \param t Current time (ie the number of added samples)
-   \return Decay Factor
-*/
-long double decayFunction(DenStream *ds, long double t) {
-  return powl(2., (-1. * ds->lambda) * t);
-}
-
-
 /*!
    \fn int partialFit(DenStream *ds, Sample s)
    Merges a sample in a micro cluster, then every tp update clusters to:
@@ -244,27 +301,19 @@ int partialFit(DenStream *ds, Sample s) {
   merging(ds, s);
   if (((unsigned) roundl(ds->t)) % ((unsigned) roundl(ds->tp)) == 0) {
     int i; int count;
-    // Update PMCs
-    MicroCluster newPMCS[MAX_CLUSTER];
-    initMCArray(newPMCS);
+    // Update PMCs, compacting the array in place (order is kept)
     count = 0;
     for (i = 0; i < ds->pLen; i++) {
       if (ds->pMicroClusters[i].weight >= ds->beta * ds->mu) {
-        newPMCS[count++] = ds->pMicroClusters[i];
+        ds->pMicroClusters[count++] = ds->pMicroClusters[i];
       }
     }
     ds->pLen = count;
     // Update OMCs
-    long double Xis[ds->oLen];
-    for (i = 0; i < ds->oLen; i++) {
-      Xis[i] = (decayFunction(ds, ds->t - ds->oMicroClusters[i].creationTime + ds->tp) - 1) / (decayFunction(ds, ds->tp) - 1);
-    }
-    MicroCluster newOMCS[MAX_CLUSTER];
-    initMCArray(newOMCS);
-    count=0;
+    count = 0;
     for (i = 0; i < ds->oLen; i++) {
-      if (ds->oMicroClusters[i].weight >= Xis[i]) {
-        newOMCS[count++] = ds->oMicroClusters[i];
+      if (ds->oMicroClusters[i].weight >= outlierThreshold(ds, ds->t - ds->oMicroClusters[i].creationTime)) {
+        ds->oMicroClusters[count++] = ds->oMicroClusters[i];
       }
     }
     ds->oLen = count;
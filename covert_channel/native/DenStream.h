@@ -18,6 +18,9 @@
 /*!< Max number of clusters in the array - bad practice :() */
 #define MAX_CLUSTER 1000
 
+/*!< Ages (in samples) of o micro clusters with a precomputed weight threshold */
+#define DECAY_TABLE_SIZE 256
+
 
 /*!
    \struct DenStream
@@ -44,9 +47,12 @@ typedef struct {
   //tp represents the time period where we check and update our clusters.
   long double tp;
 
+  // Minimal weight of an o micro cluster, by age, see outlierThreshold
+  long double xiTable[DECAY_TABLE_SIZE];
+
   MicroCluster oMicroClusters[MAX_CLUSTER]; // Array of omc
   int oLen; // Number of omc
-  MicroCluster pMicroClusters[MAX_CLUSTER]; // Array of pmc
+  MicroCluster pMicroClusters[MAX_CLUSTER]; // Array of pmc, sorted by center_x
   int pLen; // Number of pmc
 
 } DenStream;
@@ -0,0 +1,297 @@
+/*!
+   \file benchCrosstalk.c
+   \brief Benchmark of the port 1 / port 5 sub-channels of dualPort.h.
+          A sender thread and a receiver thread run on two SMT siblings.
+          First, the receiver times each port (read_timings and
+          read_timings_p5) while the sender is idle, spams port 1, port 5 or
+          both: the shift of a port under the spam of the other one, relative
+          to the shift under its own spam, is the crosstalk.
+          Then random data frames are sent in a loopback, once as binary frames
+          on port 1 and once striped over both ports, with the thresholds
+          learned above, to compare their error rates and throughputs.
+*/
+#define _GNU_SOURCE
+
+#include "receiver.h"
+#include "sendBit.h"
+#include "dualPort.h"
+#include "multiLevel.h"
+#include "linkProfile.h"
+#include "p1_spam.h"
+#include "p5_spam.h"
+#include "tsc.h"
+#include "config.h"
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <immintrin.h>
+
+
+#define MAX_LOOPBACK_POINTS (1<<16) // Points recorded for a frame, per port
+#define MODE_COUNT 4 // Idle, port 1, port 5, both ports
+
+static const char *modeNames[MODE_COUNT] = {"idle", "port 1", "port 5", "both"};
+
+// Sender commands
+enum {
+  COMMAND_IDLE,
+  COMMAND_SPAM, // Spam the ports until the next command
+  COMMAND_FRAME, // Send the sequences from startTsc, then go idle
+  COMMAND_STOP
+};
+
+
+typedef struct {
+  atomic_int command;
+  int ports; // SPAM_PORT1 and/or SPAM_PORT5 for COMMAND_SPAM
+  uint64_t startTsc;
+  bool port1[DATA_FRAME_SIZE];
+  bool port5[DATA_FRAME_SIZE];
+  int sequenceSize;
+  int dual; // Send port5 too
+} CrosstalkSender;
+
+
+
+int pinThread(pthread_t thread, int cpu) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if (pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset) != 0) {
+    fprintf(stderr, "Warning: cannot pin a benchmark thread on CPU %i\n", cpu);
+    return -1;
+  }
+  return 1;
+}
+
+
+
+void *senderLoop(void *vargp) {
+  CrosstalkSender *sender = (CrosstalkSender *)vargp;
+  int command;
+  while ((command = atomic_load(&sender->command)) != COMMAND_STOP) {
+    if (command == COMMAND_SPAM) {
+      if (sender->ports == SPAM_PORTS_BOTH) spam_ports15_n(SENDER_REP);
+      else if (sender->ports == SPAM_PORT5) spam_port5_n(SENDER_REP);
+      else spam_port1_n(SENDER_REP);
+    }
+    else if (command == COMMAND_FRAME) {
+      if (sender->dual) {
+        sendDualSequenceAt(sender->startTsc, linkProfile.bitDuration, linkProfile.senderRep, sender->port1, sender->port5, sender->sequenceSize, NULL);
+      }
+      else {
+        sendSequenceAt(sender->startTsc, linkProfile.bitDuration, linkProfile.senderRep, sender->port1, sender->sequenceSize, NULL);
+      }
+      atomic_store(&sender->command, COMMAND_IDLE);
+    }
+    else {
+      _mm_pause();
+    }
+  }
+  return NULL;
+}
+
+
+
+// A point, as fed to the detector: the median of medianSize listen() calls
+unsigned int measurePoint(ListenBuffers *lb, size_t medianSize, unsigned int *window) {
+  for (size_t i = 0; i < medianSize; i++) {
+    window[i] = (unsigned int) (listen(lb) / 1000000000);
+  }
+  return median(window, medianSize);
+}
+
+
+
+// Median of pointCount points of the port of lb, with the sender in a mode
+unsigned int measureMode(CrosstalkSender *sender, int mode, ListenBuffers *lb, size_t pointCount, size_t medianSize, unsigned int *window, unsigned int *points) {
+  if (mode == 0) {
+    atomic_store(&sender->command, COMMAND_IDLE);
+  }
+  else {
+    sender->ports = mode;
+    atomic_store(&sender->command, COMMAND_SPAM);
+  }
+  for (size_t i = 0; i < pointCount / 10; i++) measurePoint(lb, medianSize, window); // Settle
+  for (size_t i = 0; i < pointCount; i++) points[i] = measurePoint(lb, medianSize, window);
+  atomic_store(&sender->command, COMMAND_IDLE);
+  return median(points, pointCount);
+}
+
+
+
+/*!
+   \fn int sendLoopbackFrame(CrosstalkSender *sender, ListenBuffers **lbs, LinkProfile *lps, size_t medianSize, unsigned int *window, unsigned int **points, bool *frame)
+   Sends a frame (striped over both ports if sender->dual) and decodes it.
+   With both ports, the receiver alternates between them, each point of a
+   port is followed by a point of the other one.
+   \return 1 if a frame was decoded in frame, -1 otherwise
+*/
+int sendLoopbackFrame(CrosstalkSender *sender, ListenBuffers **lbs, LinkProfile *lps, size_t medianSize, unsigned int *window, unsigned int **points, bool *frame) {
+  int ports = sender->dual ? 2 : 1;
+  uint64_t bitTicks = nsToTsc(linkProfile.bitDuration);
+  sender->startTsc = readTsc() + nsToTsc(SENDER_START_LEAD);
+  uint64_t endTsc = sender->startTsc + (sender->sequenceSize + 2) * bitTicks;
+  atomic_store(&sender->command, COMMAND_FRAME);
+
+  size_t pointCount = 0;
+  while ((readTsc() < endTsc) && (pointCount < MAX_LOOPBACK_POINTS)) {
+    for (int port = 0; port < ports; port++) {
+      points[port][pointCount] = measurePoint(lbs[port], medianSize, window);
+    }
+    pointCount++;
+  }
+  while (atomic_load(&sender->command) != COMMAND_IDLE) _mm_pause();
+
+  if (sender->dual) {
+    return decodeDualPortFrame(points[0], pointCount, points[1], pointCount, &lps[0], &lps[1], frame);
+  }
+  int stripeSize = DATA_FRAME_SIZE - DUAL_PORT_INIT_SIZE;
+  int symbols[DATA_FRAME_SIZE];
+  LevelResults lr;
+  if (decodeBinary(points[0], pointCount, &lps[0], symbols, stripeSize, &lr) != stripeSize) {
+    return -1;
+  }
+  frame[0] = 1; frame[1] = 0; frame[2] = 1; frame[3] = 0;
+  for (int i = 0; i < stripeSize; i++) frame[DUAL_PORT_INIT_SIZE + i] = symbols[i];
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  size_t pointCount = 2000;
+  size_t medianSize = 3;
+  int frameCount = 50;
+  int receiverCpu = CALIBRATION_RECEIVER_CPU;
+  int senderCpu = -1;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:m:f:r:s:h")) != -1) {
+    switch (opt) {
+      case 'n': pointCount = strtoul(optarg, NULL, 10); break;
+      case 'm': medianSize = strtoul(optarg, NULL, 10); break;
+      case 'f': frameCount = atoi(optarg); break;
+      case 'r': receiverCpu = atoi(optarg); break;
+      case 's': senderCpu = atoi(optarg); break;
+      default:
+        printf("Usage: %s [-n points] [-m medianSize] [-f frames] [-r receiverCpu] [-s senderCpu]\n", argv[0]);
+        return 1;
+    }
+  }
+  if ((pointCount < 10) | (medianSize == 0) | (frameCount < 0)) {
+    printf("Need at least 10 points, a median window and a positive number of frames\n");
+    return 1;
+  }
+
+  if (!spamPortsSupported(SPAM_PORTS_BOTH)) {
+    printf("The port 5 spam loops use AVX2 instructions, this CPU does not support them\n");
+    return 1;
+  }
+  if (senderCpu < 0) {
+    senderCpu = CALIBRATION_SENDER_CPU >= 0 ? CALIBRATION_SENDER_CPU : siblingCpu(receiverCpu);
+  }
+  if (senderCpu < 0) {
+    printf("CPU %i has no SMT sibling for the sender, give one with -s\n", receiverCpu);
+    return 1;
+  }
+  initTsc();
+  pinThread(pthread_self(), receiverCpu);
+  CrosstalkSender sender;
+  memset(&sender, 0, sizeof(sender));
+  atomic_store(&sender.command, COMMAND_IDLE);
+  pthread_t senderThread;
+  pthread_create(&senderThread, NULL, senderLoop, &sender);
+  pinThread(senderThread, senderCpu);
+
+  ListenBuffers lb1, lb5;
+  int ret = initListenBuffers(&lb1, 0);
+  assert(ret == 1);
+  ret = initListenBuffers(&lb5, 1);
+  assert(ret == 1);
+  lb5.port = 5;
+  ListenBuffers *lbs[2] = {&lb1, &lb5};
+  unsigned int *window = calloc(medianSize, sizeof(unsigned int));
+  unsigned int *points = calloc(pointCount, sizeof(unsigned int));
+
+  // Level of each port in each mode
+  unsigned int levels[2][MODE_COUNT];
+  printf("Median point of each receiver port (%zu points, median of %zu passes of %u samples)\n", pointCount, medianSize, linkProfile.receiverRep);
+  printf("receiver\t%s\t%s\t%s\t%s\n", modeNames[0], modeNames[1], modeNames[2], modeNames[3]);
+  for (int port = 0; port < 2; port++) {
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+      levels[port][mode] = measureMode(&sender, mode, lbs[port], pointCount, medianSize, window, points);
+    }
+    printf("port %i  \t%u\t%u\t%u\t%u\n", port ? 5 : 1, levels[port][0], levels[port][1], levels[port][2], levels[port][3]);
+  }
+
+  // Shift under the spam of the other port, relative to its own
+  LinkProfile lps[2];
+  int ownMode[2] = {SPAM_PORT1, SPAM_PORT5};
+  for (int port = 0; port < 2; port++) {
+    double own = (double) levels[port][ownMode[port]] - levels[port][0];
+    double other = (double) levels[port][ownMode[1 - port]] - levels[port][0];
+    if (own > 0.) {
+      printf("Crosstalk on port %i: %.1f%% of its own shift\n", port ? 5 : 1, 100. * other / own);
+    }
+    else {
+      printf("Crosstalk on port %i: no shift under its own spam\n", port ? 5 : 1);
+    }
+    lps[port] = linkProfile;
+    lps[port].jmpThreshold = (levels[port][0] + levels[port][ownMode[port]]) / 2;
+  }
+  free(points);
+
+  // Loopback, the receiver alternates between the ports when both are used
+  unsigned int *loopbackPoints[2] = {calloc(MAX_LOOPBACK_POINTS, sizeof(unsigned int)), calloc(MAX_LOOPBACK_POINTS, sizeof(unsigned int))};
+  assert((loopbackPoints[0] != NULL) & (loopbackPoints[1] != NULL));
+  if (frameCount > 0) printf("\nvariant \tframes\tlost\tBER\tperiods\traw bit/s\tgoodput bit/s\n");
+  for (int dual = 0; (dual < 2) & (frameCount > 0); dual++) {
+    sender.dual = dual;
+    sender.sequenceSize = dual ? DUAL_PORT_FRAME_SIZE : DATA_FRAME_SIZE;
+    LinkProfile variantProfiles[2] = {lps[0], lps[1]};
+    for (int port = 0; port < 2; port++) {
+      // Half the points per bit on each port when alternating
+      if (dual && (variantProfiles[port].minSpike > 1)) variantProfiles[port].minSpike /= 2;
+    }
+    int lost = 0, correct = 0;
+    unsigned long bitErrors = 0;
+    for (int f = 0; f < frameCount; f++) {
+      char data = rand() & 0xFF;
+      int sequenceNumber = f & 0xF;
+      bool sent[DATA_FRAME_SIZE], received[DATA_FRAME_SIZE];
+      createDataFrame(data, sequenceNumber, sent, DATA_FRAME_SIZE);
+      if (dual) {
+        createDualPortFrame(data, sequenceNumber, sender.port1, sender.port5);
+      }
+      else {
+        memcpy(sender.port1, sent, sizeof(sent));
+      }
+      if (sendLoopbackFrame(&sender, lbs, variantProfiles, medianSize, window, loopbackPoints, received) == -1) {
+        lost++;
+        continue;
+      }
+      int errors = 0;
+      for (int i = 0; i < DATA_FRAME_SIZE; i++) errors += sent[i] != received[i];
+      bitErrors += errors;
+      correct += errors == 0;
+    }
+    double airtime = (double) frameCount * sender.sequenceSize * linkProfile.bitDuration / 1e9;
+    int decoded = frameCount - lost;
+    printf("%-8s\t%i\t%i\t%.4f\t%i\t%.0f\t\t%.0f\n", dual ? "dual" : "port 1", frameCount, lost,
+           decoded > 0 ? (double) bitErrors / (decoded * DATA_FRAME_SIZE) : 1.,
+           sender.sequenceSize, DATA_FRAME_SIZE * frameCount / airtime, (double) DATA_PAYLOAD_BITS * correct / airtime);
+  }
+
+  atomic_store(&sender.command, COMMAND_STOP);
+  pthread_join(senderThread, NULL);
+  free(loopbackPoints[0]);
+  free(loopbackPoints[1]);
+  free(window);
+  return 0;
+}
@@ -0,0 +1,204 @@
+/*!
+   \file benchFec.c
+   \brief Check and benchmark of the convolutional code of the data frames
+          (convCode.h).
+          The decoder is first compared with a plain Viterbi decoder, one
+          state at a time: both must find paths at the same distance of random
+          received frames, and the rate 1/2 code must correct every pattern
+          of up to 3 errors (its free distance is 7).
+          Then both decoders are timed, and the frames of each FEC_MODE are
+          sent through a binary symmetric channel: a frame that is not
+          received costs a DATA_TIMEOUT before it is sent again, which gives
+          the goodput of each code.
+*/
+#include "convCode.h"
+#include "frame.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#define PAYLOAD_SIZE (DATA_FRAME_SIZE - 4)
+
+
+// Viterbi decoder of the previous textbook form, kept as the reference
+int referenceDecode(bool *coded, int bitCount, int fecMode, bool *bits) {
+  int steps = bitCount + CONV_TAIL;
+  int metrics[CONV_STATES], next[CONV_STATES];
+  int predecessors[CONV_MAX_STEPS][CONV_STATES];
+  for (int s = 0; s < CONV_STATES; s++) metrics[s] = s == 0 ? 0 : 1000;
+  int codedCount = 0;
+  for (int step = 0; step < steps; step++) {
+    int a = coded[codedCount++];
+    int b = ((fecMode == FEC_RATE_1_2) || (step % 2 == 0)) ? coded[codedCount++] : -1;
+    for (int s = 0; s < CONV_STATES; s++) next[s] = 1 << 30;
+    for (int s = 0; s < CONV_STATES; s++) {
+      for (int u = 0; u < 2; u++) {
+        int shiftRegister = (s << 1) | u;
+        int ns = shiftRegister & (CONV_STATES - 1);
+        int metric = metrics[s] + (__builtin_parity(shiftRegister & CONV_POLY_A) != a);
+        if (b != -1) metric += __builtin_parity(shiftRegister & CONV_POLY_B) != b;
+        if (metric < next[ns]) {
+          next[ns] = metric;
+          predecessors[step][ns] = s;
+        }
+      }
+    }
+    for (int s = 0; s < CONV_STATES; s++) metrics[s] = next[s];
+  }
+  int state = 0;
+  for (int step = steps - 1; step >= 0; step--) {
+    if (step < bitCount) bits[step] = state & 1;
+    state = predecessors[step][state];
+  }
+  return metrics[0];
+}
+
+
+
+int randomPayload(bool *bits) {
+  for (int i = 0; i < PAYLOAD_SIZE; i++) bits[i] = rand() & 1;
+  return 1;
+}
+
+
+
+// Returns the number of mismatches
+int checkCode(int trials) {
+  int mismatches = 0;
+  bool bits[PAYLOAD_SIZE], coded[2 * CONV_MAX_STEPS], decoded[PAYLOAD_SIZE], reference[PAYLOAD_SIZE];
+  for (int fecMode = FEC_RATE_1_2; fecMode <= FEC_RATE_2_3; fecMode++) {
+    int codedSize = convCodedSize(PAYLOAD_SIZE, fecMode);
+    for (int trial = 0; trial < trials; trial++) {
+      randomPayload(bits);
+      convEncode(bits, PAYLOAD_SIZE, fecMode, coded);
+      int errors = trial % 4; // Up to 3 errors, at distinct positions
+      int positions[3];
+      for (int e = 0; e < errors; e++) {
+        int position, fresh;
+        do {
+          position = rand() % codedSize;
+          fresh = 1;
+          for (int f = 0; f < e; f++) fresh &= positions[f] != position;
+        } while (!fresh);
+        positions[e] = position;
+        coded[position] ^= 1;
+      }
+      // Heavy noise, to compare the decoders on frames they cannot correct
+      if (trial % 8 == 7) {
+        for (int i = 0; i < codedSize; i++) coded[i] ^= rand() % 5 == 0;
+      }
+
+      int distance = convDecode(coded, PAYLOAD_SIZE, fecMode, decoded);
+      int referenceDistance = referenceDecode(coded, PAYLOAD_SIZE, fecMode, reference);
+      int wrongBits = 0;
+      for (int i = 0; i < PAYLOAD_SIZE; i++) wrongBits += decoded[i] != bits[i];
+      if (distance != referenceDistance) {
+        printf("Rate %s, trial %i: distance %i, reference %i\n", fecMode == FEC_RATE_1_2 ? "1/2" : "2/3", trial, distance, referenceDistance);
+        mismatches++;
+      }
+      else if ((trial % 8 != 7) && (((fecMode == FEC_RATE_1_2) && wrongBits) || (distance > errors))) {
+        printf("Rate %s, trial %i: %i errors, distance %i, %i wrong bits\n", fecMode == FEC_RATE_1_2 ? "1/2" : "2/3", trial, errors, distance, wrongBits);
+        mismatches++;
+      }
+    }
+  }
+  printf("%i frames per code: %i mismatches\n", trials, mismatches);
+  return mismatches;
+}
+
+
+
+double elapsedNs(struct timespec *start) {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (tp.tv_sec - start->tv_sec) * 1e9 + (tp.tv_nsec - start->tv_nsec);
+}
+
+
+
+int benchDecoders(int frameCount) {
+  int codedSize = convCodedSize(PAYLOAD_SIZE, FEC_RATE_1_2);
+  bool *coded = malloc((size_t) frameCount * codedSize);
+  bool bits[PAYLOAD_SIZE];
+  for (int f = 0; f < frameCount; f++) {
+    randomPayload(bits);
+    convEncode(bits, PAYLOAD_SIZE, FEC_RATE_1_2, &coded[(size_t) f * codedSize]);
+    for (int i = 0; i < codedSize; i++) coded[(size_t) f * codedSize + i] ^= rand() % 20 == 0;
+  }
+
+  struct timespec start;
+  long distances = 0;
+  printf("decoder \tns/frame\n");
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int f = 0; f < frameCount; f++) distances += referenceDecode(&coded[(size_t) f * codedSize], PAYLOAD_SIZE, FEC_RATE_1_2, bits);
+  printf("previous\t%.1f\n", elapsedNs(&start) / frameCount);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int f = 0; f < frameCount; f++) distances -= convDecode(&coded[(size_t) f * codedSize], PAYLOAD_SIZE, FEC_RATE_1_2, bits);
+  printf("swar    \t%.1f\n", elapsedNs(&start) / frameCount);
+  free(coded);
+  return distances == 0 ? 1 : -1;
+}
+
+
+
+// Frames of every code through a binary symmetric channel
+int benchChannel(int frameCount) {
+  double errorRates[] = {0.005, 0.01, 0.02, 0.05, 0.1};
+  double timeoutBits = (double) DATA_TIMEOUT / BIT_DURATION;
+  printf("BER  \tcode\tbits\treceived\tundetected\tgoodput (data bits per bit)\n");
+  for (size_t r = 0; r < sizeof(errorRates) / sizeof(errorRates[0]); r++) {
+    for (int fecMode = FEC_NONE; fecMode <= FEC_RATE_2_3; fecMode++) {
+      int frameSize = dataFrameSize(fecMode);
+      int received = 0, undetected = 0;
+      for (int f = 0; f < frameCount; f++) {
+        bool frame[MAX_DATA_FRAME_SIZE];
+        char data = rand(), decodedData;
+        int sequenceNumber = rand() % 16, decodedSequenceNumber;
+        createCodedDataFrame(data, sequenceNumber, fecMode, frame);
+        for (int i = 0; i < frameSize; i++) frame[i] ^= rand() < errorRates[r] * RAND_MAX;
+        if (decodeCodedDataFrame(frame, frameSize, fecMode, &decodedSequenceNumber, &decodedData) >= 0) {
+          received++;
+          undetected += (decodedData != data) || (decodedSequenceNumber != sequenceNumber);
+        }
+      }
+      // Each lost frame costs a timeout, then is sent again
+      double success = (double) received / frameCount;
+      double bitsPerFrame = success > 0 ? frameSize / success + timeoutBits * (1 - success) / success : 0;
+      printf("%.3f\t%s\t%i\t%.4f  \t%.4f    \t%.4f\n", errorRates[r], fecMode == FEC_NONE ? "none" : fecMode == FEC_RATE_1_2 ? "1/2" : "2/3",
+             frameSize, success, (double) undetected / frameCount, bitsPerFrame > 0 ? 8 / bitsPerFrame : 0.);
+    }
+  }
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  int frameCount = 100000;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:h")) != -1) {
+    switch (opt) {
+      case 'n': frameCount = atoi(optarg); break;
+      default:
+        printf("Usage: %s [-n frames]\n", argv[0]);
+        return 1;
+    }
+  }
+  srand(0);
+  if (checkCode(20000) != 0) {
+    return 1;
+  }
+  if (frameCount <= 0) {
+    return 0;
+  }
+  if (benchDecoders(frameCount) == -1) {
+    printf("The decoders disagree on the distances\n");
+    return 1;
+  }
+  benchChannel(frameCount);
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*!
+   \file benchHamming.c
+   \brief Check and benchmark of the table-driven SECDED code of hammingCode.h.
+          Every possible received byte is first decoded and compared with the
+          nearest codeword found by brute force: at distance 0 or 1 it must be
+          decoded to that codeword's data, at distance 2 rejected.
+          Then random bytes are decoded with the packed decoder, the bit array
+          one and the bit array decoder of the previous versions, which
+          recomputed the parities and rejected single errors.
+*/
+#include "hammingCode.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+
+// hammingErrorCount and hammingDecode of the previous versions, kept as the reference
+int referenceErrorCount(int *encodedMessage) {
+  int correctCode = 1;
+  correctCode &= (encodedMessage[0] == (encodedMessage[2] ^ encodedMessage[4] ^ encodedMessage[6]));
+  correctCode &= (encodedMessage[1] == (encodedMessage[2] ^ encodedMessage[5] ^ encodedMessage[6]));
+  correctCode &= (encodedMessage[3] == (encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6]));
+  correctCode &= (encodedMessage[7] == (encodedMessage[0] ^ encodedMessage[1] ^ encodedMessage[2] ^ encodedMessage[3] ^ encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6]));
+  if (correctCode) {
+    return 0;
+  }
+  if (encodedMessage[7] != (encodedMessage[0] ^ encodedMessage[1] ^ encodedMessage[2] ^ encodedMessage[3] ^ encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6])) {
+    return 1;
+  }
+  return 2;
+}
+
+int referenceDecode(int *encodedMessage, int *decodedMessage) {
+  if (referenceErrorCount(encodedMessage) > 0) {
+    return -1;
+  }
+  decodedMessage[0] = encodedMessage[2];
+  decodedMessage[1] = encodedMessage[4];
+  decodedMessage[2] = encodedMessage[5];
+  decodedMessage[3] = encodedMessage[6];
+  return decodedMessage[0]*8 + decodedMessage[1]*4 + decodedMessage[2]*2 + decodedMessage[3];
+}
+
+
+
+// Decodes the 256 bytes and the 16 nibbles, returns the number of mismatches
+int checkCode() {
+  int mismatches = 0;
+  int counts[3] = {0, 0, 0}; // Distance 0, 1 and 2 to the nearest codeword
+  for (int byte = 0; byte < (1 << CODED_BITS); byte++) {
+    int nearest = -1, distance = CODED_BITS + 1;
+    for (int nibble = 0; nibble < (1 << ACTUAL_BIT); nibble++) {
+      int d = __builtin_popcount(byte ^ hammingEncodeNibble(nibble));
+      if (d < distance) {
+        distance = d;
+        nearest = nibble;
+      }
+    }
+    if (distance > 2) {
+      printf("Byte 0x%02x is at distance %i of the code\n", byte, distance);
+      mismatches++;
+      continue;
+    }
+    counts[distance]++;
+
+    int corrected;
+    int decoded = hammingDecodeByte(byte, &corrected);
+    int expected = distance < 2 ? nearest : HAMMING_DOUBLE_ERROR;
+    if ((decoded != expected) || (corrected != (distance == 1))) {
+      printf("Byte 0x%02x: decoded %i (corrected %i), expected %i\n", byte, decoded, corrected, expected);
+      mismatches++;
+    }
+
+    int encodedMessage[CODED_BITS], decodedMessage[ACTUAL_BIT];
+    for (int i = 0; i < CODED_BITS; i++) encodedMessage[i] = (byte >> i) & 1;
+    decoded = hammingDecode(encodedMessage, decodedMessage);
+    if ((decoded != (distance < 2 ? nearest : -1)) && !(!HAMMING_CORRECTION && (distance == 1) && (decoded == -1))) {
+      printf("Byte 0x%02x: hammingDecode gives %i, expected %i\n", byte, decoded, expected);
+      mismatches++;
+    }
+  }
+
+  // The bit array encoder gives the reference codewords
+  for (int nibble = 0; nibble < (1 << ACTUAL_BIT); nibble++) {
+    int message[ACTUAL_BIT], encodedMessage[CODED_BITS], decodedMessage[ACTUAL_BIT];
+    for (int i = 0; i < ACTUAL_BIT; i++) message[i] = (nibble >> (ACTUAL_BIT - 1 - i)) & 1;
+    hammingEncode(message, encodedMessage);
+    int byte = 0;
+    for (int i = 0; i < CODED_BITS; i++) byte |= encodedMessage[i] << i;
+    if ((byte != hammingEncodeNibble(nibble)) || (referenceDecode(encodedMessage, decodedMessage) != nibble)) {
+      printf("Nibble %i: codeword 0x%02x does not match the reference\n", nibble, byte);
+      mismatches++;
+    }
+  }
+
+  printf("%i codewords, %i single errors, %i double errors: %i mismatches\n", counts[0], counts[1], counts[2], mismatches);
+  return mismatches;
+}
+
+
+
+double elapsedNs(struct timespec *start) {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (tp.tv_sec - start->tv_sec) * 1e9 + (tp.tv_nsec - start->tv_nsec);
+}
+
+
+
+int printThroughput(const char *name, double ns, size_t count, long accepted) {
+  printf("%-8s\t%.2f\t%.1f\t%ld\n", name, ns / count, count / ns * 1e3, accepted);
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  size_t wordCount = 10000000;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:h")) != -1) {
+    switch (opt) {
+      case 'n': wordCount = strtoul(optarg, NULL, 10); break;
+      default:
+        printf("Usage: %s [-n words]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (checkCode() != 0) {
+    return 1;
+  }
+  if (wordCount == 0) {
+    return 0;
+  }
+
+  // Mostly valid codewords, with the error rates of a noisy link
+  uint8_t *words = malloc(wordCount);
+  int (*arrays)[CODED_BITS] = malloc(wordCount * sizeof(*arrays));
+  srand(0);
+  for (size_t i = 0; i < wordCount; i++) {
+    words[i] = hammingEncodeNibble(rand());
+    if (rand() % 10 == 0) words[i] ^= 1 << (rand() % CODED_BITS);
+    if (rand() % 100 == 0) words[i] ^= 1 << (rand() % CODED_BITS);
+    for (int bit = 0; bit < CODED_BITS; bit++) arrays[i][bit] = (words[i] >> bit) & 1;
+  }
+
+  struct timespec start;
+  int decodedMessage[ACTUAL_BIT];
+  printf("variant \tns/word\tMword/s\taccepted\n");
+
+  long accepted = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < wordCount; i++) accepted += referenceDecode(arrays[i], decodedMessage) >= 0;
+  printThroughput("previous", elapsedNs(&start), wordCount, accepted);
+
+  accepted = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < wordCount; i++) accepted += hammingDecode(arrays[i], decodedMessage) >= 0;
+  printThroughput("array", elapsedNs(&start), wordCount, accepted);
+
+  accepted = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < wordCount; i++) accepted += hammingDecodeField(words[i]) >= 0;
+  printThroughput("packed", elapsedNs(&start), wordCount, accepted);
+
+  free(words);
+  free(arrays);
+  return 0;
+}
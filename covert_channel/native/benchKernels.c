@@ -0,0 +1,236 @@
+/*!
+   \file benchKernels.c
+   \brief Sweep of the generated kernels (kernelRegistry.h).
+          First, each spam kernel is timed alone: TSC ticks per repetition and
+          per instruction, and how long its default repetitions last.
+          Then a receiver thread and a sender thread run on two SMT siblings.
+          For every timing kernel, the receiver times its passes while the
+          sender is idle, then while it runs each spam kernel in a loop. The
+          contention of a spam kernel is the effect size of the shift of the
+          passes: the difference of their means over the pooled standard
+          deviation. The best spam kernel of each timing kernel is the
+          contention source to use on this CPU (-k and -K of covertChannel).
+*/
+#define _GNU_SOURCE
+
+#include "kernelRegistry.h"
+#include "tsc.h"
+#include "config.h"
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <immintrin.h>
+
+
+typedef struct {
+  atomic_int stop;
+  _Atomic(SpamKernel) spam; // NULL while idle
+  atomic_ullong repetitions;
+  atomic_uint generation; // Incremented for every kernel change
+  atomic_uint seen; // Last generation the sender loaded the kernel of
+} KernelSender;
+
+
+typedef struct {
+  double mean;
+  double deviation;
+} PassStats;
+
+
+
+int pinThread(pthread_t thread, int cpu) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if (pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset) != 0) {
+    fprintf(stderr, "Warning: cannot pin a benchmark thread on CPU %i\n", cpu);
+    return -1;
+  }
+  return 1;
+}
+
+
+
+void *senderLoop(void *vargp) {
+  KernelSender *sender = (KernelSender *)vargp;
+  while (!atomic_load(&sender->stop)) {
+    unsigned int generation = atomic_load(&sender->generation);
+    SpamKernel spam = atomic_load(&sender->spam);
+    uint64_t repetitions = atomic_load(&sender->repetitions);
+    atomic_store(&sender->seen, generation);
+    if (spam != NULL) spam(repetitions);
+    else _mm_pause();
+  }
+  return NULL;
+}
+
+
+
+// Switches the sender to a kernel (NULL for idle), once it is running it
+int setSenderKernel(KernelSender *sender, const KernelInfo *kernel) {
+  atomic_store(&sender->repetitions, kernel != NULL ? kernel->repetitions : 0);
+  atomic_store(&sender->spam, kernel != NULL ? kernel->spam : NULL);
+  unsigned int generation = atomic_fetch_add(&sender->generation, 1) + 1;
+  while (atomic_load(&sender->seen) != generation) _mm_pause();
+  return 1;
+}
+
+
+
+// Mean and standard deviation of the durations of passCount passes
+int measurePasses(TimingKernel time, uint64_t *timings, size_t passCount, PassStats *stats) {
+  time(timings, passCount / 10 + 1); // Settle
+  time(timings, passCount);
+  double sum = 0., squareSum = 0.;
+  for (size_t i = 0; i < passCount; i++) {
+    double duration = (uint32_t) ((timings[i] >> 32) - (timings[i] & 0xFFFFFFFF));
+    sum += duration;
+    squareSum += duration * duration;
+  }
+  stats->mean = sum / passCount;
+  stats->deviation = sqrt(fmax(squareSum / passCount - stats->mean * stats->mean, 0.));
+  return 1;
+}
+
+
+
+// Ticks per repetition of every spam kernel, alone on this CPU
+int benchThroughput() {
+  initTsc();
+  printf("kernel      \tports\tticks/rep\tticks/instr\tdefault burst (us)\n");
+  for (int k = 0; k < kernelCount; k++) {
+    const KernelInfo *kernel = &kernelTable[k];
+    if (!kernelSupported(kernel)) continue;
+    kernel->spam(1024); // Warm up
+    uint64_t start = readTsc();
+    kernel->spam(1024);
+    double ticksPerRep = (double) (readTsc() - start) / 1024;
+    printf("%-12s\t%s\t%.1f\t\t%.2f\t\t%.1f\n", kernel->name, kernel->ports, ticksPerRep,
+           ticksPerRep / (kernel->unroll * kernel->chains), tscToNs(ticksPerRep * kernel->repetitions) / 1000.);
+  }
+  return 1;
+}
+
+
+
+// Contention of every spam kernel on the given timing kernels
+int benchContention(const KernelInfo **timingKernels, int timingCount, int receiverCpu, int senderCpu, size_t passCount) {
+  uint64_t *timings = malloc(passCount * sizeof(uint64_t));
+  if (timings == NULL) {
+    return -1;
+  }
+  KernelSender sender;
+  memset(&sender, 0, sizeof(sender));
+  pthread_t thread;
+  pthread_create(&thread, NULL, senderLoop, &sender);
+  pinThread(thread, senderCpu);
+  pinThread(pthread_self(), receiverCpu);
+
+  for (int t = 0; t < timingCount; t++) {
+    const KernelInfo *timing = timingKernels[t];
+    PassStats idle, contended;
+    setSenderKernel(&sender, NULL);
+    measurePasses(timing->time, timings, passCount, &idle);
+    printf("\nTiming kernel %s (ports %s): idle pass %.1f +- %.1f ticks\n", timing->name, timing->ports, idle.mean, idle.deviation);
+    printf("spam kernel \tports\tpass (ticks)\tshift\teffect size\n");
+    const KernelInfo *best = NULL;
+    double bestEffect = 0.;
+    for (int k = 0; k < kernelCount; k++) {
+      const KernelInfo *kernel = &kernelTable[k];
+      if (!kernelSupported(kernel)) continue;
+      setSenderKernel(&sender, kernel);
+      measurePasses(timing->time, timings, passCount, &contended);
+      double pooled = sqrt((idle.deviation * idle.deviation + contended.deviation * contended.deviation) / 2.);
+      double effect = pooled > 0. ? (contended.mean - idle.mean) / pooled : 0.;
+      printf("%-12s\t%s\t%.1f\t\t%+.1f%%\t%.2f\n", kernel->name, kernel->ports, contended.mean,
+             100. * (contended.mean - idle.mean) / idle.mean, effect);
+      if ((best == NULL) || (effect > bestEffect)) {
+        best = kernel;
+        bestEffect = effect;
+      }
+    }
+    if (best != NULL) {
+      printf("Best contention source for %s: %s (effect size %.2f)\n", timing->name, best->name, bestEffect);
+    }
+  }
+
+  atomic_store(&sender.stop, 1);
+  pthread_join(thread, NULL);
+  free(timings);
+  return 1;
+}
+
+
+
+int usage(char *name) {
+  printf("Usage: %s [-l] [-t kernel] [-r cpu] [-s cpu] [-n passes]\n", name);
+  printf("\t-l\t\tList the kernels and exit\n");
+  printf("\t-t kernel\tTiming kernel to sweep the spam kernels on (default every _u48 one)\n");
+  printf("\t-r cpu\t\tCPU of the receiver (default %i)\n", CALIBRATION_RECEIVER_CPU);
+  printf("\t-s cpu\t\tCPU of the sender, an SMT sibling of the receiver (default %i, -1 finds it in the topology)\n", CALIBRATION_SENDER_CPU);
+  printf("\t-n passes\tPasses timed per spam kernel (default 20000)\n");
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  const char *timingName = NULL;
+  int receiverCpu = CALIBRATION_RECEIVER_CPU;
+  int senderCpu = -1;
+  size_t passCount = 20000;
+  int opt;
+  while ((opt = getopt(argc, argv, "lt:r:s:n:h")) != -1) {
+    switch (opt) {
+      case 'l': return printKernels() == 1 ? 0 : 1;
+      case 't': timingName = optarg; break;
+      case 'r': receiverCpu = atoi(optarg); break;
+      case 's': senderCpu = atoi(optarg); break;
+      case 'n': passCount = strtoul(optarg, NULL, 10); break;
+      default: return usage(argv[0]);
+    }
+  }
+  if (passCount == 0) {
+    return usage(argv[0]);
+  }
+
+  const KernelInfo *timingKernels[kernelCount];
+  int timingCount = 0;
+  if (timingName != NULL) {
+    timingKernels[0] = findKernel(timingName);
+    if (timingKernels[0] == NULL) {
+      fprintf(stderr, "Unknown or unsupported kernel %s\n", timingName);
+      return usage(argv[0]);
+    }
+    timingCount = 1;
+  }
+  else {
+    for (int k = 0; k < kernelCount; k++) {
+      if ((kernelTable[k].unroll == 48) && kernelSupported(&kernelTable[k])) {
+        timingKernels[timingCount++] = &kernelTable[k];
+      }
+    }
+  }
+
+  if (senderCpu < 0) {
+    senderCpu = CALIBRATION_SENDER_CPU >= 0 ? CALIBRATION_SENDER_CPU : siblingCpu(receiverCpu);
+  }
+  benchThroughput();
+  if (senderCpu < 0) {
+    printf("\nCPU %i has no SMT sibling for the sender (give one with -s), skipping the contention sweep\n", receiverCpu);
+    return 0;
+  }
+  long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+  if ((receiverCpu == senderCpu) || (receiverCpu >= cpuCount) || (senderCpu >= cpuCount)) {
+    printf("\nThe receiver and the sender need two online SMT siblings (%ld CPUs online), skipping the contention sweep\n", cpuCount);
+    return 0;
+  }
+  return benchContention(timingKernels, timingCount, receiverCpu, senderCpu, passCount) == 1 ? 0 : 1;
+}
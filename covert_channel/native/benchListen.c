@@ -0,0 +1,127 @@
+/*!
+   \file benchListen.c
+   \brief Benchmark of the per-point measurement path of the receiver.
+          Compares the historical listen(), which allocated and freed its two
+          buffers on every pass, with the preallocated ListenBuffers.
+          A point is what listenStream feeds to the detector: the median of
+          medianSize listen() calls. Both variants run in alternating blocks on
+          the same pinned thread so frequency drift affects them equally.
+*/
+#define _GNU_SOURCE
+
+#include "receiver.h"
+#include "p1_time.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <x86intrin.h>
+
+
+#define BLOCK_SIZE 1000 // Points measured before switching variant
+
+
+// The listen() of the previous versions, kept as the reference
+uint64_t listenAlloc() {
+  size_t nbTimings = RECEIVER_REP;
+  uint64_t *timings = (uint64_t *)calloc(nbTimings, sizeof(uint64_t));
+  uint64_t *differences = (uint64_t *)calloc(nbTimings - 1, sizeof(uint64_t));
+  assert(timings != NULL);
+  assert(differences != NULL);
+  read_timings(timings);
+  computeDifferences(differences, timings, nbTimings);
+  free(timings);
+  uint64_t timingAverage = average(differences, nbTimings);
+  free(differences);
+  return timingAverage;
+}
+
+
+
+uint64_t measurePoint(ListenBuffers *lb, size_t medianSize, unsigned int *window) {
+  uint64_t start = __rdtsc();
+  for (size_t i = 0; i < medianSize; i++) {
+    window[i] = (unsigned int) ((lb == NULL ? listenAlloc() : listen(lb)) / 1000000000);
+  }
+  median(window, medianSize);
+  return __rdtsc() - start;
+}
+
+
+
+int compareCycles(const void *first, const void *second) {
+  uint64_t f = *(const uint64_t *) first;
+  uint64_t s = *(const uint64_t *) second;
+  return (f > s) - (f < s);
+}
+
+
+
+int printLatencies(const char *name, uint64_t *cycles, size_t count) {
+  double mean = 0., variance = 0.;
+  for (size_t i = 0; i < count; i++) mean += cycles[i];
+  mean /= count;
+  for (size_t i = 0; i < count; i++) variance += (cycles[i] - mean) * (cycles[i] - mean);
+  variance /= count;
+
+  qsort(cycles, count, sizeof(uint64_t), compareCycles);
+  printf("%-8s\t%.0f\t%.0f\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\n", name, mean, sqrt(variance),
+         cycles[count / 2], cycles[(size_t) (count * 0.99)], cycles[(size_t) (count * 0.999)], cycles[count - 1]);
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  size_t pointCount = 100000;
+  size_t medianSize = 10;
+  int cpu = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:m:c:h")) != -1) {
+    switch (opt) {
+      case 'n': pointCount = strtoul(optarg, NULL, 10); break;
+      case 'm': medianSize = strtoul(optarg, NULL, 10); break;
+      case 'c': cpu = atoi(optarg); break;
+      default:
+        printf("Usage: %s [-n points] [-m medianSize] [-c cpu]\n", argv[0]);
+        return 1;
+    }
+  }
+  pointCount -= pointCount % BLOCK_SIZE;
+  if ((pointCount == 0) | (medianSize == 0)) {
+    printf("Need at least %i points and a median window\n", BLOCK_SIZE);
+    return 1;
+  }
+
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+
+  ListenBuffers lb;
+  int ret = initListenBuffers(&lb, 0);
+  assert(ret == 1);
+  unsigned int *window = calloc(medianSize, sizeof(unsigned int));
+  uint64_t *allocCycles = calloc(pointCount, sizeof(uint64_t));
+  uint64_t *arenaCycles = calloc(pointCount, sizeof(uint64_t));
+
+  for (size_t block = 0; block < pointCount; block += BLOCK_SIZE) {
+    for (size_t i = block; i < block + BLOCK_SIZE; i++) allocCycles[i] = measurePoint(NULL, medianSize, window);
+    for (size_t i = block; i < block + BLOCK_SIZE; i++) arenaCycles[i] = measurePoint(&lb, medianSize, window);
+  }
+
+  printf("Per point latency in TSC cycles (%zu points, median of %zu passes of %i samples)\n", pointCount, medianSize, RECEIVER_REP);
+  printf("variant \tmean\tstddev\tp50\tp99\tp99.9\tmax\n");
+  printLatencies("alloc", allocCycles, pointCount);
+  printLatencies("arena", arenaCycles, pointCount);
+
+  free(window);
+  free(allocCycles);
+  free(arenaCycles);
+  return 0;
+}
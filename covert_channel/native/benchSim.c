@@ -0,0 +1,204 @@
+/*!
+   \file benchSim.c
+   \brief End to end benchmark of the receiver on a simulated channel (see
+          channelSim.h), without an SMT sibling.
+          For each channel model, random request frames are scheduled like
+          sendSequenceAt sends them, a few bits after the listener starts,
+          and received by listenStream with the detector and filter of the
+          command line. We report the bit error rate of the detector, the
+          frames decoded correctly, the goodput on the simulated clock (8
+          bits of sequence number and selective ack per frame) and how many
+          frames are simulated per second.
+*/
+#include "channelSim.h"
+#include "receiver.h"
+#include "covertChannel.h"
+#include "frame.h"
+#include "linkProfile.h"
+#include "stageProfile.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+
+typedef struct {
+  size_t frames;
+  size_t detected; // Frames the detector completed before the timeout
+  size_t valid; // Frames with a valid init sequence and Hamming codes
+  size_t correct; // Valid frames equal to the one sent
+  size_t bitErrors; // Over the detected frames
+  double simulatedNs;
+  double seconds;
+} SimStats;
+
+
+
+double elapsedSeconds(struct timespec *start) {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return (tp.tv_sec - start->tv_sec) + (tp.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+
+int runModel(ChannelModel *model, ListenBuffers *lb, size_t frameCount, uint64_t seed, bool everyPass, SimStats *stats) {
+  ChannelSim sim;
+  initChannelSim(&sim, model, seed);
+  sim.everyPass = everyPass;
+  lb->sim = &sim;
+  memset(stats, 0, sizeof(*stats));
+  srand(seed);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t f = 0; f < frameCount; f++) {
+    int sequenceNumber = rand() % 16, sack = rand() % 16;
+    bool frame[REQUEST_FRAME_SIZE];
+    createRequestFrame(sequenceNumber, sack, frame, REQUEST_FRAME_SIZE);
+    // The sender answers within a few bits
+    double frameStart = simNowNs(&sim) + linkProfile.bitDuration * (1. + rand() % 3);
+    simScheduleSequence(&sim, frameStart, linkProfile.bitDuration, frame, REQUEST_FRAME_SIZE);
+
+    atomic_int finished = 0;
+    ThreadRequestInfos infos;
+    infos.threadNumber = 0;
+    infos.buffers = lb;
+    infos.finished = &finished;
+    infos.code = TIMEOUT;
+    listenStream(&infos);
+
+    stats->frames++;
+    if (infos.code != VALID_ANSWER) continue;
+    stats->detected++;
+    for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
+      stats->bitErrors += infos.bits[i] != frame[i];
+    }
+    if (checkRequestFrame(infos.rFrame)) {
+      stats->valid++;
+      stats->correct += (infos.rFrame.sequenceNumber == sequenceNumber) && (infos.rFrame.sack == sack);
+    }
+    // The next frame comes after this one, even if it was detected early
+    double frameEnd = frameStart + (double) REQUEST_FRAME_SIZE * linkProfile.bitDuration;
+    while (simNowNs(&sim) < frameEnd) simulateTimings(&sim, lb->timings, lb->passCount);
+  }
+  stats->simulatedNs = simNowNs(&sim);
+  stats->seconds = elapsedSeconds(&start);
+  lb->sim = NULL;
+  return 1;
+}
+
+
+
+int printSimStats(const char *name, SimStats *stats) {
+  printf("%-8s\t%zu\t%.4f\t%.4f\t%.4f\t%.4f\t%.1f\t%.0f\n", name, stats->frames,
+         stats->detected > 0 ? (double) stats->bitErrors / (stats->detected * REQUEST_FRAME_SIZE) : 1.,
+         (double) stats->detected / stats->frames, (double) stats->valid / stats->frames,
+         (double) stats->correct / stats->frames, (double) REQUEST_PAYLOAD_BITS * stats->correct / (stats->simulatedNs / 1e9),
+         stats->frames / stats->seconds);
+  return 1;
+}
+
+
+
+int usage(char *name) {
+  printf("Usage: %s [-m model] [-n frames] [-d detector] [-f filter] [-w window] [-s seed] [-x] [-t prefix] [-S profile] [-v]\n", name);
+  printf("\t-m model\tclean, noisy, drift, bursts, load or hostile (default all of them)\n");
+  printf("\t-n frames\tRequest frames per model (default 1000)\n");
+  printf("\t-d detector\tthreshold or denstream (default threshold)\n");
+  printf("\t-f filter\tqsort, network, sliding, hampel or trimmed (default network)\n");
+  printf("\t-w window\tNumber of timings in a filter window (default 10)\n");
+  printf("\t-s seed\t\tSeed of the simulation (default 1)\n");
+  printf("\t-x\t\tDraw every pass instead of the average of each listen(), slower\n");
+  printf("\t-t prefix\tTrace the points of the listener in prefix.0, for plot.py\n");
+  printf("\t-S profile\tWrite the latency histograms of the receiver stages, as JSON (.json) or CSV (needs STAGE_PROFILING)\n");
+  printf("\t-v\t\tPrint the parameters of each model\n");
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  const char *models[] = {"clean", "noisy", "drift", "bursts", "load", "hostile"};
+  int modelCount = sizeof(models) / sizeof(models[0]);
+  const char *modelName = NULL;
+  size_t frameCount = 1000;
+  DetectorType detector = DETECTOR_THRESHOLD;
+  int filterType = FILTER_NETWORK;
+  size_t filterSize = 10;
+  uint64_t seed = 1;
+  int verbose = 0;
+  bool everyPass = false;
+  char *stageProfilePath = NULL;
+  char *pointTracePrefix = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:n:d:f:w:s:xt:S:vh")) != -1) {
+    switch (opt) {
+      case 'm': modelName = optarg; break;
+      case 'n': frameCount = strtoul(optarg, NULL, 10); break;
+      case 'd':
+        if (strcmp(optarg, "threshold") == 0) detector = DETECTOR_THRESHOLD;
+        else if (strcmp(optarg, "denstream") == 0) detector = DETECTOR_DENSTREAM;
+        else return usage(argv[0]);
+        break;
+      case 'f': filterType = filterTypeFromName(optarg); break;
+      case 'w': filterSize = strtoul(optarg, NULL, 10); break;
+      case 's': seed = strtoull(optarg, NULL, 10); break;
+      case 'x': everyPass = true; break;
+      case 't': pointTracePrefix = optarg; break;
+      case 'S': stageProfilePath = optarg; break;
+      case 'v': verbose = 1; break;
+      default: return usage(argv[0]);
+    }
+  }
+  if ((filterType == -1) || (setReceiverFilter(filterType, filterSize, 0) == -1)) {
+    fprintf(stderr, "Invalid filter, the window holds up to %i timings\n", MAX_FILTER_SIZE);
+    return usage(argv[0]);
+  }
+  if (setReceiverDetector(detector) == -1) {
+    fprintf(stderr, "Cannot allocate the DenStream detectors\n");
+    return 1;
+  }
+  if ((stageProfilePath != NULL) && !STAGE_PROFILING) {
+    fprintf(stderr, "The stages are not profiled, set STAGE_PROFILING in config.h\n");
+    return 1;
+  }
+  if ((pointTracePrefix != NULL) && (startPointTrace(pointTracePrefix) == -1)) {
+    fprintf(stderr, "Cannot map the point traces %s.*\n", pointTracePrefix);
+    return 1;
+  }
+  if (modelName != NULL) {
+    models[0] = modelName;
+    modelCount = 1;
+  }
+
+  ListenBuffers lb;
+  if (initListenBuffers(&lb, 0) == -1) {
+    fprintf(stderr, "Cannot allocate the listen buffers\n");
+    return 1;
+  }
+  printf("model   \tframes\tBER\tdetected\tvalid\tcorrect\tgoodput (bit/s)\tframes/s\n");
+  for (int m = 0; m < modelCount; m++) {
+    ChannelModel model;
+    SimStats stats;
+    if (initChannelModel(&model, models[m]) == -1) {
+      fprintf(stderr, "Unknown model %s\n", models[m]);
+      return usage(argv[0]);
+    }
+    if (verbose) printChannelModel(&model);
+    runModel(&model, &lb, frameCount, seed, everyPass, &stats);
+    printSimStats(models[m], &stats);
+  }
+  stopPointTrace();
+  if (stageProfilePath != NULL) {
+    printStageProfile();
+    if (writeStageProfile(stageProfilePath) == -1) {
+      fprintf(stderr, "Cannot write the stage profile %s\n", stageProfilePath);
+      return 1;
+    }
+  }
+  return 0;
+}
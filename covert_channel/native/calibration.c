@@ -0,0 +1,439 @@
+/*!
+   \file calibration.c
+   \brief Calibration mode, see calibration.h
+*/
+#define _GNU_SOURCE
+
+#include "calibration.h"
+#include "config.h"
+#include "receiver.h"
+#include "thresholdDetection.h"
+#include "sendBit.h"
+#include "p1_spam.h"
+#include "frame.h"
+#include "utils.h"
+#include "multiLevel.h"
+#include "tsc.h"
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <immintrin.h>
+
+
+#define LEVEL_POINTS 200 // Points measured for each level
+#define SYMBOL_FRAME_POINTS (1<<14) // Largest number of points of a multi-level training frame
+#define SYMBOL_FRAME_SIZE (1 + INIT_SYMBOLS + MAX_LEVELS + DATA_FRAME_SIZE)
+
+// Swept values, from the slowest to the fastest
+static const unsigned senderReps[] = {1<<8, 1<<7};
+static const unsigned receiverReps[] = {1<<7, 1<<6};
+static const long bitDurations[] = {1000000, 750000, 500000, 350000, 250000};
+// Position of the threshold between the idle (0) and contended (1) levels
+static const double thresholdRatios[] = {0.35, 0.5, 0.65};
+
+#define COUNT(array) (sizeof(array) / sizeof(array[0]))
+#define MAX_POINTS (COUNT(senderReps) * COUNT(receiverReps) * COUNT(bitDurations) * COUNT(thresholdRatios))
+
+
+typedef struct {
+  unsigned senderRep;
+  atomic_int stop;
+} Spammer;
+
+
+typedef struct {
+  LinkProfile *profile;
+  bool sequence[REQUEST_FRAME_SIZE + 1];
+  atomic_int start;
+} TrainingSender;
+
+
+typedef struct {
+  LinkProfile *profile;
+  int levels;
+  int symbols[SYMBOL_FRAME_SIZE];
+  int symbolCount;
+  atomic_int start;
+} SymbolSender;
+
+
+
+int initCalibrationOptions(CalibrationOptions *co) {
+  co->receiverCpu = CALIBRATION_RECEIVER_CPU;
+  co->senderCpu = CALIBRATION_SENDER_CPU >= 0 ? CALIBRATION_SENDER_CPU : siblingCpu(CALIBRATION_RECEIVER_CPU);
+  co->frameCount = CALIBRATION_FRAMES;
+  co->maxBer = CALIBRATION_MAX_BER;
+  co->filterType = FILTER_NETWORK;
+  co->filterSize = 10;
+  co->filterHop = 0;
+  co->levels = SYMBOL_LEVELS;
+  if (co->senderCpu < 0) {
+    return -1; // No SMT sibling to contend the receiver from
+  }
+  return 1;
+}
+
+
+
+long elapsedNs(struct timespec *start) {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return ((long) (tp.tv_sec - start->tv_sec)) * 1000000000 + (tp.tv_nsec - start->tv_nsec);
+}
+
+
+
+int pinThread(pthread_t thread, int cpu) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if (pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset) != 0) {
+    fprintf(stderr, "Warning: cannot pin a calibration thread on CPU %i\n", cpu);
+    return -1;
+  }
+  return 1;
+}
+
+
+
+// Contends port 1 until stopped, for the contended level
+void *spamLoop(void *vargp) {
+  Spammer *spammer = (Spammer *)vargp;
+  SpamKernel spam = getSpamKernel();
+  while (!atomic_load(&spammer->stop)) {
+    spam(spammer->senderRep);
+  }
+  return NULL;
+}
+
+
+
+// Waits for the receiver, then sends an idle bit followed by the frame, like
+// the web sender does
+void *sendTrainingFrame(void *vargp) {
+  TrainingSender *sender = (TrainingSender *)vargp;
+  while (!atomic_load(&sender->start)) {
+    _mm_pause();
+  }
+  sendSequence(sender->profile->bitDuration, sender->profile->senderRep, sender->sequence, REQUEST_FRAME_SIZE + 1);
+  return NULL;
+}
+
+
+
+/*!
+   \fn int measureLevel(ListenBuffers *lb, CalibrationOptions *co, double *level, double *pointNs)
+   Median of LEVEL_POINTS filtered points, and the time each of them takes
+*/
+int measureLevel(ListenBuffers *lb, CalibrationOptions *co, double *level, double *pointNs) {
+  Filter filter;
+  unsigned int points[LEVEL_POINTS];
+  initFilter(&filter, co->filterType, co->filterSize, co->filterHop);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < LEVEL_POINTS; i++) {
+    while (!filterPush(&filter, (unsigned int) (listen(lb) / 1000000000), &points[i]));
+  }
+  *pointNs = (double) elapsedNs(&start) / LEVEL_POINTS;
+  qsort(points, LEVEL_POINTS, sizeof(unsigned int), comp);
+  *level = points[LEVEL_POINTS / 2];
+  return 1;
+}
+
+
+
+/*!
+   \fn int measureLevels(ListenBuffers *lb, CalibrationOptions *co, unsigned senderRep, double levels[2], double pointNs[2])
+   Idle (index 0) and contended (index 1) levels and times per point
+*/
+int measureLevels(ListenBuffers *lb, CalibrationOptions *co, unsigned senderRep, double levels[2], double pointNs[2]) {
+  measureLevel(lb, co, &levels[0], &pointNs[0]);
+
+  Spammer spammer;
+  spammer.senderRep = senderRep;
+  atomic_init(&spammer.stop, 0);
+  pthread_t thread;
+  pthread_create(&thread, NULL, spamLoop, (void *)&spammer);
+  pinThread(thread, co->senderCpu);
+  measureLevel(lb, co, &levels[1], &pointNs[1]);
+  atomic_store(&spammer.stop, 1);
+  pthread_join(thread, NULL);
+  return 1;
+}
+
+
+
+/*!
+   \fn int trainingFrame(ListenBuffers *lb, CalibrationOptions *co, LinkProfile *lp, int sequenceNumber, int *bitErrors, long *duration)
+   Sends a request frame from the sibling and decodes it with the candidate
+   profile.
+   \return 1 if the frame was received without error, 0 otherwise
+*/
+int trainingFrame(ListenBuffers *lb, CalibrationOptions *co, LinkProfile *lp, int sequenceNumber, int *bitErrors, long *duration) {
+  TrainingSender sender;
+  sender.profile = lp;
+  sender.sequence[0] = 0;
+  createRequestFrame(sequenceNumber, sequenceNumber ^ 0xF, &sender.sequence[1], REQUEST_FRAME_SIZE);
+  atomic_init(&sender.start, 0);
+
+  ThresholdResults tr;
+  initThresholdDetection(&tr, lp->jmpThreshold);
+  setThresholdParameters(&tr, lp->minSpike, lp->maxSpike, lp->bitSize_0, lp->bitSize_1);
+  Filter filter;
+  initFilter(&filter, co->filterType, co->filterSize, co->filterHop);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, sendTrainingFrame, (void *)&sender);
+  pinThread(thread, co->senderCpu);
+
+  // Twice the frame, plus the leading idle bit and some margin
+  long timeout = 2 * (REQUEST_FRAME_SIZE + 4) * lp->bitDuration;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  atomic_store(&sender.start, 1);
+  unsigned int point;
+  while ((tr.bitCount < REQUEST_FRAME_SIZE) & (elapsedNs(&start) < timeout)) {
+    while (!filterPush(&filter, (unsigned int) (listen(lb) / 1000000000), &point));
+    parseNewPointThreshold(point, &tr);
+  }
+  *duration = elapsedNs(&start);
+  pthread_join(thread, NULL);
+
+  int bits[REQUEST_FRAME_SIZE];
+  for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
+    bits[i] = -1; // Bits the detector did not find are errors
+  }
+  getBitsThreshold(&tr, bits);
+  *bitErrors = 0;
+  for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
+    *bitErrors += bits[i] != sender.sequence[i + 1];
+  }
+  return *bitErrors == 0;
+}
+
+
+
+// Waits for the receiver, then sends an idle symbol followed by the
+// multi-level frame
+void *sendSymbolFrame(void *vargp) {
+  SymbolSender *sender = (SymbolSender *)vargp;
+  while (!atomic_load(&sender->start)) {
+    _mm_pause();
+  }
+  sendSymbolsAt(readTsc(), sender->profile->bitDuration, sender->profile->senderRep, sender->levels, sender->symbols, sender->symbolCount, NULL);
+  return NULL;
+}
+
+
+
+/*!
+   \fn int symbolTrainingFrame(ListenBuffers *lb, CalibrationOptions *co, LinkProfile *lp, unsigned int *points, int frameNumber, int *bitErrors, long *duration)
+   Sends a data frame in multi-level symbols from the sibling, records the
+   points for the length of the frame and decodes them.
+   \return 1 if the frame was received without error, 0 otherwise
+*/
+int symbolTrainingFrame(ListenBuffers *lb, CalibrationOptions *co, LinkProfile *lp, unsigned int *points, int frameNumber, int *bitErrors, long *duration) {
+  SymbolSender sender;
+  sender.profile = lp;
+  sender.levels = co->levels;
+  bool frame[DATA_FRAME_SIZE];
+  createDataFrame('a' + frameNumber % 26, frameNumber % 16, frame, DATA_FRAME_SIZE);
+  sender.symbols[0] = 0;
+  int preambleSize = createLevelPreamble(co->levels, &sender.symbols[1]);
+  int dataSymbols = bitsToSymbols(frame, DATA_FRAME_SIZE, co->levels, &sender.symbols[1 + preambleSize]);
+  sender.symbolCount = 1 + preambleSize + dataSymbols;
+  atomic_init(&sender.start, 0);
+
+  Filter filter;
+  initFilter(&filter, co->filterType, co->filterSize, co->filterHop);
+  pthread_t thread;
+  pthread_create(&thread, NULL, sendSymbolFrame, (void *)&sender);
+  pinThread(thread, co->senderCpu);
+
+  // The frame, plus some margin
+  long timeout = (sender.symbolCount + 4) * lp->bitDuration;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  atomic_store(&sender.start, 1);
+  size_t pointCount = 0;
+  while ((pointCount < SYMBOL_FRAME_POINTS) & (elapsedNs(&start) < timeout)) {
+    while (!filterPush(&filter, (unsigned int) (listen(lb) / 1000000000), &points[pointCount]));
+    pointCount++;
+  }
+  *duration = elapsedNs(&start);
+  pthread_join(thread, NULL);
+
+  int symbols[DATA_FRAME_SIZE];
+  bool bits[DATA_FRAME_SIZE];
+  LevelResults lr;
+  int decoded = decodeLevels(points, pointCount, lp, co->levels, symbols, dataSymbols, &lr);
+  symbolsToBits(symbols, decoded > 0 ? decoded : 0, co->levels, bits, DATA_FRAME_SIZE);
+  int decodedBits = (decoded > 0 ? decoded : 0) * bitsPerSymbol(co->levels);
+  *bitErrors = 0;
+  for (int i = 0; i < DATA_FRAME_SIZE; i++) {
+    // Bits the detector did not find are errors
+    *bitErrors += (i >= decodedBits) || (bits[i] != frame[i]);
+  }
+  return *bitErrors == 0;
+}
+
+
+
+// Sends training frames in multi-level symbols with the chosen profile and
+// prints their BER and goodput
+int calibrateSymbols(ListenBuffers *lb, CalibrationOptions *co, LinkProfile *lp) {
+  unsigned int *points = malloc(SYMBOL_FRAME_POINTS * sizeof(unsigned int));
+  if (points == NULL) {
+    return -1;
+  }
+  lb->passCount = lp->receiverRep;
+  int bitErrors = 0, correctFrames = 0;
+  long duration = 0;
+  for (int f = 0; f < co->frameCount; f++) {
+    int frameErrors;
+    long frameDuration;
+    correctFrames += symbolTrainingFrame(lb, co, lp, points, f, &frameErrors, &frameDuration);
+    bitErrors += frameErrors;
+    duration += frameDuration;
+  }
+  free(points);
+  printf("%i levels per symbol: BER %.4f \t goodput %.1f bit/s (%i/%i frames)\n", co->levels,
+         (double) bitErrors / (co->frameCount * DATA_FRAME_SIZE), correctFrames * DATA_PAYLOAD_BITS / (duration / 1e9), correctFrames, co->frameCount);
+  return 1;
+}
+
+
+
+// Marks the points no other point beats on both BER and goodput
+int markPareto(CalibrationPoint points[], int pointCount) {
+  for (int i = 0; i < pointCount; i++) {
+    points[i].pareto = 1;
+    for (int j = 0; j < pointCount; j++) {
+      if ((points[j].ber <= points[i].ber) & (points[j].goodput >= points[i].goodput)
+          & ((points[j].ber < points[i].ber) | (points[j].goodput > points[i].goodput))) {
+        points[i].pareto = 0;
+        break;
+      }
+    }
+  }
+  return 1;
+}
+
+
+
+int choosePoint(CalibrationPoint points[], int pointCount, double maxBer) {
+  int best = -1;
+  for (int i = 0; i < pointCount; i++) {
+    if (!points[i].pareto | (points[i].ber > maxBer)) continue;
+    if ((best == -1) || (points[i].goodput > points[best].goodput)) best = i;
+  }
+  if (best != -1) {
+    return best;
+  }
+  // Nothing is reliable enough, take the most reliable
+  for (int i = 0; i < pointCount; i++) {
+    if (!points[i].pareto) continue;
+    if ((best == -1) || (points[i].ber < points[best].ber)) best = i;
+  }
+  return best;
+}
+
+
+
+int calibrateLink(CalibrationOptions *co, LinkProfile *best, CalibrationPoint *bestPoint) {
+  CalibrationPoint *points = calloc(MAX_POINTS, sizeof(CalibrationPoint));
+  int pointCount = 0;
+  ListenBuffers lb;
+  if ((points == NULL) || (initListenBuffers(&lb, 0) == -1)) {
+    free(points);
+    return -1;
+  }
+
+  // The receiver side runs in this thread
+  cpu_set_t previousCpus;
+  pthread_getaffinity_np(pthread_self(), sizeof(previousCpus), &previousCpus);
+  pinThread(pthread_self(), co->receiverCpu);
+
+  printf("Calibrating on CPUs %i (receiver) and %i (sender), %i training frames per configuration\n",
+         co->receiverCpu, co->senderCpu, co->frameCount);
+  printf("bit (ns)\tsender\treceiver\tthreshold\tbit size 0/1\tspikes\tBER\tgoodput (bit/s)\n");
+  for (size_t s = 0; s < COUNT(senderReps); s++) {
+    for (size_t r = 0; r < COUNT(receiverReps); r++) {
+      double levels[2], pointNs[2];
+      lb.passCount = receiverReps[r];
+      measureLevels(&lb, co, senderReps[s], levels, pointNs);
+      if (levels[1] <= levels[0] * (1 + CALIBRATION_MIN_GAP)) {
+        printf("-\t\t%u\t%u\t\tno contention visible (idle %.0f, contended %.0f), skipped\n",
+               senderReps[s], receiverReps[r], levels[0], levels[1]);
+        continue;
+      }
+
+      for (size_t b = 0; b < COUNT(bitDurations); b++) {
+        LinkProfile lp;
+        lp.bitDuration = bitDurations[b];
+        lp.senderRep = senderReps[s];
+        lp.receiverRep = receiverReps[r];
+        lp.bitSize_0 = bitDurations[b] / pointNs[0];
+        lp.bitSize_1 = bitDurations[b] / pointNs[1];
+        double smallest = fmin(lp.bitSize_0, lp.bitSize_1);
+        if (smallest < 2.) { // A bit must hold at least two points to tell it from a spike
+          printf("%ld\t\t%u\t%u\t\t-\t\t%.1f/%.1f\t\ttoo few points per bit, skipped\n",
+                 lp.bitDuration, lp.senderRep, lp.receiverRep, lp.bitSize_0, lp.bitSize_1);
+          continue;
+        }
+        lp.minSpike = smallest / 2 < 1 ? 1 : (int) (smallest / 2);
+        lp.maxSpike = (int) ceil(2 * fmax(lp.bitSize_0, lp.bitSize_1));
+
+        for (size_t t = 0; t < COUNT(thresholdRatios); t++) {
+          lp.jmpThreshold = (int) (levels[0] + thresholdRatios[t] * (levels[1] - levels[0]));
+          int bitErrors = 0, correctFrames = 0;
+          long duration = 0;
+          for (int f = 0; f < co->frameCount; f++) {
+            int frameErrors;
+            long frameDuration;
+            correctFrames += trainingFrame(&lb, co, &lp, f % 16, &frameErrors, &frameDuration);
+            bitErrors += frameErrors;
+            duration += frameDuration;
+          }
+
+          CalibrationPoint *point = &points[pointCount++];
+          point->profile = lp;
+          point->ber = (double) bitErrors / (co->frameCount * REQUEST_FRAME_SIZE);
+          point->goodput = correctFrames * REQUEST_PAYLOAD_BITS / (duration / 1e9);
+          point->correctFrames = correctFrames;
+          printf("%ld\t\t%u\t%u\t\t%i\t\t%.1f/%.1f\t\t%i-%i\t%.4f\t%.1f\n", lp.bitDuration, lp.senderRep, lp.receiverRep,
+                 lp.jmpThreshold, lp.bitSize_0, lp.bitSize_1, lp.minSpike, lp.maxSpike, point->ber, point->goodput);
+        }
+      }
+    }
+  }
+  int ret = -1;
+  if (pointCount > 0) {
+    markPareto(points, pointCount);
+    printf("Pareto front:\n");
+    for (int i = 0; i < pointCount; i++) {
+      if (points[i].pareto) {
+        printf("\tBER %.4f \t goodput %.1f bit/s \t bit duration %ld ns\n", points[i].ber, points[i].goodput, points[i].profile.bitDuration);
+      }
+    }
+    *bestPoint = points[choosePoint(points, pointCount, co->maxBer)];
+    *best = bestPoint->profile;
+    ret = 1;
+    if (co->levels > 2) {
+      calibrateSymbols(&lb, co, best);
+    }
+  }
+  pthread_setaffinity_np(pthread_self(), sizeof(previousCpus), &previousCpus);
+  free(lb.timings);
+  free(lb.differences);
+  free(points);
+  return ret;
+}
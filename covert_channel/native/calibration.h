@@ -0,0 +1,73 @@
+/*!
+   \file calibration.h
+   \brief Calibration mode: searches the fastest reliable link profile.
+          The native sender and receiver are run in loopback, on two SMT
+          siblings. For every combination of SENDER_REP and RECEIVER_REP, we
+          first measure the idle and contended levels and the time per point,
+          which give the candidate thresholds, bit sizes and spike sizes. Then
+          for every bit duration and threshold, known training request frames
+          are sent and decoded by the threshold detector, giving the bit error
+          rate and the goodput of the configuration.
+          The chosen configuration is the Pareto optimal one (lower BER, higher
+          goodput) with the highest goodput among the ones below the maximal
+          BER, or with the lowest BER if none is.
+          With multi-level symbols, training data frames are then sent with the
+          chosen profile, one symbol per bit duration, to report their BER and
+          goodput.
+*/
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include "linkProfile.h"
+#include "filter.h"
+
+#include <stddef.h>
+
+
+typedef struct {
+  int receiverCpu;
+  int senderCpu; // SMT sibling of receiverCpu
+  int frameCount; // Training frames per configuration
+  double maxBer; // Highest acceptable bit error rate
+  FilterType filterType; // Filter of the receiver, the bit sizes depend on it
+  size_t filterSize;
+  size_t filterHop;
+  int levels; // Levels per symbol, above 2 the chosen profile is also tried with multi-level symbols
+} CalibrationOptions;
+
+
+/*!
+   \struct CalibrationPoint
+   \brief Result of the training frames for one configuration
+*/
+typedef struct {
+  LinkProfile profile;
+  double ber; // Bit errors over sent bits, bits of lost frames are all errors
+  double goodput; // Payload bits (REQUEST_PAYLOAD_BITS) of correct frames per second
+  int correctFrames;
+  int pareto; // 1 if no other point has both a lower BER and a higher goodput
+} CalibrationPoint;
+
+
+
+/*!
+   \fn int initCalibrationOptions(CalibrationOptions *co)
+   \brief Sets the defaults of config.h
+   \return 1 if ok, -1 if CALIBRATION_RECEIVER_CPU has no SMT sibling for the
+           sender
+*/
+int initCalibrationOptions(CalibrationOptions *co);
+
+
+
+/*!
+   \fn int calibrateLink(CalibrationOptions *co, LinkProfile *best, CalibrationPoint *bestPoint)
+   \brief Runs the whole sweep, printing every configuration
+   \param[out] best Chosen profile
+   \param[out] bestPoint Its measured BER and goodput
+   \return 1 if a profile was chosen, -1 if no configuration could be tested
+*/
+int calibrateLink(CalibrationOptions *co, LinkProfile *best, CalibrationPoint *bestPoint);
+
+#endif
@@ -0,0 +1,325 @@
+/*!
+   \file channelSim.c
+   \brief Simulated port contention channel, see channelSim.h
+*/
+
+#include "channelSim.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+
+#define GAUSSIAN_TABLE_SIZE 4096 // Standard normal samples, drawn by index
+
+static const char *modelNames[] = {"clean", "noisy", "drift", "bursts", "load", "hostile"};
+
+static double gaussianTable[GAUSSIAN_TABLE_SIZE];
+static pthread_once_t tableOnce = PTHREAD_ONCE_INIT;
+
+
+static uint64_t nextRandom(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+// Uniform in [0, 1)
+static double uniform(uint64_t *state) {
+  return (nextRandom(state) >> 11) * 0x1p-53;
+}
+
+static double exponential(uint64_t *state, double mean) {
+  return -mean * log(1. - uniform(state));
+}
+
+// A pass only costs a table lookup, the samples are drawn once by Box-Muller
+static void buildGaussianTable() {
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (int i = 0; i < GAUSSIAN_TABLE_SIZE; i += 2) {
+    double radius = sqrt(-2. * log(1. - uniform(&state)));
+    double angle = 2. * M_PI * uniform(&state);
+    gaussianTable[i] = radius * cos(angle);
+    gaussianTable[i + 1] = radius * sin(angle);
+  }
+}
+
+
+
+int initChannelModel(ChannelModel *model, const char *name) {
+  // 288 ticks per pass give points of 1237 (288 * 2^32 / 1e9), 358 give 1537:
+  // with 128 passes a listen() and 10 listen() a point, 5 and 4 points a bit
+  ChannelModel clean = {
+    .ticksPerNs = 1.8,
+    .idleTicks = 280.,
+    .contendedTicks = 350.,
+    .noiseTicks = 20.,
+    .gapTicks = 8.
+  };
+  bool known = false;
+  for (size_t i = 0; i < sizeof(modelNames) / sizeof(modelNames[0]); i++) {
+    known |= strcmp(name, modelNames[i]) == 0;
+  }
+  if (!known) {
+    return -1;
+  }
+  *model = clean;
+  bool hostile = strcmp(name, "hostile") == 0;
+  if (hostile || (strcmp(name, "noisy") == 0)) {
+    model->noiseTicks = hostile ? 150. : 220.;
+  }
+  if (hostile || (strcmp(name, "drift") == 0)) {
+    model->driftAmplitude = 0.06;
+    model->driftPeriodNs = 10e9;
+  }
+  if (hostile || (strcmp(name, "bursts") == 0)) {
+    model->burstRate = 50.;
+    model->burstPasses = 1000.;
+    model->burstTicks = 400.;
+  }
+  if (hostile || (strcmp(name, "load") == 0)) {
+    model->loadBusyNs = 2e6;
+    model->loadIdleNs = 8e6;
+    model->loadLevel = 0.3;
+  }
+  return 1;
+}
+
+
+
+int initChannelSim(ChannelSim *sim, ChannelModel *model, uint64_t seed) {
+  pthread_once(&tableOnce, buildGaussianTable);
+  memset(sim, 0, sizeof(*sim));
+  sim->model = *model;
+  sim->rng = seed != 0 ? seed : 1;
+  sim->levelCount = 2;
+  sim->loadToggle = model->loadBusyNs > 0. ? exponential(&sim->rng, model->loadIdleNs) : INFINITY;
+  sim->nextBurst = model->burstRate > 0. ? exponential(&sim->rng, 1e9 / model->burstRate) : INFINITY;
+  return 1;
+}
+
+
+
+double simNowNs(ChannelSim *sim) {
+  return sim->tsc / sim->model.ticksPerNs;
+}
+
+
+
+int simScheduleSequence(ChannelSim *sim, double startNs, long bitDuration, bool *sequence, int sequenceSize) {
+  int symbols[SIM_MAX_SYMBOLS];
+  if (sequenceSize > SIM_MAX_SYMBOLS) {
+    return -1;
+  }
+  for (int i = 0; i < sequenceSize; i++) {
+    symbols[i] = sequence[i];
+  }
+  return simScheduleSymbols(sim, startNs, bitDuration, 2, symbols, sequenceSize);
+}
+
+
+
+int simScheduleSymbols(ChannelSim *sim, double startNs, long symbolDuration, int levelCount, int *symbols, int symbolCount) {
+  if ((symbolCount > SIM_MAX_SYMBOLS) || (levelCount < 2)) {
+    return -1;
+  }
+  sim->scheduleStart = startNs;
+  sim->bitDuration = symbolDuration;
+  sim->levelCount = levelCount;
+  memcpy(sim->symbols, symbols, symbolCount * sizeof(int));
+  sim->symbolCount = symbolCount;
+  return 1;
+}
+
+
+
+// Whether the sender spams port 1 at time ns, and until when
+static bool senderContends(ChannelSim *sim, double ns, double *until) {
+  double sinceStart = ns - sim->scheduleStart;
+  if (sinceStart < 0.) {
+    *until = sim->scheduleStart;
+    return false;
+  }
+  if (sinceStart >= (double) sim->symbolCount * sim->bitDuration) {
+    *until = INFINITY;
+    return false;
+  }
+  long symbolIndex = (long) (sinceStart / sim->bitDuration);
+  double symbolStart = sim->scheduleStart + (double) symbolIndex * sim->bitDuration;
+  *until = symbolStart + sim->bitDuration;
+  int level = sim->symbols[symbolIndex];
+  if ((level <= 0) || (level >= sim->levelCount - 1)) {
+    return level > 0;
+  }
+  // Duty cycled level, see sendSymbolsAt
+  double periodStart = symbolStart + floor((ns - symbolStart) / SYMBOL_DUTY_PERIOD) * SYMBOL_DUTY_PERIOD;
+  double activeEnd = periodStart + (double) SYMBOL_DUTY_PERIOD * level / (sim->levelCount - 1);
+  double periodEnd = periodStart + SYMBOL_DUTY_PERIOD;
+  bool active = ns < activeEnd;
+  double change = active ? activeEnd : periodEnd;
+  if (change < *until) *until = change;
+  return active;
+}
+
+
+
+/*!
+   \struct SimRun
+   \brief Passes of constant state, until untilTsc or runEnd passes
+*/
+typedef struct {
+  double idle; // Mean duration of a pass not contended by the load
+  double busy; // Same when the load contends it
+  uint64_t loadThreshold; // Probability for a pass to be contended by the load, on 32 bits
+  double untilTsc;
+  size_t runEnd;
+} SimRun;
+
+
+
+// Updates the load and the bursts at the current time, and starts a run there
+static void beginRun(ChannelSim *sim, size_t pass, size_t passCount, SimRun *run) {
+  ChannelModel *model = &sim->model;
+  double ns = simNowNs(sim);
+  while (ns >= sim->loadToggle) {
+    sim->loadBusy = !sim->loadBusy;
+    sim->loadToggle += exponential(&sim->rng, sim->loadBusy ? model->loadBusyNs : model->loadIdleNs);
+  }
+  if (ns >= sim->nextBurst) {
+    sim->burstLeft = 1 + (long) exponential(&sim->rng, model->burstPasses);
+    sim->nextBurst = ns + exponential(&sim->rng, 1e9 / model->burstRate);
+  }
+
+  double until;
+  bool contended = senderContends(sim, ns, &until);
+  if (sim->loadToggle < until) until = sim->loadToggle;
+  if (sim->nextBurst < until) until = sim->nextBurst;
+  run->untilTsc = until * model->ticksPerNs;
+  run->runEnd = passCount;
+  if ((sim->burstLeft > 0) && (pass + sim->burstLeft < run->runEnd)) run->runEnd = pass + sim->burstLeft;
+
+  double drift = 1.;
+  if (model->driftAmplitude != 0.) {
+    drift += model->driftAmplitude * sin(2. * M_PI * ns / model->driftPeriodNs);
+  }
+  double offset = sim->burstLeft > 0 ? model->burstTicks : 0.;
+  run->idle = (contended ? model->contendedTicks : model->idleTicks) * drift + offset;
+  run->busy = model->contendedTicks * drift + offset;
+  run->loadThreshold = sim->loadBusy ? (uint64_t) (model->loadLevel * 4294967296.) : 0;
+}
+
+
+
+int simulateTimings(ChannelSim *sim, uint64_t *buffer, size_t passCount) {
+  size_t pass = 0;
+  SimRun run;
+  while (pass < passCount) {
+    beginRun(sim, pass, passCount, &run);
+
+    // Local copies, this is the hot loop
+    size_t runStart = pass, runEnd = run.runEnd;
+    double tsc = sim->tsc, noise = sim->model.noiseTicks, gap = sim->model.gapTicks;
+    double idle = run.idle, busy = run.busy, untilTsc = run.untilTsc;
+    uint64_t loadThreshold = run.loadThreshold;
+    uint64_t random = sim->rng;
+    do {
+      random ^= random << 13;
+      random ^= random >> 7;
+      random ^= random << 17;
+      double duration = ((random >> 32) < loadThreshold ? busy : idle) + noise * gaussianTable[random % GAUSSIAN_TABLE_SIZE];
+      uint64_t start = (uint64_t) tsc;
+      tsc += duration > 1. ? duration : 1.;
+      buffer[pass++] = ((uint64_t) tsc << 32) | (start & 0xFFFFFFFF);
+      tsc += gap;
+    } while ((pass < runEnd) && (tsc < untilTsc));
+    sim->tsc = tsc;
+    sim->rng = random;
+
+    if (sim->burstLeft > 0) sim->burstLeft -= pass - runStart;
+  }
+  return 1;
+}
+
+
+
+// Mean and variance of max(X, 1) for X of mean mean and deviation noise, as
+// simulateTimings clamps the durations
+static void clampedMoments(double mean, double noise, double *clampedMean, double *variance) {
+  if (noise <= 0.) {
+    *clampedMean = mean > 1. ? mean : 1.;
+    *variance = 0.;
+    return;
+  }
+  double alpha = (1. - mean) / noise;
+  double below = 0.5 * erfc(-alpha / M_SQRT2); // P(X < 1)
+  double density = exp(-0.5 * alpha * alpha) / sqrt(2. * M_PI);
+  double m = below + mean * (1. - below) + noise * density;
+  double square = below + (mean * mean + noise * noise) * (1. - below) + noise * (mean + 1.) * density;
+  *clampedMean = m;
+  *variance = square > m * m ? square - m * m : 0.;
+}
+
+
+
+// Total duration (with the gaps) of count passes of a run, one Gaussian draw
+static double drawRun(ChannelSim *sim, SimRun *run, size_t count) {
+  double idleMean, idleVariance, busyMean, busyVariance;
+  double noise = sim->model.noiseTicks;
+  clampedMoments(run->idle, noise, &idleMean, &idleVariance);
+  double load = run->loadThreshold * 0x1p-32;
+  double mean = idleMean, variance = idleVariance;
+  if (load > 0.) {
+    // Mixture of the passes contended by the load and the others
+    clampedMoments(run->busy, noise, &busyMean, &busyVariance);
+    mean = load * busyMean + (1. - load) * idleMean;
+    variance = load * (busyVariance + busyMean * busyMean) + (1. - load) * (idleVariance + idleMean * idleMean) - mean * mean;
+  }
+  double gaussian = gaussianTable[nextRandom(&sim->rng) % GAUSSIAN_TABLE_SIZE];
+  double total = count * mean + sqrt(count * (variance > 0. ? variance : 0.)) * gaussian;
+  return (total > count ? total : count) + count * sim->model.gapTicks;
+}
+
+
+
+uint64_t simulateListen(ChannelSim *sim, size_t passCount) {
+  if (passCount < 2) {
+    return 0;
+  }
+  // The first pass is drawn, the sum of the differences telescopes from its end
+  uint64_t first;
+  simulateTimings(sim, &first, 1);
+
+  size_t pass = 1;
+  SimRun run;
+  while (pass < passCount) {
+    beginRun(sim, pass, passCount, &run);
+    // Passes until the state changes, at the mean duration of a pass
+    size_t count = run.runEnd - pass;
+    double passTicks = (run.loadThreshold > 0 ? run.busy : run.idle) + sim->model.gapTicks;
+    double left = (run.untilTsc - sim->tsc) / (passTicks > 1. ? passTicks : 1.);
+    if (left < count) count = left > 1. ? (size_t) ceil(left) : 1;
+    sim->tsc += drawRun(sim, &run, count);
+    pass += count;
+    if (sim->burstLeft > 0) sim->burstLeft -= count;
+  }
+
+  // Same as average() on the words: the ends (low 32 bits of the TSC) in the
+  // high half, the starts in the low half are far below what listen() keeps
+  uint64_t ends = ((uint64_t) (sim->tsc - sim->model.gapTicks) - (first >> 32)) & 0xFFFFFFFF;
+  return (ends << 32) / passCount - 1;
+}
+
+
+
+int printChannelModel(ChannelModel *model) {
+  printf("Pass: idle %.0f ticks, contended %.0f ticks, noise %.0f ticks, %.2f ticks/ns\n",
+         model->idleTicks, model->contendedTicks, model->noiseTicks, model->ticksPerNs);
+  if (model->driftAmplitude != 0.) printf("Drift: %.1f%% over %.1f s\n", 100. * model->driftAmplitude, model->driftPeriodNs / 1e9);
+  if (model->burstRate > 0.) printf("Bursts: %.0f/s of %.0f passes, +%.0f ticks\n", model->burstRate, model->burstPasses, model->burstTicks);
+  if (model->loadBusyNs > 0.) printf("Load: %.1f ms busy every %.1f ms, %.0f%% of the passes\n", model->loadBusyNs / 1e6, (model->loadBusyNs + model->loadIdleNs) / 1e6, 100. * model->loadLevel);
+  return 1;
+}
@@ -0,0 +1,148 @@
+/*!
+   \file channelSim.h
+   \brief Software model of the port contention channel, to run the receiver
+          without an SMT sibling.
+          simulateTimings replaces read_timings_n: it writes the same words
+          (start TSC in the low 32 bits, end in the high 32 bits) for passes
+          whose duration follows the model. A pass takes idleTicks, or
+          contendedTicks while the sender spams, plus Gaussian noise. The
+          durations drift over time, and outlier bursts and a background
+          load come and go at random.
+          The sender is a schedule of bits or multi-level symbols, laid out
+          like sendSequenceAt and sendSymbolsAt do: symbol i ends at start +
+          (i+1) * bitDuration, and level k of L is contended during k/(L-1)
+          of every SYMBOL_DUTY_PERIOD.
+          Time is simulated: it only advances with the passes, so a frame is
+          received as fast as the detector runs. The state of the sender, the
+          bursts and the load is only updated between runs of passes where it
+          is constant, a pass then costs a random number and a table lookup.
+          listen() does not need the passes themselves, simulateListen draws
+          their average directly unless a trace records them (or everyPass
+          is set).
+*/
+
+#ifndef CHANNELSIM_H
+#define CHANNELSIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_MAX_SYMBOLS 512
+
+
+/*!
+   \struct ChannelModel
+   \brief Parameters of the simulated channel, durations in TSC ticks
+*/
+typedef struct {
+  double ticksPerNs; // TSC rate
+  double idleTicks; // Mean duration of a pass without contention
+  double contendedTicks; // Same while port 1 is contended
+  double noiseTicks; // Standard deviation of the duration of a pass
+  double gapTicks; // Between the end of a pass and the start of the next one
+  double driftAmplitude; // Largest relative change of the durations, a slow sine
+  double driftPeriodNs; // Period of the drift
+  double burstRate; // Outlier bursts per simulated second
+  double burstPasses; // Mean number of passes in a burst
+  double burstTicks; // Added to the passes of a burst
+  double loadBusyNs; // Mean busy period of the background load, 0 for none
+  double loadIdleNs; // Mean idle period between two busy ones
+  double loadLevel; // Fraction of the passes contended by the load when busy
+} ChannelModel;
+
+
+/*!
+   \struct ChannelSim
+   \brief State of a simulated channel, a single listener uses it
+*/
+typedef struct {
+  ChannelModel model;
+  uint64_t rng; // xorshift64 state
+  bool everyPass; // listen() draws every pass, as when a trace records them
+  double tsc; // Simulated TSC, starts at 0
+  // Sender schedule
+  double scheduleStart; // ns
+  long bitDuration; // ns
+  int levelCount;
+  int symbols[SIM_MAX_SYMBOLS];
+  int symbolCount;
+  // Outlier burst and background load in progress
+  long burstLeft; // Passes
+  double nextBurst; // ns at which the next burst starts
+  bool loadBusy;
+  double loadToggle; // ns at which the load changes state
+} ChannelSim;
+
+
+
+/*!
+   \fn int initChannelModel(ChannelModel *model, const char *name)
+   \brief Sets a preset model: "clean", "noisy", "drift", "bursts", "load" or
+          "hostile" (all of them). The durations are chosen so the default
+          link profile sees about BIT_SIZE_0 and BIT_SIZE_1 points per bit,
+          on each side of JMP_THRESHOLD.
+   \return 1 if ok, -1 if the name is unknown
+*/
+int initChannelModel(ChannelModel *model, const char *name);
+
+
+
+/*!
+   \fn int initChannelSim(ChannelSim *sim, ChannelModel *model, uint64_t seed)
+   \brief Starts a simulation at time 0, with an idle sender
+*/
+int initChannelSim(ChannelSim *sim, ChannelModel *model, uint64_t seed);
+
+
+
+/*!
+   \fn double simNowNs(ChannelSim *sim)
+   \return Simulated time, in ns
+*/
+double simNowNs(ChannelSim *sim);
+
+
+
+/*!
+   \fn int simScheduleSequence(ChannelSim *sim, double startNs, long bitDuration, bool *sequence, int sequenceSize)
+   \brief Replaces the sender schedule by the bits of sendSequenceAt, the
+          first one starting at startNs (simulated)
+   \return 1 if ok, -1 if the sequence is longer than SIM_MAX_SYMBOLS
+*/
+int simScheduleSequence(ChannelSim *sim, double startNs, long bitDuration, bool *sequence, int sequenceSize);
+
+
+
+/*!
+   \fn int simScheduleSymbols(ChannelSim *sim, double startNs, long symbolDuration, int levelCount, int *symbols, int symbolCount)
+   \brief Same with the multi-level symbols of sendSymbolsAt
+*/
+int simScheduleSymbols(ChannelSim *sim, double startNs, long symbolDuration, int levelCount, int *symbols, int symbolCount);
+
+
+
+/*!
+   \fn int simulateTimings(ChannelSim *sim, uint64_t *buffer, size_t passCount)
+   \brief Simulated read_timings_n: writes passCount words in buffer
+*/
+int simulateTimings(ChannelSim *sim, uint64_t *buffer, size_t passCount);
+
+
+
+/*!
+   \fn uint64_t simulateListen(ChannelSim *sim, size_t passCount)
+   \brief Fast path of listen() on the simulated channel: returns the average
+          computeDifferences and average would give on passCount passes of
+          simulateTimings, without drawing them. The passes of a run of
+          constant state add up to one Gaussian draw, of the mean and
+          variance of a pass (clamped like simulateTimings does) times their
+          number. The first pass is drawn as usual.
+*/
+uint64_t simulateListen(ChannelSim *sim, size_t passCount);
+
+
+
+int printChannelModel(ChannelModel *model);
+
+#endif
@@ -2,13 +2,27 @@
 #define CONFIG_H
 
 #define DEBUG 0 // Set to 1 for a lot of prints, data output etc
-#define PHY_CORE 4 // Number of physical cores, change it for your setup
-#define DATA_FRAME_SIZE 21 // Bit size of a data frame
-#define REQUEST_FRAME_SIZE 12 // Bit size of a request frame
+#define STAGE_PROFILING 0 // Set to 1 to record latency histograms of the hot path stages (-S), see stageProfile.h
+#define MAX_PHY_CORE 64 // Most physical cores used, the actual ones are read from sysfs (see topology.h)
+#define DATA_FRAME_SIZE 21 // Bit size of a data frame, before its convolutional code
+#define FEC_MODE 0 // Code of the data frames (-F): 0 Berger code only, 1 convolutional rate 1/2, 2 rate 2/3, see convCode.h
+#define REQUEST_FRAME_SIZE 20 // Bit size of a request frame
+// Correct a single bit error in one field of a request frame at most, 0 to only
+// detect errors. Off by default: on benchSim, the hostile model goes from 54% to
+// 59% of correct frames, but from 5% to 7% of wrong frames taken as valid (10%
+// when both fields may be corrected), and a wrong request acknowledges frames.
+#define HAMMING_CORRECTION 0
+
+// Soft decisions on the request frames, see softDecision.h
+#define SOFT_DECISION 1 // Decode from the bit log-likelihoods of the detectors, 0 for their hard bits
+#define SOFT_MAX_LLR 16. // Largest magnitude of a bit log-likelihood
+#define SOFT_MIN_MARGIN 4. // Smallest metric gap between the two most likely codewords of a field
+#define SOFT_MAX_FLIPPED 4. // Largest sum of the LLR magnitudes of the bits it flips from the hard decisions
 
 
 //Number of repetition of the spam function when we receive bits
 #define RECEIVER_REP (1<<7)
+#define MAX_RECEIVER_REP (1<<10) // Largest value a link profile may use
 
 //Number of repetition of the spam function when we send bits
 #define SENDER_REP (1<<8)
@@ -18,6 +32,53 @@
 #define REQUEST_TIMEOUT 50*1000000 // ns
 #define BIT_DURATION (1000000) //in ns
 
+// The sender ends each bit on a precomputed TSC deadline (see sendBit.c)
+#define SENDER_EDGE_TOLERANCE 2000 // ns, longest spam burst between two deadline checks
+#define SENDER_START_LEAD 200000 // ns between waking the senders and the first bit edge
+
+// Multi-level symbols (-L), see multiLevel.h
+#define SYMBOL_LEVELS 2 // Levels per symbol, 2 is the binary channel
+#define SYMBOL_DUTY_PERIOD 5000 // ns, period of the duty cycle of intermediate levels
+
+// The values above (and the threshold detector ones) are only defaults, a
+// calibrated link profile loaded at startup overrides them (see linkProfile.h)
+#define LINK_PROFILE_PATH "link.profile"
+
+
+// Sliding window transport, see transport.h
+#define ARQ_WINDOW 4 // Data frames sent per request (-W), stop-and-wait with 1
+#define ARQ_MAX_WINDOW 5 // The cumulative ack and the 4 bits of selective ack of a request
+#define ARQ_FRAME_GAP 2 // Idle bits between two data frames, so the receiver resynchronizes
+#define ARQ_RETRANSMIT_TIMEOUT 16 // In bit durations, an unacknowledged frame is only sent
+                                  // again once it is this old
+
+
+
+// Pipelined receiver (-p)
+#define RING_SIZE (1<<12) // Timings buffered between a listener and the detection thread
+#define CONSUMER_CPU -1 // Logical CPU of the detection thread, on a physical core without
+                        // listener. -1 takes a free core, or the one of the last listener.
+
+
+
+// Calibration mode (-c), see calibration.h
+#define CALIBRATION_RECEIVER_CPU 0
+#define CALIBRATION_SENDER_CPU -1 // Must be the SMT sibling of CALIBRATION_RECEIVER_CPU, -1 finds it in the topology
+#define CALIBRATION_FRAMES 8 // Training frames per configuration
+#define CALIBRATION_MAX_BER 0.01 // Highest acceptable bit error rate
+#define CALIBRATION_MIN_GAP 0.05 // Smallest relative gap between idle and contended levels
+
+
+
+// DenStream detector (-d denstream), same as the defaults of
+// offlineDenStreamDetection in the web receiver. They need dense points: with
+// the default link profile, run it with a filter window of 2 (-w 2)
+#define DS_X_WEIGHT 20. // Distance between two successive points on the x axis
+#define DS_LAMBDA 0.1
+#define DS_EPS 150.
+#define DS_BETA 0.5
+#define DS_MU 2.
+
 
 
 // CODES
@@ -0,0 +1,142 @@
+/*!
+   \file convCode.c
+   \brief Convolutional code, see convCode.h
+*/
+
+#include "convCode.h"
+
+#include <stdint.h>
+#include <pthread.h>
+
+
+#define ERASED 2 // Received symbol of a punctured output
+#define LANE_HIGH 0x8080808080808080ULL // Guard bit of each metric byte
+#define START_PENALTY 0x20 // Metric of the states the encoder does not start from
+
+// A state is the last CONV_TAIL input bits, the newest in the lowest bit.
+// The metrics of states 0 to 7 are the bytes of the low word, 8 to 15 the
+// high one. State 2j + u has predecessors j (low byte j) and j + 8 (high byte
+// j), for the input bit u.
+
+// Branch metrics of both predecessors of each state, indexed by the received
+// symbols of the step (3 * a + b, each 0, 1 or ERASED) and the input bit
+static uint64_t branchTable[9][2][2];
+static pthread_once_t tableOnce = PTHREAD_ONCE_INIT;
+
+
+static int outputBit(int shiftRegister, int polynomial) {
+  return __builtin_parity(shiftRegister & polynomial);
+}
+
+static int symbolDistance(int expected, int received) {
+  return received == ERASED ? 0 : expected != received;
+}
+
+static void buildBranchTable() {
+  for (int a = 0; a <= ERASED; a++) {
+    for (int b = 0; b <= ERASED; b++) {
+      for (int u = 0; u < 2; u++) {
+        for (int half = 0; half < 2; half++) {
+          uint64_t metrics = 0;
+          for (int j = 0; j < CONV_STATES / 2; j++) {
+            int shiftRegister = ((j + half * CONV_STATES / 2) << 1) | u;
+            uint64_t distance = symbolDistance(outputBit(shiftRegister, CONV_POLY_A), a) + symbolDistance(outputBit(shiftRegister, CONV_POLY_B), b);
+            metrics |= distance << (8 * j);
+          }
+          branchTable[3 * a + b][u][half] = metrics;
+        }
+      }
+    }
+  }
+}
+
+// Bytes 0 to 3 of x in the even bytes of the result
+static uint64_t spreadBytes(uint64_t x) {
+  x &= 0xFFFFFFFFULL;
+  x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+  x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+  return x;
+}
+
+// Whether the second output of a step is sent
+static bool sendsSecondOutput(int step, int fecMode) {
+  return (fecMode == FEC_RATE_1_2) || (step % 2 == 0);
+}
+
+
+
+int convCodedSize(int bitCount, int fecMode) {
+  int steps = bitCount + CONV_TAIL;
+  if ((bitCount < 0) || (steps > CONV_MAX_STEPS)) {
+    return -1;
+  }
+  switch (fecMode) {
+    case FEC_RATE_1_2: return 2 * steps;
+    case FEC_RATE_2_3: return steps + (steps + 1) / 2;
+    default: return -1;
+  }
+}
+
+
+
+int convEncode(bool *bits, int bitCount, int fecMode, bool *coded) {
+  if (convCodedSize(bitCount, fecMode) == -1) {
+    return -1;
+  }
+  int state = 0, codedCount = 0;
+  for (int step = 0; step < bitCount + CONV_TAIL; step++) {
+    int shiftRegister = (state << 1) | (step < bitCount ? bits[step] : 0);
+    coded[codedCount++] = outputBit(shiftRegister, CONV_POLY_A);
+    if (sendsSecondOutput(step, fecMode)) {
+      coded[codedCount++] = outputBit(shiftRegister, CONV_POLY_B);
+    }
+    state = shiftRegister & (CONV_STATES - 1);
+  }
+  return codedCount;
+}
+
+
+
+int convDecode(bool *coded, int bitCount, int fecMode, bool *bits) {
+  if (convCodedSize(bitCount, fecMode) == -1) {
+    return -1;
+  }
+  pthread_once(&tableOnce, buildBranchTable);
+
+  int steps = bitCount + CONV_TAIL;
+  uint64_t decisions[CONV_MAX_STEPS][2]; // Guard bit set if the predecessor is j + 8
+  uint64_t low = START_PENALTY * 0x0101010101010100ULL; // The encoder starts in state 0
+  uint64_t high = START_PENALTY * 0x0101010101010101ULL;
+  int codedCount = 0;
+
+  for (int step = 0; step < steps; step++) {
+    int a = coded[codedCount++];
+    int b = sendsSecondOutput(step, fecMode) ? coded[codedCount++] : ERASED;
+    uint64_t (*branches)[2] = branchTable[3 * a + b];
+
+    uint64_t survivors[2];
+    for (int u = 0; u < 2; u++) {
+      uint64_t fromLow = low + branches[u][0];
+      uint64_t fromHigh = high + branches[u][1];
+      // Guard bit set where fromHigh >= fromLow, the metrics never borrow
+      uint64_t keepLow = ((fromHigh | LANE_HIGH) - fromLow) & LANE_HIGH;
+      uint64_t mask = (keepLow >> 7) * 0xFF;
+      survivors[u] = (fromLow & mask) | (fromHigh & ~mask);
+      decisions[step][u] = ~keepLow & LANE_HIGH;
+    }
+    // State 2j + u comes from byte j of survivors[u]
+    low = spreadBytes(survivors[0]) | (spreadBytes(survivors[1]) << 8);
+    high = spreadBytes(survivors[0] >> 32) | (spreadBytes(survivors[1] >> 32) << 8);
+  }
+
+  // The tail brings the encoder back to state 0
+  int state = 0;
+  for (int step = steps - 1; step >= 0; step--) {
+    int u = state & 1, j = state >> 1;
+    if (step < bitCount) {
+      bits[step] = u;
+    }
+    state = j + ((decisions[step][u] >> (8 * j + 7)) & 1) * (CONV_STATES / 2);
+  }
+  return low & 0xFF;
+}
@@ -0,0 +1,63 @@
+/*!
+   \file convCode.h
+   \brief Convolutional code of the data frames (FEC_MODE, -F): constraint
+          length 5, generators 023 and 035 (octal), free distance 7.
+          At rate 1/2 both outputs are sent for each input bit. At rate 2/3
+          the second output of every other bit is punctured, i.e. not sent.
+          CONV_TAIL zeros are appended to the input so the encoder ends in
+          state 0.
+          Decoding is a hard-decision Viterbi decoder. The 16 path metrics
+          are bytes of two 64 bit words, one per half of the states. Each
+          trellis step looks up the branch metrics of every state in a table
+          indexed by the received symbols. It then does the add-compare-select
+          of 8 states at once with SWAR arithmetic, and packs the survivor
+          decisions into two words.
+*/
+
+#ifndef CONVCODE_H
+#define CONVCODE_H
+
+#include <stdbool.h>
+
+#define CONV_CONSTRAINT 5
+#define CONV_STATES (1 << (CONV_CONSTRAINT - 1))
+#define CONV_TAIL (CONV_CONSTRAINT - 1)
+#define CONV_POLY_A 023
+#define CONV_POLY_B 035
+
+// The metrics are 7 bits, so a frame is at most 2 * CONV_MAX_STEPS errors away
+#define CONV_MAX_STEPS 56 // Input bits, tail included
+
+#define FEC_NONE 0 // Only the Berger code, which detects errors
+#define FEC_RATE_1_2 1
+#define FEC_RATE_2_3 2
+
+
+/*!
+   \fn int convCodedSize(int bitCount, int fecMode)
+   \return Number of coded bits of bitCount input bits (tail included), -1 if
+           the mode is invalid or the input too long
+*/
+int convCodedSize(int bitCount, int fecMode);
+
+
+
+/*!
+   \fn int convEncode(bool *bits, int bitCount, int fecMode, bool *coded)
+   \brief Encodes the bits followed by the tail
+   \return Number of coded bits, -1 if the mode is invalid or the input too long
+*/
+int convEncode(bool *bits, int bitCount, int fecMode, bool *coded);
+
+
+
+/*!
+   \fn int convDecode(bool *coded, int bitCount, int fecMode, bool *bits)
+   \brief Most likely bitCount input bits given the convCodedSize(bitCount,
+          fecMode) received bits
+   \return Number of received bits that differ from the re-encoded bits, -1 if
+           the mode is invalid or the input too long
+*/
+int convDecode(bool *coded, int bitCount, int fecMode, bool *bits);
+
+#endif
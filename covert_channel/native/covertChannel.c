@@ -13,25 +13,45 @@
 #include "receiver.h"
 #include "frame.h"
 #include "hammingCode.h"
+#include "p1_time.h"
+#include "linkProfile.h"
+#include "calibration.h"
+#include "transport.h"
+#include "multiLevel.h"
+#include "stageProfile.h"
+#include "kernelRegistry.h"
+#include "sendBit.h"
 
 
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <signal.h>
+#include <getopt.h>
+
+
+// Cleared by SIGINT so that traces are flushed before exiting
+static volatile sig_atomic_t running = 1;
+
+void stopCovertChannel(int signum) {
+  running = 0;
+}
 
 
 /*!
-   \fn int waitRequestFrame ()
+   \fn int waitRequestFrame (requestFrame *rFrame)
    Wrapper for the listener. Waits for a frame, and check validity
-   \return Sequence number if the frame is correct, code otherwise
+   \param[out] rFrame The received request
+   \return VALID_ANSWER if the frame is correct, code otherwise
 */
-int waitRequestFrame() {
+int waitRequestFrame(requestFrame *rFrame) {
   if (DEBUG) printf("Listening...\n");
-  requestFrame rFrame = multiListen();
-  if ((rFrame.initSeq == 10) & (rFrame.sequenceNumber < 16)) {
-    return rFrame.sequenceNumber;
+  *rFrame = multiListen();
+  if ((rFrame->initSeq == 10) & (rFrame->sequenceNumber < 16) & (rFrame->sack < 16)) {
+    return VALID_ANSWER;
   }
   else {
     return INVALID_FRAME;
@@ -41,30 +61,251 @@ int waitRequestFrame() {
 
 
 /*!
-   \fn int main ()
+   \fn int usage (char *name)
+   Prints the command line options
+*/
+int usage(char *name) {
+  printf("Usage: %s [-c] [-P profile] [-W window] [-L levels] [-D] [-F code] [-k kernel] [-K kernel] [-p] [-d detector] [-f filter] [-w window] [-H hop] [-r trace] [-t prefix] [-S profile] [-s trace [-n passes]]\n", name);
+  printf("\t-c\t\tCalibrate the link at startup and save the best parameters in the profile\n");
+  printf("\t-P profile\tLink profile loaded at startup (default %s)\n", LINK_PROFILE_PATH);
+  printf("\t-W window\tData frames sent per request, 1 to %i (default %i)\n", ARQ_MAX_WINDOW, ARQ_WINDOW);
+  printf("\t-L levels\tLevels per symbol of the data frames: 2 (binary), 4 or 8 (default %i)\n", SYMBOL_LEVELS);
+  printf("\t-D\t\tStripe the data frames over ports 1 and 5, for a receiver timing both\n");
+  printf("\t-F code\t\tCode of the data frames: 0 (Berger code only), 1 (convolutional rate 1/2) or 2 (rate 2/3) (default %i)\n", FEC_MODE);
+  printf("\t-k kernel\tGenerated spam kernel of the sender on port 1, see benchKernels -l (default crc32_u48 of p1_spam.S)\n");
+  printf("\t-K kernel\tGenerated timing kernel of the receiver on port 1 (default crc32_u48 of p1_time.S), calibrate with -c\n");
+  printf("\t-p\t\tPipelined receiver: listeners only measure, a separate thread runs the detector\n");
+  printf("\t-d detector\tDetector of the receiver: threshold or denstream (default threshold)\n");
+  printf("\t-f filter\tFilter of the receiver timings: qsort, network, sliding, hampel or trimmed (default network)\n");
+  printf("\t-w window\tNumber of timings in a filter window (default 10)\n");
+  printf("\t-H hop\t\tTimings between two points of the sliding filter (default window)\n");
+  printf("\t-r trace\tRecord every read_timings pass of the receiver in a trace file\n");
+  printf("\t-t prefix\tTrace the points of each listener in prefix.<listener>, for plot.py (default points with DEBUG)\n");
+  printf("\t-S profile\tWrite the latency histograms of the hot path stages on exit, as JSON (.json) or CSV (needs STAGE_PROFILING)\n");
+  printf("\t-s trace\tOnly capture -n read_timings passes in a trace file, then exit\n");
+  printf("\t-n passes\tNumber of passes captured by -s (default 10000)\n");
+  return 1;
+}
+
+
+
+/*!
+   \fn int main (int argc, char *argv[])
    Main function of the covert channel. Handles listening and sending
    as well as synchronization
 */
-int main() {
+int main(int argc, char *argv[]) {
+  char *profilePath = LINK_PROFILE_PATH;
+  int calibrate = 0;
+  int window = ARQ_WINDOW;
+  int levels = SYMBOL_LEVELS;
+  int dualPort = 0;
+  int fecMode = FEC_MODE;
+  char *spamKernelName = NULL;
+  char *timingKernelName = NULL;
+  char *recordPath = NULL;
+  char *capturePath = NULL;
+  char *stageProfilePath = NULL;
+  char *pointTracePrefix = DEBUG ? "points" : NULL;
+  size_t capturePasses = 10000;
+  int pipelinedReceiver = 0;
+  DetectorType detector = DETECTOR_THRESHOLD;
+  int filterType = FILTER_NETWORK;
+  size_t filterSize = 10;
+  size_t filterHop = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "cP:W:L:DF:k:K:pd:f:w:H:r:t:S:s:n:h")) != -1) {
+    switch (opt) {
+      case 'c': calibrate = 1; break;
+      case 'P': profilePath = optarg; break;
+      case 'W': window = atoi(optarg); break;
+      case 'L': levels = atoi(optarg); break;
+      case 'D': dualPort = 1; break;
+      case 'F': fecMode = atoi(optarg); break;
+      case 'k': spamKernelName = optarg; break;
+      case 'K': timingKernelName = optarg; break;
+      case 'p': pipelinedReceiver = 1; break;
+      case 'd':
+        if (strcmp(optarg, "threshold") == 0) detector = DETECTOR_THRESHOLD;
+        else if (strcmp(optarg, "denstream") == 0) detector = DETECTOR_DENSTREAM;
+        else return usage(argv[0]);
+        break;
+      case 'f': filterType = filterTypeFromName(optarg); break;
+      case 'w': filterSize = strtoul(optarg, NULL, 10); break;
+      case 'H': filterHop = strtoul(optarg, NULL, 10); break;
+      case 'r': recordPath = optarg; break;
+      case 't': pointTracePrefix = optarg; break;
+      case 'S': stageProfilePath = optarg; break;
+      case 's': capturePath = optarg; break;
+      case 'n': capturePasses = strtoul(optarg, NULL, 10); break;
+      default: return usage(argv[0]);
+    }
+  }
+
+  int loaded = loadLinkProfile(&linkProfile, profilePath);
+  if (loaded == -1) {
+    fprintf(stderr, "Invalid link profile %s\n", profilePath);
+    return 1;
+  }
+  if (loaded == 1) {
+    printf("Loaded link profile %s\n", profilePath);
+    printLinkProfile(&linkProfile);
+  }
+
+  if (capturePath != NULL) {
+    printf("Capturing %zu passes in %s...\n", capturePasses, capturePath);
+    return startTimings(capturePath, capturePasses);
+  }
+  if ((filterType == -1) || (setReceiverFilter(filterType, filterSize, filterHop) == -1)) {
+    fprintf(stderr, "Invalid filter, the window holds up to %i timings\n", MAX_FILTER_SIZE);
+    return usage(argv[0]);
+  }
+  if ((window < 1) | (window > ARQ_MAX_WINDOW)) {
+    fprintf(stderr, "Invalid window, it holds 1 to %i frames\n", ARQ_MAX_WINDOW);
+    return usage(argv[0]);
+  }
+  if (setSymbolLevels(levels) == -1) {
+    fprintf(stderr, "Invalid number of levels, it is a power of two up to %i\n", MAX_LEVELS);
+    return usage(argv[0]);
+  }
+  if (dualPort && (levels > 2)) {
+    fprintf(stderr, "Dual port frames are binary, they cannot be used with -L\n");
+    return usage(argv[0]);
+  }
+  if (dualPort && !spamPortsSupported(SPAM_PORTS_BOTH)) {
+    fprintf(stderr, "Dual port frames spam port 5 with AVX2 instructions, this CPU does not support them\n");
+    return usage(argv[0]);
+  }
+  setDualPort(dualPort);
+  if (setFecMode(fecMode) == -1) {
+    fprintf(stderr, "Invalid code, it is 0, 1 or 2\n");
+    return usage(argv[0]);
+  }
+  if (dualPort && (fecMode != FEC_NONE)) {
+    fprintf(stderr, "Dual port frames are not convolutional coded, they cannot be used with -F\n");
+    return usage(argv[0]);
+  }
+  if (spamKernelName != NULL) {
+    const KernelInfo *kernel = findKernel(spamKernelName);
+    if (kernel == NULL) {
+      fprintf(stderr, "Unknown or unsupported kernel %s\n", spamKernelName);
+      return usage(argv[0]);
+    }
+    setSpamKernel(kernel->spam);
+  }
+  if (timingKernelName != NULL) {
+    const KernelInfo *kernel = findKernel(timingKernelName);
+    if (kernel == NULL) {
+      fprintf(stderr, "Unknown or unsupported kernel %s\n", timingKernelName);
+      return usage(argv[0]);
+    }
+    setReceiverTimingKernel(kernel->time);
+  }
+  if (calibrate) {
+    CalibrationOptions co;
+    CalibrationPoint point;
+    if (initCalibrationOptions(&co) == -1) {
+      fprintf(stderr, "Calibration needs an SMT sibling of CPU %i for the sender, set CALIBRATION_SENDER_CPU in config.h\n", CALIBRATION_RECEIVER_CPU);
+      return 1;
+    }
+    co.filterType = filterType;
+    co.filterSize = filterSize;
+    co.filterHop = filterHop;
+    co.levels = levels;
+    if (calibrateLink(&co, &linkProfile, &point) == -1) {
+      fprintf(stderr, "Calibration failed, no configuration could be tested\n");
+      return 1;
+    }
+    char comment[200];
+    time_t now = time(NULL);
+    strftime(comment, sizeof(comment), "Calibrated on %F %T", localtime(&now));
+    snprintf(comment + strlen(comment), sizeof(comment) - strlen(comment), ", BER %.4f, goodput %.1f bit/s", point.ber, point.goodput);
+    if (saveLinkProfile(&linkProfile, profilePath, comment) == -1) {
+      fprintf(stderr, "Cannot write link profile %s, using it for this run only\n", profilePath);
+    }
+    else {
+      printf("Saved link profile %s (%s)\n", profilePath, comment);
+    }
+    printLinkProfile(&linkProfile);
+  }
+  // Before the traces: the detection thread may take the core of a listener
+  if (pipelinedReceiver && (setPipelinedReceiver(1) == -1)) {
+    if (getConsumerCpu() == -1) {
+      fprintf(stderr, "The pipelined receiver needs a physical core without listener for its detection thread (CONSUMER_CPU)\n");
+    }
+    else {
+      fprintf(stderr, "Cannot allocate the receiver rings\n");
+    }
+    return 1;
+  }
+  if (pipelinedReceiver) printf("Pipelined receiver, detection thread on CPU %i\n", getConsumerCpu());
+  if (recordPath != NULL) {
+    if (startReceiverTrace(recordPath) == -1) {
+      fprintf(stderr, "Cannot open trace file %s\n", recordPath);
+      return 1;
+    }
+    printf("Recording receiver trace in %s\n", recordPath);
+  }
+  if (pointTracePrefix != NULL) {
+    if (startPointTrace(pointTracePrefix) == -1) {
+      fprintf(stderr, "Cannot map the point traces %s.*\n", pointTracePrefix);
+      return 1;
+    }
+    printf("Tracing the listener points in %s.*\n", pointTracePrefix);
+  }
+  if ((stageProfilePath != NULL) && !STAGE_PROFILING) {
+    fprintf(stderr, "The stages are not profiled, set STAGE_PROFILING in config.h\n");
+    return 1;
+  }
+  if (setReceiverDetector(detector) == -1) {
+    fprintf(stderr, "Cannot allocate the DenStream detectors\n");
+    return 1;
+  }
+  signal(SIGINT, stopCovertChannel);
+
   printf("Starting covert channel...\n");
   struct timespec t;
   struct timespec tt;
   // This is a sleep time between receiving a message and start emitting.
   // Useful because JS can take a while to switch from emitting to listening
+  t.tv_sec = 0;
   t.tv_nsec = 2000000; //in ns, so here 2ms
   char *test_sequence="azertyuiopqsdfgh"; // Test sequence for quick test purposes, add more data to make more realistic tests
-  while(1) {
+  ArqSender arq;
+  initArqSender(&arq, test_sequence, strlen(test_sequence), window, ARQ_RETRANSMIT_TIMEOUT * linkProfile.bitDuration);
+  dataFrame frames[ARQ_MAX_WINDOW];
+  requestFrame rFrame;
+  while(running) {
     /**
      * The sender always act in reaction.
-     * We wait for a request, we send data.
+     * We wait for a request acknowledging the previous frames, we send the
+     * next window.
     **/
-    int nextSequenceNumber = waitRequestFrame(); // Wait for a frame
-    if ((nextSequenceNumber >= 0) & (nextSequenceNumber < 16)) { // Seems like a valid frame
-      nanosleep(&t, &tt); // Pause time to let js switch to listening
-      multiThreadedSender(test_sequence[nextSequenceNumber], nextSequenceNumber); // Answer
+    int code = waitRequestFrame(&rFrame); // Wait for a frame
+    if (code == VALID_ANSWER) { // Seems like a valid frame
+      arqProcessRequest(&arq, rFrame);
+      int frameCount = arqNextFrames(&arq, frames);
+      if (frameCount > 0) {
+        nanosleep(&t, &tt); // Pause time to let js switch to listening
+        multiThreadedSendFrames(frames, frameCount); // Answer
+        arqBurstSent(&arq);
+      }
     }
-    else if (nextSequenceNumber == INVALID_FRAME){
+    else if (code == INVALID_FRAME){
       if (DEBUG) printf("Invalid frame received, waiting for another request.\n");
     }
   }
+  printArqStats(&arq);
+  printListenerPoolStats();
+  printSenderPoolStats();
+  stopReceiverTrace();
+  stopPointTrace();
+  if (pipelinedReceiver) printRingStats();
+  if (stageProfilePath != NULL) {
+    printStageProfile();
+    if (writeStageProfile(stageProfilePath) == -1) {
+      fprintf(stderr, "Cannot write the stage profile %s\n", stageProfilePath);
+    }
+  }
+  return 0;
 }
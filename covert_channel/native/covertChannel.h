@@ -13,6 +13,7 @@
 #include "frame.h"
 #include <stdatomic.h>
 #include "config.h"
+#include "receiver.h"
 
 
 /*!
@@ -20,9 +21,11 @@
    \brief List of all the threads used to send/receive bits
 */
 typedef struct {
-  pthread_t threads[PHY_CORE]; // Array of handles to threads
+  pthread_t threads[MAX_PHY_CORE]; // Array of handles to threads
   int threadNumber; // Id of the current thread
+  ListenBuffers *buffers; // Preallocated buffers of the current thread
   requestFrame rFrame; // Placeholder for the receiverd frame
+  bool bits[REQUEST_FRAME_SIZE]; // Hard bits of the detector it was decoded from
   atomic_int *finished; // 1 if a thread has received a frame, 0 othrewise
   int code; // Return Code
 } ThreadRequestInfos;
@@ -5,6 +5,7 @@
    \date 19/11/2021
 */
 #include "denStreamDetection.h"
+#include "softDecision.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -144,16 +145,16 @@ int calibrate(Results *r) {
 
 
 /*!
-   \fn int checkInitSequenceStream(MicroCluster clusters[], Results *results, DenStream *ds, long double threshold)
+   \fn int checkInitSequenceStream(Results *results, int pLen, long double threshold)
    \brief Checks the initsequence part of the result object if it contais a 101,
           it considers it the real init sequence, and We use an arbitrary
           threshold ratio to distinguish 1 from 0 here, its bad practice
           This function returns nothing but directly updates the result object
 */
-int checkInitSequenceStream(MicroCluster clusters[], Results *results, DenStream *ds, long double threshold) {
+int checkInitSequenceStream(Results *results, int pLen, long double threshold) {
   if ((results->initSequence[0].center_x != -1) & (results->initSequence[1].center_x != -1) &(results->initSequence[2].center_x != -1)) {
     if ((results->initSequence[0].center_y > threshold * results->initSequence[1].center_y) & (results->initSequence[2].center_y > threshold * results->initSequence[1].center_y)) {
-      results->startIndex = ds->pLen - 5;
+      results->startIndex = pLen - 5;
       calibrate(results);
       results ->bitNumber = 3;
       for (int i = 0; i < 3; i++) {
@@ -237,7 +238,7 @@ int parseNewCluster(MicroCluster clusters[], Results *results, DenStream *ds) {
   if (ds->pLen > 3) {
     updateClusterList(results, clusters[ds->pLen - 3], 1.05);
     if (results->startIndex == -1) {
-      checkInitSequenceStream(clusters, results, ds, 1.15);
+      checkInitSequenceStream(results, ds->pLen, 1.15);
     }
   }
   return 1;
@@ -250,7 +251,7 @@ int parseNewPoint(Sample s, DenStream *ds, Results *results) {
   partialFit(ds, s);
   int newClusterCount = ds->pLen;
   if (oldClusterCount != newClusterCount) {
-    qsort( ds->pMicroClusters, ds->pLen, sizeof(MicroCluster), compareCluster );
+    // partialFit keeps pMicroClusters sorted by center_x
     parseNewCluster(ds->pMicroClusters, results, ds);
   }
   return 1;
@@ -258,6 +259,49 @@ int parseNewPoint(Sample s, DenStream *ds, Results *results) {
 
 
 
+// Same as parseNewPoint with the structure of arrays engine
+int parseNewPointFast(FastDenStream *ds, double x, double y, Results *results) {
+  int oldClusterCount = ds->pClusters.len;
+  fastPartialFit(ds, x, y);
+  int newClusterCount = ds->pClusters.len;
+  if (oldClusterCount != newClusterCount) {
+    if (newClusterCount > 3) {
+      MicroCluster mc;
+      toMicroCluster(ds, &ds->pClusters, newClusterCount - 3, &mc);
+      updateClusterList(results, mc, 1.05);
+      if (results->startIndex == -1) {
+        checkInitSequenceStream(results, newClusterCount, 1.15);
+      }
+    }
+  }
+  return 1;
+}
+
+
+
+/*!
+   \fn int getSoftBits(Results *results, double *llrs)
+   \brief Soft version of getBits: the log-likelihood of each of the
+          REQUEST_FRAME_SIZE bits, from the center and variance of the
+          clusters, see softDecision.h
+*/
+int getSoftBits(Results *results, double *llrs) {
+  SoftCluster clusters[MAX_CLUSTER];
+  int clusterCount = 0;
+  for (int i = 0; (i < results->mcLen) & (clusterCount < MAX_CLUSTER); i++) {
+    MicroCluster *mc = &results->clusters[i];
+    if ((mc->pointNumber == 0) | (mc->weight <= 0.)) continue;
+    int bitPosition = getBitPosition(*mc, results->threshold);
+    SoftCluster sc = {bitPosition, mc->pointNumber, (double) (mc->center_y - results->threshold), (double) (mc->variance_y / mc->weight),
+                      mc->pointNumber / (bitPosition ? results->bitSize_1 : results->bitSize_0)};
+    clusters[clusterCount++] = sc;
+  }
+  clustersToLlrs(clusters, clusterCount, llrs, REQUEST_FRAME_SIZE);
+  return 1;
+}
+
+
+
 int getBits(Results *results) {
   int bitCount = 0;
   for (int i = 0; i < results->mcLen; i++) {
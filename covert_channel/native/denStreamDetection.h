@@ -3,6 +3,7 @@
 
 #include "MicroCluster.h"
 #include "DenStream.h"
+#include "fastDenStream.h"
 #include "config.h"
 
 typedef struct {
@@ -20,5 +21,7 @@ typedef struct {
 int initResults(Results *r);
 int printResults(Results *results);
 int parseNewPoint(Sample s, DenStream *ds, Results *results);
+int parseNewPointFast(FastDenStream *ds, double x, double y, Results *results);
 int getBits(Results *results);
+int getSoftBits(Results *results, double *llrs);
 #endif
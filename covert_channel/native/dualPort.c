@@ -0,0 +1,61 @@
+/*!
+   \file dualPort.c
+   \brief Data frames striped over ports 1 and 5, see dualPort.h
+*/
+
+#include "dualPort.h"
+#include "frame.h"
+#include "multiLevel.h"
+
+
+int createDualPortFrame(char data, int sequenceNumber, bool *port1, bool *port5) {
+  bool frame[DATA_FRAME_SIZE];
+  createDataFrame(data, sequenceNumber, frame, DATA_FRAME_SIZE);
+
+  for (int i = 0; i < DUAL_PORT_INIT_SIZE; i++) {
+    port1[i] = frame[i];
+    port5[i] = frame[i];
+  }
+  for (int i = DUAL_PORT_INIT_SIZE; i < DUAL_PORT_FRAME_SIZE; i++) {
+    int index = DUAL_PORT_INIT_SIZE + 2 * (i - DUAL_PORT_INIT_SIZE);
+    port1[i] = frame[index];
+    port5[i] = index + 1 < DATA_FRAME_SIZE ? frame[index + 1] : 0;
+  }
+  return DUAL_PORT_FRAME_SIZE;
+}
+
+
+
+int mergeDualPortFrame(bool *port1, bool *port5, bool *frame, int frameSize) {
+  if (frameSize != DATA_FRAME_SIZE) {
+    return -1;
+  }
+  for (int i = 0; i < DUAL_PORT_INIT_SIZE; i++) {
+    frame[i] = port1[i];
+  }
+  for (int index = DUAL_PORT_INIT_SIZE; index < DATA_FRAME_SIZE; index++) {
+    int stripe = DUAL_PORT_INIT_SIZE + (index - DUAL_PORT_INIT_SIZE) / 2;
+    frame[index] = (index - DUAL_PORT_INIT_SIZE) % 2 ? port5[stripe] : port1[stripe];
+  }
+  return 1;
+}
+
+
+
+int decodeDualPortFrame(unsigned int *points1, size_t count1, unsigned int *points5, size_t count5, LinkProfile *lp1, LinkProfile *lp5, bool *frame) {
+  int stripeSize = DUAL_PORT_FRAME_SIZE - DUAL_PORT_INIT_SIZE;
+  int symbols1[DUAL_PORT_FRAME_SIZE], symbols5[DUAL_PORT_FRAME_SIZE];
+  LevelResults lr1, lr5;
+  if ((decodeBinary(points1, count1, lp1, symbols1, stripeSize, &lr1) != stripeSize) ||
+      (decodeBinary(points5, count5, lp5, symbols5, stripeSize, &lr5) != stripeSize)) {
+    return -1;
+  }
+
+  bool port1[DUAL_PORT_FRAME_SIZE] = {1, 0, 1, 0};
+  bool port5[DUAL_PORT_FRAME_SIZE] = {1, 0, 1, 0};
+  for (int i = 0; i < stripeSize; i++) {
+    port1[DUAL_PORT_INIT_SIZE + i] = symbols1[i];
+    port5[DUAL_PORT_INIT_SIZE + i] = symbols5[i];
+  }
+  return mergeDualPortFrame(port1, port5, frame, DATA_FRAME_SIZE);
+}
@@ -0,0 +1,57 @@
+/*!
+   \file dualPort.h
+   \brief Data frames striped over two parallel sub-channels: contention on
+          port 1 (crc32) and on port 5 (vpermd) are measured independently by
+          the receiver (read_timings and read_timings_p5), so one bit period
+          carries a bit on each port.
+          Each port sends a sub-frame starting with its own 1010 init sequence,
+          for the receiver to synchronise and learn the levels of that port,
+          followed by every other bit of the data frame after its init
+          sequence: the even ones on port 1, the odd ones on port 5.
+          A 21 bit data frame takes 4 + 9 bit periods instead of 21.
+*/
+
+#ifndef DUAL_PORT_H
+#define DUAL_PORT_H
+
+#include "config.h"
+#include "linkProfile.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DUAL_PORT_INIT_SIZE 4 // 1010, like the data frames
+// Bit periods of a sub-frame, port 5 pads its stripe with a 0 when it is shorter
+#define DUAL_PORT_FRAME_SIZE (DUAL_PORT_INIT_SIZE + (DATA_FRAME_SIZE - DUAL_PORT_INIT_SIZE + 1) / 2)
+
+
+
+/*!
+   \fn int createDualPortFrame(char data, int sequenceNumber, bool *port1, bool *port5)
+   \brief Creates the data frame and splits it in the two sub-frames of
+          DUAL_PORT_FRAME_SIZE bits
+   \return DUAL_PORT_FRAME_SIZE
+*/
+int createDualPortFrame(char data, int sequenceNumber, bool *port1, bool *port5);
+
+
+
+/*!
+   \fn int mergeDualPortFrame(bool *port1, bool *port5, bool *frame, int frameSize)
+   \brief Inverse of createDualPortFrame, the frame can then be checked and
+          decoded with decodeDataFrame
+   \return 1 if ok, -1 if frameSize is not DATA_FRAME_SIZE
+*/
+int mergeDualPortFrame(bool *port1, bool *port5, bool *frame, int frameSize);
+
+
+
+/*!
+   \fn int decodeDualPortFrame(unsigned int *points1, size_t count1, unsigned int *points5, size_t count5, LinkProfile *lp1, LinkProfile *lp5, bool *frame)
+   \brief Decodes the sub-frames from the points of each port (see
+          decodeBinary), with a profile per port for the edges, and merges them
+   \return 1 if both sub-frames were complete, -1 otherwise
+*/
+int decodeDualPortFrame(unsigned int *points1, size_t count1, unsigned int *points5, size_t count5, LinkProfile *lp1, LinkProfile *lp5, bool *frame);
+
+#endif
@@ -0,0 +1,332 @@
+/*!
+   \file fastDenStream.c
+   \brief DenStream engine with a structure of arrays layout, see fastDenStream.h.
+          Every function follows its counterpart of DenStream.c and
+          MicroCluster.c, so that both engines take the same decisions.
+*/
+
+#include "fastDenStream.h"
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <immintrin.h>
+
+
+typedef long (*NearestClusterKernel)(ClusterSet *set, double x, double y);
+
+
+
+/*!
+   \fn long nearestClusterSSE2(ClusterSet *set, double x, double y)
+   Squared distances of two clusters at a time. Each lane keeps its smallest
+   distance and the index of the first cluster reaching it, then the lanes are
+   reduced in index order.
+*/
+long nearestClusterSSE2(ClusterSet *set, double x, double y) {
+  __m128d sampleX = _mm_set1_pd(x);
+  __m128d sampleY = _mm_set1_pd(y);
+  __m128d smallest = _mm_set1_pd(DBL_MAX);
+  __m128d nearest = _mm_set1_pd(-1.);
+  __m128d index = _mm_setr_pd(0., 1.);
+  __m128d step = _mm_set1_pd(2.);
+  long i = 0;
+  for (; i + 2 <= set->len; i += 2) {
+    __m128d dx = _mm_sub_pd(_mm_loadu_pd(&set->centerX[i]), sampleX);
+    __m128d dy = _mm_sub_pd(_mm_loadu_pd(&set->centerY[i]), sampleY);
+    __m128d distance = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+    __m128d closer = _mm_cmplt_pd(distance, smallest);
+    smallest = _mm_or_pd(_mm_and_pd(closer, distance), _mm_andnot_pd(closer, smallest));
+    nearest = _mm_or_pd(_mm_and_pd(closer, index), _mm_andnot_pd(closer, nearest));
+    index = _mm_add_pd(index, step);
+  }
+
+  double laneDistance[2], laneIndex[2];
+  _mm_storeu_pd(laneDistance, smallest);
+  _mm_storeu_pd(laneIndex, nearest);
+  double smallestDistance = DBL_MAX;
+  long nearestIndex = -1;
+  for (int lane = 0; lane < 2; lane++) {
+    if ((laneIndex[lane] >= 0) && ((laneDistance[lane] < smallestDistance) ||
+        ((laneDistance[lane] == smallestDistance) && ((long) laneIndex[lane] < nearestIndex)))) {
+      smallestDistance = laneDistance[lane];
+      nearestIndex = (long) laneIndex[lane];
+    }
+  }
+  for (; i < set->len; i++) {
+    double dx = set->centerX[i] - x;
+    double dy = set->centerY[i] - y;
+    double distance = dx * dx + dy * dy;
+    if (distance < smallestDistance) {
+      smallestDistance = distance;
+      nearestIndex = i;
+    }
+  }
+  return nearestIndex;
+}
+
+
+
+/*!
+   \fn long nearestClusterAVX2(ClusterSet *set, double x, double y)
+   Same as nearestClusterSSE2 with four clusters at a time
+*/
+__attribute__((target("avx2")))
+long nearestClusterAVX2(ClusterSet *set, double x, double y) {
+  __m256d sampleX = _mm256_set1_pd(x);
+  __m256d sampleY = _mm256_set1_pd(y);
+  __m256d smallest = _mm256_set1_pd(DBL_MAX);
+  __m256d nearest = _mm256_set1_pd(-1.);
+  __m256d index = _mm256_setr_pd(0., 1., 2., 3.);
+  __m256d step = _mm256_set1_pd(4.);
+  long i = 0;
+  for (; i + 4 <= set->len; i += 4) {
+    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&set->centerX[i]), sampleX);
+    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&set->centerY[i]), sampleY);
+    __m256d distance = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+    __m256d closer = _mm256_cmp_pd(distance, smallest, _CMP_LT_OQ);
+    smallest = _mm256_blendv_pd(smallest, distance, closer);
+    nearest = _mm256_blendv_pd(nearest, index, closer);
+    index = _mm256_add_pd(index, step);
+  }
+
+  double laneDistance[4], laneIndex[4];
+  _mm256_storeu_pd(laneDistance, smallest);
+  _mm256_storeu_pd(laneIndex, nearest);
+  double smallestDistance = DBL_MAX;
+  long nearestIndex = -1;
+  for (int lane = 0; lane < 4; lane++) {
+    if ((laneIndex[lane] >= 0) && ((laneDistance[lane] < smallestDistance) ||
+        ((laneDistance[lane] == smallestDistance) && ((long) laneIndex[lane] < nearestIndex)))) {
+      smallestDistance = laneDistance[lane];
+      nearestIndex = (long) laneIndex[lane];
+    }
+  }
+  for (; i < set->len; i++) {
+    double dx = set->centerX[i] - x;
+    double dy = set->centerY[i] - y;
+    double distance = dx * dx + dy * dy;
+    if (distance < smallestDistance) {
+      smallestDistance = distance;
+      nearestIndex = i;
+    }
+  }
+  return nearestIndex;
+}
+
+
+
+static NearestClusterKernel nearestClusterKernel = NULL;
+
+long getNearestCluster(ClusterSet *set, double x, double y) {
+  if (nearestClusterKernel == NULL) {
+    nearestClusterKernel = __builtin_cpu_supports("avx2") ? nearestClusterAVX2 : nearestClusterSSE2;
+  }
+  return nearestClusterKernel(set, x, y);
+}
+
+
+
+const char *getNearestClusterKernel() {
+  return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+}
+
+
+
+int initFastDenStream(FastDenStream *ds, double lambda, double eps, double beta, double mu) {
+  ds->lambda = lambda;
+  ds->eps = eps;
+  ds->beta = beta;
+  ds->mu = mu;
+  ds->t = 0.;
+  ds->tp = lambda > 0. ? 5 : DBL_MAX;
+  ds->decayFactor = pow(2., -1. * lambda);
+  ds->oClusters.len = 0;
+  ds->pClusters.len = 0;
+  for (int age = 0; age < DECAY_TABLE_SIZE; age++) {
+    ds->xiTable[age] = (pow(2., -1. * lambda * (age + ds->tp)) - 1) / (pow(2., -1. * lambda * ds->tp) - 1);
+  }
+  return 1;
+}
+
+
+
+// Copies the cluster at index from to the index to of another set
+int moveCluster(ClusterSet *from, int fromIndex, ClusterSet *to, int toIndex) {
+  to->centerX[toIndex] = from->centerX[fromIndex];
+  to->centerY[toIndex] = from->centerY[fromIndex];
+  to->varianceX[toIndex] = from->varianceX[fromIndex];
+  to->varianceY[toIndex] = from->varianceY[fromIndex];
+  to->weight[toIndex] = from->weight[fromIndex];
+  to->creationTime[toIndex] = from->creationTime[fromIndex];
+  to->pointNumber[toIndex] = from->pointNumber[fromIndex];
+  return 1;
+}
+
+
+
+// Pops a cluster, shifting the next ones to the left (see removeIndex)
+int removeCluster(ClusterSet *set, int index) {
+  if (index >= set->len) {
+    return -1;
+  }
+  size_t count = set->len - index - 1;
+  memmove(&set->centerX[index], &set->centerX[index + 1], count * sizeof(double));
+  memmove(&set->centerY[index], &set->centerY[index + 1], count * sizeof(double));
+  memmove(&set->varianceX[index], &set->varianceX[index + 1], count * sizeof(double));
+  memmove(&set->varianceY[index], &set->varianceY[index + 1], count * sizeof(double));
+  memmove(&set->weight[index], &set->weight[index + 1], count * sizeof(double));
+  memmove(&set->creationTime[index], &set->creationTime[index + 1], count * sizeof(double));
+  memmove(&set->pointNumber[index], &set->pointNumber[index + 1], count * sizeof(unsigned));
+  set->len--;
+  return 1;
+}
+
+
+
+int swapClusters(ClusterSet *set, int first, int second) {
+  double d;
+  d = set->centerX[first]; set->centerX[first] = set->centerX[second]; set->centerX[second] = d;
+  d = set->centerY[first]; set->centerY[first] = set->centerY[second]; set->centerY[second] = d;
+  d = set->varianceX[first]; set->varianceX[first] = set->varianceX[second]; set->varianceX[second] = d;
+  d = set->varianceY[first]; set->varianceY[first] = set->varianceY[second]; set->varianceY[second] = d;
+  d = set->weight[first]; set->weight[first] = set->weight[second]; set->weight[second] = d;
+  d = set->creationTime[first]; set->creationTime[first] = set->creationTime[second]; set->creationTime[second] = d;
+  unsigned u = set->pointNumber[first]; set->pointNumber[first] = set->pointNumber[second]; set->pointNumber[second] = u;
+  return 1;
+}
+
+
+
+// Moves the cluster at index back to its place in a set sorted by center_x
+// (see restoreOrder)
+int restoreClusterOrder(ClusterSet *set, int index) {
+  while ((index + 1 < set->len) && (set->centerX[index + 1] < set->centerX[index])) {
+    swapClusters(set, index, index + 1);
+    index++;
+  }
+  while ((index > 0) && (set->centerX[index - 1] > set->centerX[index])) {
+    swapClusters(set, index, index - 1);
+    index--;
+  }
+  return index;
+}
+
+
+
+/*!
+   \fn int tryMergeCluster(FastDenStream *ds, ClusterSet *set, int index, double x, double y)
+   insertSample on a copy of the cluster, kept only if its radius stays below
+   eps. Radius and eps are compared squared.
+   \return 1 if we merged, -1 if we cannot
+*/
+int tryMergeCluster(FastDenStream *ds, ClusterSet *set, int index, double x, double y) {
+  double oldWeight = set->weight[index];
+  double newWeight = oldWeight * ds->decayFactor + 1.;
+
+  double oldCenterX = set->centerX[index];
+  double newCenterX = oldCenterX + ((1. / newWeight) * (x - oldCenterX));
+  double oldCenterY = set->centerY[index];
+  double newCenterY = oldCenterY + ((1. / newWeight) * (y - oldCenterY));
+
+  double newVarianceX = (set->varianceX[index] * ((newWeight - 1.) / oldWeight)) + ((x - newCenterX) * (x - oldCenterX));
+  double newVarianceY = (set->varianceY[index] * ((newWeight - 1.) / oldWeight)) + ((y - newCenterY) * (y - oldCenterY));
+
+  if (newVarianceX / newWeight + newVarianceY / newWeight < ds->eps * ds->eps) {
+    set->weight[index] = newWeight;
+    set->centerX[index] = newCenterX;
+    set->centerY[index] = newCenterY;
+    set->varianceX[index] = newVarianceX;
+    set->varianceY[index] = newVarianceY;
+    set->pointNumber[index]++;
+    return 1;
+  }
+  return -1;
+}
+
+
+
+// See merging in DenStream.c
+int fastMerging(FastDenStream *ds, double x, double y) {
+  ClusterSet *p = &ds->pClusters;
+  ClusterSet *o = &ds->oClusters;
+
+  long nearestP = getNearestCluster(p, x, y);
+  int success = -1;
+  if (nearestP != -1) {
+    success = tryMergeCluster(ds, p, nearestP, x, y);
+    if (success == 1) {
+      restoreClusterOrder(p, nearestP);
+    }
+  }
+  if (success == -1) {
+    long nearestO = getNearestCluster(o, x, y);
+    if (nearestO != -1) {
+      success = tryMergeCluster(ds, o, nearestO, x, y);
+    }
+
+    if (success == 1) {
+      // Upgrade the o cluster to a p cluster
+      if (o->weight[nearestO] > ds->beta * ds->mu) {
+        // Appended, then moved to its place like insertOrdered
+        moveCluster(o, nearestO, p, p->len++);
+        restoreClusterOrder(p, p->len - 1);
+        removeCluster(o, nearestO);
+      }
+    }
+    else {
+      // New o cluster holding only this sample
+      int index = o->len++;
+      o->centerX[index] = x;
+      o->centerY[index] = y;
+      o->varianceX[index] = 0.;
+      o->varianceY[index] = 0.;
+      o->weight[index] = 1.;
+      o->creationTime[index] = (unsigned) ds->t;
+      o->pointNumber[index] = 1;
+    }
+  }
+  return 1;
+}
+
+
+
+int fastPartialFit(FastDenStream *ds, double x, double y) {
+  fastMerging(ds, x, y);
+  if ((ds->lambda > 0.) && (((unsigned) round(ds->t)) % ((unsigned) round(ds->tp)) == 0)) {
+    // In place compaction, as in partialFit
+    int count = 0;
+    for (int i = 0; i < ds->pClusters.len; i++) {
+      if (ds->pClusters.weight[i] >= ds->beta * ds->mu) {
+        moveCluster(&ds->pClusters, i, &ds->pClusters, count++);
+      }
+    }
+    ds->pClusters.len = count;
+
+    count = 0;
+    for (int i = 0; i < ds->oClusters.len; i++) {
+      double age = ds->t - ds->oClusters.creationTime[i];
+      double xi = age < DECAY_TABLE_SIZE ? ds->xiTable[(unsigned) age] :
+                  (pow(2., -1. * ds->lambda * (age + ds->tp)) - 1) / (pow(2., -1. * ds->lambda * ds->tp) - 1);
+      if (ds->oClusters.weight[i] >= xi) {
+        moveCluster(&ds->oClusters, i, &ds->oClusters, count++);
+      }
+    }
+    ds->oClusters.len = count;
+  }
+  ds->t++;
+  return 1;
+}
+
+
+
+int toMicroCluster(FastDenStream *ds, ClusterSet *set, int index, MicroCluster *mc) {
+  initMicroCluster(mc, ds->lambda, (unsigned) set->creationTime[index]);
+  mc->center_x = set->centerX[index];
+  mc->center_y = set->centerY[index];
+  mc->variance_x = set->varianceX[index];
+  mc->variance_y = set->varianceY[index];
+  mc->weight = set->weight[index];
+  mc->pointNumber = set->pointNumber[index];
+  return 1;
+}
@@ -0,0 +1,98 @@
+/*!
+   \file fastDenStream.h
+   \brief DenStream engine with a structure of arrays layout, meant for the live
+          receiver.
+          It runs the same algorithm as DenStream.c, but clusters are stored
+          field by field in double arrays instead of an array of long double
+          MicroCluster. The nearest cluster search compares squared distances,
+          four (AVX2) or two (SSE2) clusters at a time. The AVX2 kernel is
+          picked at runtime when the CPU supports it.
+          replay -e checks both engines take the same decisions on a trace.
+*/
+
+#ifndef FASTDENSTREAM_H
+#define FASTDENSTREAM_H
+
+#include "DenStream.h"
+#include "MicroCluster.h"
+
+
+/*!
+   \struct ClusterSet
+   \brief Micro clusters of one kind (o or p), one array per field
+*/
+typedef struct {
+  double centerX[MAX_CLUSTER];
+  double centerY[MAX_CLUSTER];
+  double varianceX[MAX_CLUSTER];
+  double varianceY[MAX_CLUSTER];
+  double weight[MAX_CLUSTER];
+  double creationTime[MAX_CLUSTER];
+  unsigned pointNumber[MAX_CLUSTER];
+  int len; // Number of clusters in the set
+} ClusterSet;
+
+
+/*!
+   \struct FastDenStream
+   \brief Parameters are the same as the ones of DenStream
+*/
+typedef struct {
+  double lambda;
+  double eps;
+  double beta;
+  double mu;
+  double t; // Current time
+  double tp; // Period of the cluster updates
+  double decayFactor; // 2^-lambda, shared by every cluster
+  double xiTable[DECAY_TABLE_SIZE]; // Minimal weight of o clusters by age
+  ClusterSet oClusters;
+  ClusterSet pClusters; // Sorted by center_x
+} FastDenStream;
+
+
+
+/*!
+   \fn int initFastDenStream(FastDenStream *ds, double lambda, double eps, double beta, double mu)
+   \brief Initiates the engine, see initDenStream for the parameters
+   \return 1 if ok
+*/
+int initFastDenStream(FastDenStream *ds, double lambda, double eps, double beta, double mu);
+
+
+
+/*!
+   \fn int fastPartialFit(FastDenStream *ds, double x, double y)
+   \brief Same as partialFit: merges the sample (x, y) in a micro cluster, and
+          every tp samples drops the clusters that are too light
+   \return 1 if ok
+*/
+int fastPartialFit(FastDenStream *ds, double x, double y);
+
+
+
+/*!
+   \fn long getNearestCluster(ClusterSet *set, double x, double y)
+   \brief Index of the cluster with the closest center to (x, y), the first one
+          on ties like getNearestMicroCluster
+   \return The index, -1 if the set is empty
+*/
+long getNearestCluster(ClusterSet *set, double x, double y);
+
+
+
+/*!
+   \fn int toMicroCluster(FastDenStream *ds, ClusterSet *set, int index, MicroCluster *mc)
+   \brief Copies a cluster of the set in a MicroCluster, for the detector
+*/
+int toMicroCluster(FastDenStream *ds, ClusterSet *set, int index, MicroCluster *mc);
+
+
+
+/*!
+   \fn const char *getNearestClusterKernel()
+   \return Name of the nearest cluster kernel in use (avx2 or sse2)
+*/
+const char *getNearestClusterKernel();
+
+#endif
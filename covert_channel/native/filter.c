@@ -0,0 +1,219 @@
+/*!
+   \file filter.c
+   \brief Robust filters smoothing the receiver timings before the detector
+*/
+
+#include "filter.h"
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+static const char *filterNames[FILTER_TYPE_COUNT] = {"qsort", "network", "sliding", "hampel", "trimmed"};
+
+// Optimal 10 inputs network (Waksman), 29 comparators. Our default window.
+static const unsigned char network10[29][2] = {
+  {4,9},{3,8},{2,7},{1,6},{0,5},{1,4},{6,9},{0,3},{5,8},{0,2},{3,6},{7,9},{0,1},{2,4},{5,7},
+  {8,9},{1,2},{4,6},{7,8},{3,5},{2,5},{6,8},{1,3},{4,7},{2,3},{6,7},{3,4},{5,6},{4,5}
+};
+
+
+
+/*!
+   \fn int buildNetwork(Filter *f)
+   Builds the comparators sorting f->size values.
+   Other sizes than 10 use Batcher's odd-even merge sort on the next power of
+   two. The missing inputs can be seen as +infinity: comparators touching them
+   never swap, so we simply drop them.
+*/
+int buildNetwork(Filter *f) {
+  f->networkSize = 0;
+  if (f->size == 10) {
+    memcpy(f->network, network10, sizeof(network10));
+    f->networkSize = 29;
+    return 1;
+  }
+  size_t n = 1;
+  while (n < f->size) n <<= 1;
+  for (size_t p = 1; p < n; p <<= 1) {
+    for (size_t k = p; k >= 1; k >>= 1) {
+      for (size_t j = k % p; j + k < n; j += 2 * k) {
+        for (size_t i = 0; i < k; i++) {
+          if (((i + j) / (2 * p) == (i + j + k) / (2 * p)) & (i + j + k < f->size)) {
+            f->network[f->networkSize][0] = i + j;
+            f->network[f->networkSize][1] = i + j + k;
+            f->networkSize++;
+          }
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+
+
+int sortNetwork(Filter *f, unsigned int *values) {
+  for (size_t c = 0; c < f->networkSize; c++) {
+    unsigned int a = values[f->network[c][0]];
+    unsigned int b = values[f->network[c][1]];
+    // Branchless compare and exchange
+    values[f->network[c][0]] = a < b ? a : b;
+    values[f->network[c][1]] = a < b ? b : a;
+  }
+  return 1;
+}
+
+
+
+unsigned int sortingNetworkMedian(Filter *f, unsigned int *values) {
+  sortNetwork(f, values);
+  return values[f->size / 2];
+}
+
+
+
+int initFilter(Filter *f, FilterType type, size_t size, size_t hop) {
+  if ((size == 0) | (size > MAX_FILTER_SIZE) | (type < 0) | (type >= FILTER_TYPE_COUNT)) {
+    return -1;
+  }
+  f->type = type;
+  f->size = size;
+  f->hop = hop == 0 ? size : hop;
+  f->fill = 0;
+  f->next = 0;
+  f->sinceOutput = 0;
+  buildNetwork(f);
+  return 1;
+}
+
+
+
+// Index of the first sorted value greater or equal to value
+size_t lowerBound(unsigned int *sorted, size_t count, unsigned int value) {
+  size_t low = 0, high = count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (sorted[mid] < value) low = mid + 1;
+    else high = mid;
+  }
+  return low;
+}
+
+
+
+/*!
+   \fn int slidingPush(Filter *f, unsigned int timing, unsigned int *point)
+   Sliding median: the window stays sorted, every timing replaces the oldest
+   one with two binary searches and two short moves.
+*/
+int slidingPush(Filter *f, unsigned int timing, unsigned int *point) {
+  if (f->fill == f->size) {
+    unsigned int oldest = f->window[f->next];
+    size_t index = lowerBound(f->sorted, f->fill, oldest);
+    memmove(&f->sorted[index], &f->sorted[index + 1], (f->fill - index - 1) * sizeof(unsigned int));
+    f->fill--;
+  }
+  size_t index = lowerBound(f->sorted, f->fill, timing);
+  memmove(&f->sorted[index + 1], &f->sorted[index], (f->fill - index) * sizeof(unsigned int));
+  f->sorted[index] = timing;
+  f->fill++;
+
+  f->window[f->next] = timing;
+  f->next = (f->next + 1) % f->size;
+  f->sinceOutput++;
+
+  if ((f->fill == f->size) & (f->sinceOutput >= f->hop)) {
+    f->sinceOutput = 0;
+    *point = f->sorted[f->size / 2];
+    return 1;
+  }
+  return 0;
+}
+
+
+
+unsigned int hampelMean(Filter *f, unsigned int *values) {
+  unsigned int sorted[MAX_FILTER_SIZE];
+  unsigned int deviations[MAX_FILTER_SIZE];
+  memcpy(sorted, values, f->size * sizeof(unsigned int));
+  unsigned int med = sortingNetworkMedian(f, sorted);
+  for (size_t i = 0; i < f->size; i++) {
+    deviations[i] = values[i] > med ? values[i] - med : med - values[i];
+  }
+  // 1.4826 scales the MAD to the standard deviation of a normal distribution
+  double limit = HAMPEL_K * 1.4826 * sortingNetworkMedian(f, deviations);
+
+  double sum = 0.;
+  for (size_t i = 0; i < f->size; i++) {
+    double deviation = values[i] > med ? values[i] - med : med - values[i];
+    sum += deviation > limit ? med : values[i];
+  }
+  return (unsigned int) lround(sum / f->size);
+}
+
+
+
+unsigned int trimmedMean(Filter *f, unsigned int *values) {
+  sortNetwork(f, values);
+  size_t trim = (size_t) (f->size * TRIM_RATIO);
+  if (2 * trim >= f->size) trim = (f->size - 1) / 2;
+  double sum = 0.;
+  for (size_t i = trim; i < f->size - trim; i++) {
+    sum += values[i];
+  }
+  return (unsigned int) lround(sum / (f->size - 2 * trim));
+}
+
+
+
+int filterPush(Filter *f, unsigned int timing, unsigned int *point) {
+  if (f->type == FILTER_SLIDING) {
+    return slidingPush(f, timing, point);
+  }
+
+  f->window[f->fill++] = timing;
+  if (f->fill < f->size) {
+    return 0;
+  }
+  f->fill = 0;
+
+  switch (f->type) {
+    case FILTER_QSORT:
+      //Qsort needs a comparison function, it is in utils.c
+      qsort(f->window, f->size, sizeof(unsigned int), comp);
+      *point = f->window[f->size / 2];
+      break;
+    case FILTER_NETWORK:
+      *point = sortingNetworkMedian(f, f->window);
+      break;
+    case FILTER_HAMPEL:
+      *point = hampelMean(f, f->window);
+      break;
+    case FILTER_TRIMMED:
+      *point = trimmedMean(f, f->window);
+      break;
+    default:
+      return 0;
+  }
+  return 1;
+}
+
+
+
+int filterTypeFromName(const char *name) {
+  for (int type = 0; type < FILTER_TYPE_COUNT; type++) {
+    if (strcmp(name, filterNames[type]) == 0) {
+      return type;
+    }
+  }
+  return -1;
+}
+
+
+
+const char *filterName(FilterType type) {
+  return filterNames[type];
+}
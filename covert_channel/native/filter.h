@@ -0,0 +1,94 @@
+/*!
+   \file filter.h
+   \brief Robust filters smoothing the receiver timings before the detector.
+          A filter is fed one timing at a time and outputs a point every time
+          its window is complete:
+            - qsort: median of the window with qsort, the historical behaviour.
+            - network: same median, with a branchless sorting network.
+            - sliding: median of the last size timings, kept sorted
+                       incrementally, output every hop timings.
+            - hampel: timings further than HAMPEL_K scaled MADs from the median
+                      are replaced by the median, output is the window mean.
+            - trimmed: mean of the window without its TRIM_RATIO lowest and
+                       highest timings.
+*/
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stddef.h>
+
+#define MAX_FILTER_SIZE 32 // Largest supported window
+#define MAX_NETWORK_SIZE 256 // Comparators of the largest network
+#define HAMPEL_K 3. // Outlier threshold of the hampel filter, in scaled MADs
+#define TRIM_RATIO 0.2 // Ratio of timings dropped at each end by the trimmed mean
+
+
+typedef enum {
+  FILTER_QSORT,
+  FILTER_NETWORK,
+  FILTER_SLIDING,
+  FILTER_HAMPEL,
+  FILTER_TRIMMED,
+  FILTER_TYPE_COUNT
+} FilterType;
+
+
+/*!
+   \struct Filter
+   \brief State of a filter for a single stream of timings
+*/
+typedef struct {
+  FilterType type;
+  size_t size; // Number of timings in a window
+  size_t hop; // Sliding filter only, timings between two points
+  unsigned int window[MAX_FILTER_SIZE]; // Timings in arrival order (a ring for the sliding filter)
+  size_t fill; // Timings in the window
+  size_t next; // Sliding filter only, oldest timing in the ring
+  size_t sinceOutput; // Sliding filter only, timings since the last point
+  unsigned int sorted[MAX_FILTER_SIZE]; // Sliding filter only, the window in order
+  unsigned char network[MAX_NETWORK_SIZE][2]; // Comparators sorting a window
+  size_t networkSize;
+} Filter;
+
+
+
+/*!
+   \fn int initFilter(Filter *f, FilterType type, size_t size, size_t hop)
+   \brief Initiates a filter
+   \param size Number of timings in a window, up to MAX_FILTER_SIZE
+   \param hop Timings between two points of the sliding filter, 0 for size
+   \return 1 if ok, -1 for an invalid size
+*/
+int initFilter(Filter *f, FilterType type, size_t size, size_t hop);
+
+
+
+/*!
+   \fn int filterPush(Filter *f, unsigned int timing, unsigned int *point)
+   \brief Feeds a timing to the filter
+   \param[out] point Set to the filtered value when the function returns 1
+   \return 1 if a point was output, 0 otherwise
+*/
+int filterPush(Filter *f, unsigned int timing, unsigned int *point);
+
+
+
+/*!
+   \fn unsigned int sortingNetworkMedian(Filter *f, unsigned int *values)
+   \brief Median of size values (values[size / 2] once sorted, like median()),
+          sorting them in place with the network of the filter
+*/
+unsigned int sortingNetworkMedian(Filter *f, unsigned int *values);
+
+
+
+/*!
+   \fn int filterTypeFromName(const char *name)
+   \return The FilterType called name, -1 if there is none
+*/
+int filterTypeFromName(const char *name);
+
+const char *filterName(FilterType type);
+
+#endif
@@ -83,6 +83,65 @@ int createDataFrame(char data, int sequenceNumber, bool *frame, int frameSize) {
 }
 
 
+/*
+With FEC_MODE, everything after the init sequence is convolutional coded
+(see convCode.h), the Berger code included: it detects what the code could
+not correct.
+
+| + + + + + + + + |
+|  INIT |  CONV(SEQN DATA CODE)...
+| + + + + + + + + |
+*/
+
+// Bit size of a data frame, -1 if the mode is invalid
+int dataFrameSize(int fecMode) {
+  if (fecMode == FEC_NONE) {
+    return DATA_FRAME_SIZE;
+  }
+  int codedSize = convCodedSize(DATA_FRAME_SIZE - 4, fecMode);
+  return codedSize == -1 ? -1 : 4 + codedSize;
+}
+
+// Returns the frame size, -1 if the mode is invalid
+int createCodedDataFrame(char data, int sequenceNumber, int fecMode, bool *frame) {
+  bool plainFrame[DATA_FRAME_SIZE];
+  createDataFrame(data, sequenceNumber, plainFrame, DATA_FRAME_SIZE);
+  if (fecMode == FEC_NONE) {
+    for (int i = 0; i < DATA_FRAME_SIZE; i++) frame[i] = plainFrame[i];
+    return DATA_FRAME_SIZE;
+  }
+  setInitSequence(frame, DATA_FRAME_SIZE);
+  int codedSize = convEncode(&plainFrame[4], DATA_FRAME_SIZE - 4, fecMode, &frame[4]);
+  return codedSize == -1 ? -1 : 4 + codedSize;
+}
+
+
+/*
+Request frames, sent by the web receiver, have the following format:
+
+| + + + + + + + + + + + + + + + + + + + + |
+|  INIT |  HAMMING(SEQN)  |  HAMMING(SACK)  |
+| + + + + + + + + + + + + + + + + + + + + |
+
+SEQN is a cumulative ack, ie the next frame the receiver expects. Bit i of SACK
+(least significant first) acknowledges frame SEQN+1+i, received out of order.
+*/
+int setEncodedField(int value, bool *frame, int offset) {
+  uint8_t codeword = hammingEncodeNibble(value);
+  for (int i = 0; i < CODED_BITS; i++) {
+    frame[offset+i] = (codeword >> i) & 1;
+  }
+  return 1;
+}
+
+int createRequestFrame(int sequenceNumber, int sack, bool *frame, int frameSize) {
+  setInitSequence(frame, frameSize);
+  setEncodedField(sequenceNumber, frame, 4);
+  setEncodedField(sack, frame, 4 + CODED_BITS);
+  return 1;
+}
+
+
 /*                             Frame Decoding                                 */
 
 bool checkInitSequence(bool *frame, int frameSize) {
@@ -125,16 +184,15 @@ int getBergerCode(bool *frame, int frameSize) {
   return bergerValue;
 }
 
-int getEncodedSequenceNumber(bool *frame, int frameSize) {
-  int encodedSequenceNumber[CODED_BITS];
+static uint8_t getCodeword(bool *frame, int offset) {
+  uint8_t codeword = 0;
   for (int bit = 0; bit < CODED_BITS; bit ++) {
-    encodedSequenceNumber[bit] = (int) frame[4+bit];
+    codeword |= frame[offset+bit] << bit;
   }
-  int decodedSequenceNumber[ACTUAL_BIT];
-  int sequenceNumber = hammingDecode(encodedSequenceNumber,decodedSequenceNumber );
-  return sequenceNumber;
+  return codeword;
 }
 
+
 dataFrame decodeDataFrame(bool *frame, int frameSize, int* sequenceNumber, char* data) {
   dataFrame decFrame;
   decFrame.initSeq = getInitSequence(frame, frameSize);
@@ -145,14 +203,48 @@ dataFrame decodeDataFrame(bool *frame, int frameSize, int* sequenceNumber, char*
 
 }
 
+int checkBergerCode(bool *frame, int frameSize) {
+  int zeroCount = 0;
+  for (int bit = 0; bit < 16; bit++) {
+    zeroCount += frame[bit] == 0;
+  }
+  return zeroCount == getBergerCode(frame, frameSize);
+}
+
+// Returns the number of bits corrected by the convolutional code, -1 if the
+// frame is invalid
+int decodeCodedDataFrame(bool *frame, int frameSize, int fecMode, int *sequenceNumber, char *data) {
+  if ((frameSize != dataFrameSize(fecMode)) || !checkInitSequence(frame, frameSize)) {
+    return -1;
+  }
+  bool plainFrame[DATA_FRAME_SIZE];
+  int corrected = 0;
+  if (fecMode == FEC_NONE) {
+    for (int i = 0; i < DATA_FRAME_SIZE; i++) plainFrame[i] = frame[i];
+  }
+  else {
+    setInitSequence(plainFrame, DATA_FRAME_SIZE);
+    corrected = convDecode(&frame[4], DATA_FRAME_SIZE - 4, fecMode, &plainFrame[4]);
+  }
+  if (!checkBergerCode(plainFrame, DATA_FRAME_SIZE)) {
+    return -1;
+  }
+  *sequenceNumber = getSequenceNumber(plainFrame, DATA_FRAME_SIZE);
+  *data = getData(plainFrame, DATA_FRAME_SIZE);
+  return corrected;
+}
+
 requestFrame decodeRequestFrame(bool *frame, int frameSize) {
   requestFrame decFrame;
   decFrame.initSeq = getInitSequence(frame, frameSize);
-  int seqNum = getEncodedSequenceNumber(frame, frameSize);
+  // Both fields are decoded together, see hammingDecodeFields
+  uint8_t codewords[2] = {getCodeword(frame, 4), getCodeword(frame, 4 + CODED_BITS)};
+  int fields[2];
   // printRequestFrame(frame, REQUEST_FRAME_SIZE);
 
-  if (seqNum != -1) {
-    decFrame.sequenceNumber = seqNum;
+  if (hammingDecodeFields(codewords, 2, fields) == 1) {
+    decFrame.sequenceNumber = fields[0];
+    decFrame.sack = fields[1];
   }
   else {
     decFrame.initSeq = 0;
@@ -163,6 +255,7 @@ requestFrame decodeRequestFrame(bool *frame, int frameSize) {
       printf("Valid Frame!\n");
       printf("initSequence: %u\n", decFrame.initSeq);
       printf("Sequence number: %u\n", decFrame.sequenceNumber);
+      printf("Selective ack: %x\n", decFrame.sack);
     }
   }
   return decFrame;
@@ -185,7 +278,9 @@ int printRequestFrame(bool *frame, int frameSize) {
     printf("\n");
     printf("|%d %d %d %d|%d %d %d %d|",frame[0],frame[1],frame[2],frame[3],frame[4],frame[5],frame[6],frame[7]);
     printf("\n");
-    printf("|%d %d %d %d|        |",frame[8],frame[9],frame[10],frame[11]);
+    printf("|%d %d %d %d|%d %d %d %d|",frame[8],frame[9],frame[10],frame[11],frame[12],frame[13],frame[14],frame[15]);
+    printf("\n");
+    printf("|%d %d %d %d|        |",frame[16],frame[17],frame[18],frame[19]);
     printf("\n");
     printf("+-+-+-+-+-+-+-+-+");
     printf("\n");
@@ -203,7 +298,9 @@ int printRequestFrame_i(int *frame, int frameSize) {
     printf("\n");
     printf("|%i %i %i %i|%i %i %i %i|",frame[0],frame[1],frame[2],frame[3],frame[4],frame[5],frame[6],frame[7]);
     printf("\n");
-    printf("|%i %i %i %i|        |",frame[8],frame[9],frame[10],frame[11]);
+    printf("|%i %i %i %i|%i %i %i %i|",frame[8],frame[9],frame[10],frame[11],frame[12],frame[13],frame[14],frame[15]);
+    printf("\n");
+    printf("|%i %i %i %i|        |",frame[16],frame[17],frame[18],frame[19]);
     printf("\n");
     printf("+-+-+-+-+-+-+-+-+");
     printf("\n");
@@ -220,7 +317,7 @@ int printRequestFrame_f(requestFrame rFrame) {
   printf("\n");
   printf("|%i %i %i %i|%i %i %i %i|",(rFrame.initSeq >> 3) & 1,(rFrame.initSeq >> 2) & 1,(rFrame.initSeq >> 1) & 1,(rFrame.initSeq >> 0) & 1,(rFrame.sequenceNumber >> 7) & 1,(rFrame.sequenceNumber >> 6) & 1,(rFrame.sequenceNumber >> 5) & 1,(rFrame.sequenceNumber >> 4) & 1);
   printf("\n");
-  printf("|%i %i %i %i|",(rFrame.sequenceNumber >> 3) & 1,(rFrame.sequenceNumber >> 2) & 1,(rFrame.sequenceNumber >> 1) & 1,(rFrame.sequenceNumber >> 0) & 1);
+  printf("|%i %i %i %i|%i %i %i %i|",(rFrame.sequenceNumber >> 3) & 1,(rFrame.sequenceNumber >> 2) & 1,(rFrame.sequenceNumber >> 1) & 1,(rFrame.sequenceNumber >> 0) & 1,(rFrame.sack >> 3) & 1,(rFrame.sack >> 2) & 1,(rFrame.sack >> 1) & 1,(rFrame.sack >> 0) & 1);
   printf("\n");
   printf("+-+-+-+-+-+-+-+-+");
   printf("\n");
@@ -6,6 +6,17 @@
 #include <stdbool.h>
 #include <math.h>
 
+#include "config.h"
+#include "convCode.h"
+
+// Largest data frame, with the rate 1/2 code: the init sequence is not coded
+#define MAX_DATA_FRAME_SIZE (4 + 2 * (DATA_FRAME_SIZE - 4 + CONV_TAIL))
+
+// Bits a frame carries for the goodput: the data byte of a data frame, the
+// sequence number and selective ack of a request frame
+#define DATA_PAYLOAD_BITS 8
+#define REQUEST_PAYLOAD_BITS 8
+
 typedef struct {
     unsigned int initSeq;
     unsigned int sequenceNumber;
@@ -15,10 +26,16 @@ typedef struct {
 
 typedef struct {
     unsigned int initSeq;
-    unsigned int sequenceNumber;
+    unsigned int sequenceNumber; // Cumulative ack: every frame before it was received
+    unsigned int sack; // Selective ack: bit i set if frame sequenceNumber+1+i was received
 } requestFrame;
 
 int createDataFrame(char data, int sequenceNumber, bool *frame, int frameSize);
+int createRequestFrame(int sequenceNumber, int sack, bool *frame, int frameSize);
+
+int dataFrameSize(int fecMode);
+int createCodedDataFrame(char data, int sequenceNumber, int fecMode, bool *frame);
+int decodeCodedDataFrame(bool *frame, int frameSize, int fecMode, int *sequenceNumber, char *data);
 
 dataFrame decodeDataFrame(bool *frame, int frameSize, int* sequenceNumber, char* data);
 
@@ -1,96 +1,119 @@
 #include "hammingCode.h"
+#include "config.h"
 
 #include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 
-#define R1 3            // number of rows in Matrix 1
-#define C1 7            // number of columns in Matrix 1
-#define R2 7            // number of rows in Matrix 2
-#define C2 1            // number of columns in Matrix 2
+#define CORRECTED_FLAG 0x10 // Set in the decode table for single errors
 
-void mulMat(int mat1[R1][C1], int mat2[R2][C2], int rslt[R1][C2]) {
-    for (int i = 0; i < R1; i++) {
-        for (int j = 0; j < C2; j++) {
-            rslt[i][j] = 0;
-            for (int k = 0; k < R2; k++) {
-                rslt[i][j] += mat1[i][k] * mat2[k][j];
-            }
-        }
+
+// Codeword of each nibble, see hammingCode.h for the bit layout
+static const uint8_t encodeTable[1 << ACTUAL_BIT] = {
+  0x00, 0x4b, 0xaa, 0xe1, 0x99, 0xd2, 0x33, 0x78,
+  0x87, 0xcc, 0x2d, 0x66, 0x1e, 0x55, 0xb4, 0xff
+};
+
+// Data of each received byte, with CORRECTED_FLAG, or HAMMING_DOUBLE_ERROR
+static int8_t decodeTable[1 << CODED_BITS];
+static pthread_once_t decodeOnce = PTHREAD_ONCE_INIT;
+
+static atomic_ulong corrections;
+
+
+static void buildDecodeTable() {
+  for (int byte = 0; byte < (1 << CODED_BITS); byte++) {
+    decodeTable[byte] = HAMMING_DOUBLE_ERROR;
+  }
+  // The minimum distance is 4, so these never overlap
+  for (int nibble = 0; nibble < (1 << ACTUAL_BIT); nibble++) {
+    decodeTable[encodeTable[nibble]] = nibble;
+    for (int bit = 0; bit < CODED_BITS; bit++) {
+      decodeTable[encodeTable[nibble] ^ (1 << bit)] = nibble | CORRECTED_FLAG;
     }
+  }
 }
 
 
-int hammingEncode(int *message, int *encodedMessage) {
-  // Data bits:
-  encodedMessage[2] = message[0];
-  encodedMessage[4] = message[1];
-  encodedMessage[5] = message[2];
-  encodedMessage[6] = message[3];
-
-  // Parity bits:
-  encodedMessage[0] = message[0] ^ message[1] ^ message[3];
-  encodedMessage[1] = message[0] ^ message[2] ^ message[3];
-  encodedMessage[3] = message[1] ^ message[2] ^ message[3];
-  encodedMessage[7] = encodedMessage[0] ^ encodedMessage[1] ^ encodedMessage[2] ^ encodedMessage[3] ^ encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6];
 
-  return 1;
+uint8_t hammingEncodeNibble(unsigned nibble) {
+  return encodeTable[nibble & 0xF];
 }
 
-int hammingErrorCount(int *encodedMessage) {
-  int correctCode = 1;
-  correctCode &= (encodedMessage[0] == (encodedMessage[2] ^ encodedMessage[4] ^ encodedMessage[6]));
-  correctCode &= (encodedMessage[1] == (encodedMessage[2] ^ encodedMessage[5] ^ encodedMessage[6]));
-  correctCode &= (encodedMessage[3] == (encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6]));
-  correctCode &= (encodedMessage[7] == (encodedMessage[0] ^ encodedMessage[1] ^ encodedMessage[2] ^ encodedMessage[3] ^ encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6]));
-  if (correctCode) {
-    return 0;
+
+
+int hammingDecodeByte(uint8_t codeword, int *corrected) {
+  pthread_once(&decodeOnce, buildDecodeTable);
+  int entry = decodeTable[codeword];
+  if (corrected != NULL) *corrected = (entry >= 0) && (entry & CORRECTED_FLAG);
+  return entry < 0 ? HAMMING_DOUBLE_ERROR : entry & 0xF;
+}
+
+
+
+int hammingEncode(int *message, int *encodedMessage) {
+  unsigned nibble = 0;
+  for (int i = 0; i < ACTUAL_BIT; i++) {
+    nibble = (nibble << 1) | (message[i] & 1);
   }
-  else {
-    if (encodedMessage[7] != (encodedMessage[0] ^ encodedMessage[1] ^ encodedMessage[2] ^ encodedMessage[3] ^ encodedMessage[4] ^ encodedMessage[5] ^ encodedMessage[6])) { // Single error
-      return 1;
-    }
-    else { // Double error
-      return 2;
-    }
+  uint8_t codeword = hammingEncodeNibble(nibble);
+  for (int i = 0; i < CODED_BITS; i++) {
+    encodedMessage[i] = (codeword >> i) & 1;
   }
+  return 1;
 }
 
 
-int hammingCorrectError(int *encodedMessage){
-  int errorIndex = 0;
-  int controlMatrix[R1][C1] = {
-    {0,0,0,1,1,1,1},
-    {0,1,1,0,0,1,1},
-    {1,0,1,0,1,0,1}
-  };
 
-  int encodedMessageMat[R2][C2];
-  for (int i = 0; i < CODED_BITS -1; i++) {
-    encodedMessageMat[i][0] = encodedMessage[i];
+int hammingDecodeField(uint8_t codeword) {
+  int corrected;
+  int value = hammingDecodeByte(codeword, &corrected);
+  if ((value == HAMMING_DOUBLE_ERROR) || (corrected && !HAMMING_CORRECTION)) {
+    return -1;
   }
-  int rslt[R1][C2];
+  if (corrected) atomic_fetch_add_explicit(&corrections, 1, memory_order_relaxed);
+  return value;
+}
 
-  mulMat(controlMatrix, encodedMessageMat, rslt);
-  errorIndex = (rslt[0][0]%2) * 4 + (rslt[0][1]%2) * 2 + (rslt[0][2]%2) - 1;
-  encodedMessage[errorIndex] ^= 1; // Opposite bit;
+
+
+int hammingDecodeFields(const uint8_t *codewords, int count, int *values) {
+  int correctedCount = 0;
+  for (int f = 0; f < count; f++) {
+    int corrected;
+    values[f] = hammingDecodeByte(codewords[f], &corrected);
+    if (values[f] == HAMMING_DOUBLE_ERROR) {
+      return -1;
+    }
+    correctedCount += corrected;
+  }
+  if ((correctedCount > 0) && (!HAMMING_CORRECTION || (correctedCount > 1))) {
+    return -1;
+  }
+  if (correctedCount > 0) atomic_fetch_add_explicit(&corrections, 1, memory_order_relaxed);
   return 1;
 }
 
 
 
 int hammingDecode(int *encodedMessage, int *decodedMessage) {
-  int errorCount = hammingErrorCount(encodedMessage);
-  if (errorCount == 1) {
-    // hammingCorrectError(encodedMessage);
-    return -1;
+  uint8_t codeword = 0;
+  for (int i = 0; i < CODED_BITS; i++) {
+    codeword |= (encodedMessage[i] & 1) << i;
   }
-  else if (errorCount > 1) {
+  int sequenceNumber = hammingDecodeField(codeword);
+  if (sequenceNumber == -1) {
     return -1;
   }
-  decodedMessage[0] = encodedMessage[2];
-  decodedMessage[1] = encodedMessage[4];
-  decodedMessage[2] = encodedMessage[5];
-  decodedMessage[3] = encodedMessage[6];
-  int sequenceNumber = decodedMessage[0]*8 + decodedMessage[1]*4 + decodedMessage[2]*2 + decodedMessage[3];
+  for (int i = 0; i < ACTUAL_BIT; i++) {
+    decodedMessage[i] = (sequenceNumber >> (ACTUAL_BIT - 1 - i)) & 1;
+  }
   return sequenceNumber;
 }
+
+
+
+unsigned long getHammingCorrections() {
+  return atomic_load(&corrections);
+}
@@ -1,12 +1,76 @@
+/*!
+   \file hammingCode.h
+   \brief Extended (8,4) Hamming code (SECDED) of the request frame fields:
+          single errors are corrected, double errors detected.
+          Codewords are packed in a byte, bit i holding encodedMessage[i] of
+          the bit array functions: parity bits at 0, 1 and 3, data bits at 2,
+          4, 5 and 6 (most significant first), overall parity at 7.
+          Encoding is a lookup in a 16 entry table, decoding a lookup in a 256
+          entry table built once from it: each codeword, and each of its 8
+          single error neighbours, maps to its data, every other byte is a
+          double error.
+*/
+
 #ifndef HAMMING_H
 #define HAMMING_H
 
+#include <stdint.h>
+
 #define ACTUAL_BIT 4
 #define PARITY_BITS 4
-#define CODED_BITS ACTUAL_BIT + PARITY_BITS // 8
+#define CODED_BITS (ACTUAL_BIT + PARITY_BITS) // 8
+
+#define HAMMING_DOUBLE_ERROR -1
+
+
+/*!
+   \fn uint8_t hammingEncodeNibble(unsigned nibble)
+   \return The packed codeword of the 4 low bits of nibble
+*/
+uint8_t hammingEncodeNibble(unsigned nibble);
+
+
+
+/*!
+   \fn int hammingDecodeByte(uint8_t codeword, int *corrected)
+   \brief Decodes a packed codeword, correcting a single error. corrected (if
+          not NULL) is set to 1 when an error was corrected, 0 otherwise.
+   \return The data nibble, HAMMING_DOUBLE_ERROR if two errors were detected
+*/
+int hammingDecodeByte(uint8_t codeword, int *corrected);
+
 
+
+/*!
+   \fn int hammingDecodeField(uint8_t codeword)
+   \brief Decodes a field of a request frame: single errors are corrected
+          (and counted) if HAMMING_CORRECTION is set, rejected otherwise
+   \return The data nibble, -1 if the field is rejected
+*/
+int hammingDecodeField(uint8_t codeword);
+
+
+
+/*!
+   \fn int hammingDecodeFields(const uint8_t *codewords, int count, int *values)
+   \brief Decodes the fields of a request frame. With HAMMING_CORRECTION, a
+          single error is corrected in one field at most: a frame that needs
+          more corrections has several errors, and is more likely to be
+          corrected into a wrong frame than into the one sent.
+   \param[out] values The data nibble of each field
+   \return 1 if the frame is accepted, -1 if it is rejected
+*/
+int hammingDecodeFields(const uint8_t *codewords, int count, int *values);
+
+
+
+// Same on bit arrays of ACTUAL_BIT and CODED_BITS ints
 int hammingEncode(int *message, int *encodedMessage);
+// Returns the data as a number, -1 if the field is rejected
 int hammingDecode(int *encodedMessage, int *decodedMessage);
 
+// Single errors corrected by hammingDecodeField since the start
+unsigned long getHammingCorrections();
+
 
 #endif
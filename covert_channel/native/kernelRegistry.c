@@ -0,0 +1,46 @@
+/*!
+   \file kernelRegistry.c
+   \brief Lookup of the generated kernels, see kernelRegistry.h
+*/
+
+#include "kernelRegistry.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+
+int kernelSupported(const KernelInfo *kernel) {
+  __builtin_cpu_init();
+  // __builtin_cpu_supports only takes literals
+  switch (kernel->feature) {
+    case KERNEL_FEATURE_SSE42: return __builtin_cpu_supports("sse4.2") != 0;
+    case KERNEL_FEATURE_POPCNT: return __builtin_cpu_supports("popcnt") != 0;
+    case KERNEL_FEATURE_AES: return __builtin_cpu_supports("aes") != 0;
+    case KERNEL_FEATURE_AVX2: return __builtin_cpu_supports("avx2") != 0;
+    default: return 1;
+  }
+}
+
+
+
+const KernelInfo *findKernel(const char *name) {
+  for (int k = 0; k < kernelCount; k++) {
+    if (strcmp(kernelTable[k].name, name) == 0) {
+      return kernelSupported(&kernelTable[k]) ? &kernelTable[k] : NULL;
+    }
+  }
+  return NULL;
+}
+
+
+
+int printKernels() {
+  printf("kernel      \tports\tunroll\tchains\trepetitions\tsupported\n");
+  for (int k = 0; k < kernelCount; k++) {
+    const KernelInfo *kernel = &kernelTable[k];
+    printf("%-12s\t%s\t%i\t%i\t%" PRIu64 "\t\t%s\n", kernel->name, kernel->ports, kernel->unroll, kernel->chains,
+           kernel->repetitions, kernelSupported(kernel) ? "yes" : "no");
+  }
+  return 1;
+}
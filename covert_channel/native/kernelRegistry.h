@@ -0,0 +1,78 @@
+/*!
+   \file kernelRegistry.h
+   \brief Registry of the generated contention and timing kernels.
+          kernel_generator.py emits, for every instruction and unroll factor,
+          a spam kernel (like spam_port1_n) and a timing kernel (like
+          read_timings_n), and the table of them in build/kernelTable.c. They
+          are looked up by name, <instruction>_u<unroll> (crc32_u48 is the
+          loop of p1_spam.S and p1_time.S), so a single binary can sweep them
+          and pick the best contention source of the CPU it runs on.
+*/
+
+#ifndef KERNELREGISTRY_H
+#define KERNELREGISTRY_H
+
+#include <stdint.h>
+
+
+typedef void (*SpamKernel)(uint64_t repetitions); // repetitions > 0
+typedef void (*TimingKernel)(uint64_t *buffer, uint64_t passCount); // passCount > 0
+
+
+// CPU features a kernel may need
+typedef enum {
+  KERNEL_FEATURE_NONE,
+  KERNEL_FEATURE_SSE42,
+  KERNEL_FEATURE_POPCNT,
+  KERNEL_FEATURE_AES,
+  KERNEL_FEATURE_AVX2
+} KernelFeature;
+
+
+/*!
+   \struct KernelInfo
+   \brief A generated kernel, in its spam and timing kinds
+*/
+typedef struct {
+  const char *name; // <instruction>_u<unroll>
+  const char *instruction;
+  const char *ports; // Execution ports it contends, "1", "23"...
+  KernelFeature feature;
+  int unroll; // Instructions per chain in a repetition
+  int chains; // Independent dependency chains
+  uint64_t repetitions; // Repetitions running as many instructions as spam_port1
+  SpamKernel spam;
+  TimingKernel time;
+} KernelInfo;
+
+
+// Generated by kernel_generator.py
+extern const KernelInfo kernelTable[];
+extern const int kernelCount;
+
+
+
+/*!
+   \fn int kernelSupported(const KernelInfo *kernel)
+   \return 1 if the CPU has the feature the kernel needs, 0 otherwise
+*/
+int kernelSupported(const KernelInfo *kernel);
+
+
+
+/*!
+   \fn const KernelInfo *findKernel(const char *name)
+   \return The kernel of that name, NULL if there is none or the CPU cannot
+           run it
+*/
+const KernelInfo *findKernel(const char *name);
+
+
+
+/*!
+   \fn int printKernels()
+   \brief Prints the table of the kernels
+*/
+int printKernels();
+
+#endif
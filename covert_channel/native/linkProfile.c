@@ -0,0 +1,117 @@
+/*!
+   \file linkProfile.c
+   \brief Link parameters of the native side, see linkProfile.h
+*/
+
+#include "linkProfile.h"
+#include "config.h"
+#include "thresholdDetection.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+
+LinkProfile linkProfile = {BIT_DURATION, SENDER_REP, RECEIVER_REP, JMP_THRESHOLD, MIN_SPIKE, MAX_SPIKE, BIT_SIZE_0, BIT_SIZE_1};
+
+
+
+int initLinkProfile(LinkProfile *lp) {
+  lp->bitDuration = BIT_DURATION;
+  lp->senderRep = SENDER_REP;
+  lp->receiverRep = RECEIVER_REP;
+  lp->jmpThreshold = JMP_THRESHOLD;
+  lp->minSpike = MIN_SPIKE;
+  lp->maxSpike = MAX_SPIKE;
+  lp->bitSize_0 = BIT_SIZE_0;
+  lp->bitSize_1 = BIT_SIZE_1;
+  return 1;
+}
+
+
+
+int checkLinkProfile(LinkProfile *lp) {
+  if ((lp->bitDuration <= 0) | (lp->senderRep == 0) | (lp->receiverRep < 2) | (lp->receiverRep > MAX_RECEIVER_REP)
+      | (lp->jmpThreshold <= 0) | (lp->minSpike < 0) | (lp->maxSpike <= lp->minSpike)
+      | (lp->bitSize_0 <= 0.) | (lp->bitSize_1 <= 0.)) {
+    return -1;
+  }
+  return 1;
+}
+
+
+
+int loadLinkProfile(LinkProfile *lp, const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return errno == ENOENT ? 0 : -1;
+  }
+  LinkProfile loaded = *lp;
+  char line[256];
+  int lineNumber = 0;
+  int ret = 1;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineNumber++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL) *comment = '\0';
+
+    char key[64];
+    double value;
+    char end;
+    int fields = sscanf(line, " %63[a-z_0-9] = %lf %c", key, &value, &end);
+    if (fields == EOF) continue; // Blank line
+    if (fields != 2) {
+      fprintf(stderr, "%s:%i: expected \"key = value\"\n", path, lineNumber);
+      ret = -1;
+      continue;
+    }
+
+    if (strcmp(key, "bit_duration") == 0) loaded.bitDuration = (long) value;
+    else if (strcmp(key, "sender_rep") == 0) loaded.senderRep = (unsigned) value;
+    else if (strcmp(key, "receiver_rep") == 0) loaded.receiverRep = (unsigned) value;
+    else if (strcmp(key, "jmp_threshold") == 0) loaded.jmpThreshold = (int) value;
+    else if (strcmp(key, "min_spike") == 0) loaded.minSpike = (int) value;
+    else if (strcmp(key, "max_spike") == 0) loaded.maxSpike = (int) value;
+    else if (strcmp(key, "bit_size_0") == 0) loaded.bitSize_0 = value;
+    else if (strcmp(key, "bit_size_1") == 0) loaded.bitSize_1 = value;
+    else fprintf(stderr, "%s:%i: unknown key %s, ignored\n", path, lineNumber, key);
+  }
+  fclose(fp);
+
+  if ((ret == -1) || (checkLinkProfile(&loaded) == -1)) {
+    return -1;
+  }
+  *lp = loaded;
+  return 1;
+}
+
+
+
+int saveLinkProfile(LinkProfile *lp, const char *path, const char *comment) {
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    return -1;
+  }
+  if (comment != NULL) {
+    fprintf(fp, "# %s\n", comment);
+  }
+  fprintf(fp, "bit_duration = %ld\n", lp->bitDuration);
+  fprintf(fp, "sender_rep = %u\n", lp->senderRep);
+  fprintf(fp, "receiver_rep = %u\n", lp->receiverRep);
+  fprintf(fp, "jmp_threshold = %i\n", lp->jmpThreshold);
+  fprintf(fp, "min_spike = %i\n", lp->minSpike);
+  fprintf(fp, "max_spike = %i\n", lp->maxSpike);
+  fprintf(fp, "bit_size_0 = %.3f\n", lp->bitSize_0);
+  fprintf(fp, "bit_size_1 = %.3f\n", lp->bitSize_1);
+  return fclose(fp) == 0 ? 1 : -1;
+}
+
+
+
+int printLinkProfile(LinkProfile *lp) {
+  printf("Bit duration: %ld ns \t Sender rep: %u \t Receiver rep: %u\n", lp->bitDuration, lp->senderRep, lp->receiverRep);
+  printf("Threshold: %i \t Min spike: %i \t Max spike: %i \t Bit size 0: %.2f \t Bit size 1: %.2f\n",
+         lp->jmpThreshold, lp->minSpike, lp->maxSpike, lp->bitSize_0, lp->bitSize_1);
+  return 1;
+}
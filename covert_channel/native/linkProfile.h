@@ -0,0 +1,76 @@
+/*!
+   \file linkProfile.h
+   \brief Link parameters of the native side, defaulting to the macros of
+          config.h and thresholdDetection.h.
+          A profile can be saved to and loaded from a text file with one
+          "key = value" line per parameter, '#' starting a comment:
+            bit_duration = 1000000
+            sender_rep = 256
+            ...
+          The calibration mode (see calibration.h) writes such a file, and the
+          covert channel loads it at startup.
+*/
+
+#ifndef LINK_PROFILE_H
+#define LINK_PROFILE_H
+
+
+/*!
+   \struct LinkProfile
+   \brief Parameters of the physical layer and of the threshold detector
+*/
+typedef struct {
+  long bitDuration; // BIT_DURATION, in ns
+  unsigned senderRep; // SENDER_REP, repetitions of the spam loop
+  unsigned receiverRep; // RECEIVER_REP, passes of read_timings, up to MAX_RECEIVER_REP
+  int jmpThreshold; // JMP_THRESHOLD, between 0 and 1 bits
+  int minSpike; // MIN_SPIKE
+  int maxSpike; // MAX_SPIKE
+  double bitSize_0; // Points in a 0 bit
+  double bitSize_1; // Points in a 1 bit
+} LinkProfile;
+
+
+// Profile in use by the sender and the receiver
+extern LinkProfile linkProfile;
+
+
+
+/*!
+   \fn int initLinkProfile(LinkProfile *lp)
+   \brief Sets the compile time defaults
+*/
+int initLinkProfile(LinkProfile *lp);
+
+
+
+/*!
+   \fn int checkLinkProfile(LinkProfile *lp)
+   \return 1 if every parameter is usable, -1 otherwise
+*/
+int checkLinkProfile(LinkProfile *lp);
+
+
+
+/*!
+   \fn int loadLinkProfile(LinkProfile *lp, const char *path)
+   \brief Reads a profile file. Missing keys keep their current value.
+   \return 1 if ok, 0 if the file does not exist, -1 if it is invalid (lp is
+           left untouched)
+*/
+int loadLinkProfile(LinkProfile *lp, const char *path);
+
+
+
+/*!
+   \fn int saveLinkProfile(LinkProfile *lp, const char *path, const char *comment)
+   \brief Writes a profile file, comment (if not NULL) is written on top
+   \return 1 if ok, -1 if the file cannot be written
+*/
+int saveLinkProfile(LinkProfile *lp, const char *path, const char *comment);
+
+
+
+int printLinkProfile(LinkProfile *lp);
+
+#endif
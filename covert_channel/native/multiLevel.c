@@ -0,0 +1,198 @@
+/*!
+   \file multiLevel.c
+   \brief Multi-level symbols, see multiLevel.h
+*/
+
+#include "multiLevel.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SYMBOL_POINTS 256 // Points of a symbol used for its level
+
+
+int bitsPerSymbol(int levelCount) {
+  for (int bits = 1; (1 << bits) <= MAX_LEVELS; bits++) {
+    if ((1 << bits) == levelCount) return bits;
+  }
+  return -1;
+}
+
+
+
+int createLevelPreamble(int levelCount, int *symbols) {
+  symbols[0] = levelCount - 1;
+  symbols[1] = 0;
+  symbols[2] = levelCount - 1;
+  symbols[3] = 0;
+  for (int level = 0; level < levelCount; level++) {
+    symbols[INIT_SYMBOLS + level] = level;
+  }
+  return INIT_SYMBOLS + levelCount;
+}
+
+
+
+int bitsToSymbols(bool *bits, int bitCount, int levelCount, int *symbols) {
+  int width = bitsPerSymbol(levelCount);
+  int symbolCount = (bitCount + width - 1) / width;
+  for (int s = 0; s < symbolCount; s++) {
+    int value = 0;
+    for (int b = 0; b < width; b++) {
+      int index = s * width + b;
+      value = (value << 1) | ((index < bitCount) && bits[index]);
+    }
+    // Gray code: neighbour levels differ by one bit
+    symbols[s] = value ^ (value >> 1);
+  }
+  return symbolCount;
+}
+
+
+
+int symbolsToBits(int *symbols, int symbolCount, int levelCount, bool *bits, int bitCount) {
+  int width = bitsPerSymbol(levelCount);
+  for (int s = 0; s < symbolCount; s++) {
+    int value = symbols[s];
+    for (int shift = 1; shift < width; shift <<= 1) {
+      value ^= value >> shift;
+    }
+    for (int b = 0; b < width; b++) {
+      int index = s * width + b;
+      if (index < bitCount) bits[index] = (value >> (width - 1 - b)) & 1;
+    }
+  }
+  return 1;
+}
+
+
+
+// Index of the next edge after from, ie the first of minSpike points in a row
+// on the other side of the threshold. -1 if there is none.
+static long findEdge(unsigned int *points, size_t pointCount, size_t from, int rising, LinkProfile *lp) {
+  int run = 0;
+  int minRun = lp->minSpike > 1 ? lp->minSpike : 1;
+  for (size_t i = from; i < pointCount; i++) {
+    int high = points[i] > (unsigned int) lp->jmpThreshold;
+    run = high == rising ? run + 1 : 0;
+    if (run == minRun) {
+      return i + 1 - run;
+    }
+  }
+  return -1;
+}
+
+
+
+// Median of the central half of a symbol, -1 if it is past the points
+static double symbolLevel(unsigned int *points, size_t pointCount, LevelResults *lr, int symbolIndex) {
+  size_t first = lr->start + (size_t) ((symbolIndex + 0.25) * lr->symbolSize);
+  size_t last = lr->start + (size_t) ((symbolIndex + 0.75) * lr->symbolSize);
+  if (last >= pointCount) {
+    return -1.;
+  }
+  size_t count = last - first + 1;
+  if (count > MAX_SYMBOL_POINTS) count = MAX_SYMBOL_POINTS;
+  unsigned int values[MAX_SYMBOL_POINTS];
+  memcpy(values, &points[first], count * sizeof(unsigned int));
+  qsort(values, count, sizeof(unsigned int), comp);
+  return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.;
+}
+
+
+
+// Finds the 1010 init sequence: rising, falling, rising then falling edge
+static int findInitSequence(unsigned int *points, size_t pointCount, LinkProfile *lp, LevelResults *lr) {
+  long edges[INIT_SYMBOLS];
+  long from = 0;
+  for (int e = 0; e < INIT_SYMBOLS; e++) {
+    edges[e] = findEdge(points, pointCount, from, e % 2 == 0, lp);
+    if (edges[e] == -1) {
+      return -1;
+    }
+    from = edges[e];
+  }
+  lr->start = edges[0];
+  lr->symbolSize = (edges[3] - edges[0]) / 3.;
+  return lr->symbolSize < 2. ? -1 : 1;
+}
+
+
+
+// Classifies up to symbolCount symbols from firstSymbol with the thresholds of lr
+static int classifySymbols(unsigned int *points, size_t pointCount, LevelResults *lr, int firstSymbol, int *symbols, int symbolCount) {
+  for (int s = 0; s < symbolCount; s++) {
+    double level = symbolLevel(points, pointCount, lr, firstSymbol + s);
+    if (level < 0.) {
+      return s;
+    }
+    int symbol = 0;
+    while ((symbol < lr->levelCount - 1) && (level > lr->thresholds[symbol])) {
+      symbol++;
+    }
+    symbols[s] = symbol;
+  }
+  return symbolCount;
+}
+
+
+
+int decodeLevels(unsigned int *points, size_t pointCount, LinkProfile *lp, int levelCount, int *symbols, int symbolCount, LevelResults *lr) {
+  lr->levelCount = levelCount;
+  if (findInitSequence(points, pointCount, lp, lr) == -1) {
+    return -1;
+  }
+
+  // Then each level once
+  for (int level = 0; level < levelCount; level++) {
+    lr->levels[level] = symbolLevel(points, pointCount, lr, INIT_SYMBOLS + level);
+    if ((lr->levels[level] < 0.) || ((level > 0) && (lr->levels[level] <= lr->levels[level - 1]))) {
+      return -1;
+    }
+  }
+  for (int level = 0; level < levelCount - 1; level++) {
+    lr->thresholds[level] = (lr->levels[level] + lr->levels[level + 1]) / 2;
+  }
+
+  return classifySymbols(points, pointCount, lr, INIT_SYMBOLS + levelCount, symbols, symbolCount);
+}
+
+
+
+int decodeBinary(unsigned int *points, size_t pointCount, LinkProfile *lp, int *symbols, int symbolCount, LevelResults *lr) {
+  lr->levelCount = 2;
+  if (findInitSequence(points, pointCount, lp, lr) == -1) {
+    return -1;
+  }
+
+  // The init sequence holds two 1s and two 0s
+  double high[2], low[2];
+  for (int i = 0; i < 2; i++) {
+    high[i] = symbolLevel(points, pointCount, lr, 2 * i);
+    low[i] = symbolLevel(points, pointCount, lr, 2 * i + 1);
+    if ((high[i] < 0.) || (low[i] < 0.)) {
+      return -1;
+    }
+  }
+  lr->levels[0] = (low[0] + low[1]) / 2;
+  lr->levels[1] = (high[0] + high[1]) / 2;
+  if (lr->levels[1] <= lr->levels[0]) {
+    return -1;
+  }
+  lr->thresholds[0] = (lr->levels[0] + lr->levels[1]) / 2;
+  return classifySymbols(points, pointCount, lr, INIT_SYMBOLS, symbols, symbolCount);
+}
+
+
+
+int printLevelResults(LevelResults *lr) {
+  printf("Start: %zu \t Symbol size: %.2f points\n", lr->start, lr->symbolSize);
+  for (int level = 0; level < lr->levelCount; level++) {
+    printf("Level %i: %.1f", level, lr->levels[level]);
+    if (level < lr->levelCount - 1) printf(" \t Threshold: %.1f", lr->thresholds[level]);
+    printf("\n");
+  }
+  return 1;
+}
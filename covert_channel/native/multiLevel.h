@@ -0,0 +1,102 @@
+/*!
+   \file multiLevel.h
+   \brief Multi-level symbols: more than one bit per symbol period.
+          The sender modulates the contention intensity: a symbol of level k
+          out of L spams port 1 during k/(L-1) of every SYMBOL_DUTY_PERIOD,
+          and is idle the rest of it. log2(L) bits, Gray coded so that
+          neighbour levels differ by a single bit, are sent per symbol.
+          Frames start with an extended init sequence: the binary 1010 (levels
+          L-1 and 0), giving the start and the symbol size, then every level
+          from 0 to L-1, giving the median point of each level. The receiver
+          classifies the symbols that follow with thresholds halfway between
+          these medians.
+*/
+
+#ifndef MULTILEVEL_H
+#define MULTILEVEL_H
+
+#include "linkProfile.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MAX_LEVELS 8
+#define INIT_SYMBOLS 4 // 1010
+
+
+/*!
+   \struct LevelResults
+   \brief What the receiver learned from the extended init sequence
+*/
+typedef struct {
+  int levelCount;
+  size_t start; // Point of the first rising edge
+  double symbolSize; // Points per symbol
+  double levels[MAX_LEVELS]; // Median point of each level
+  double thresholds[MAX_LEVELS - 1]; // Between level k and k+1
+} LevelResults;
+
+
+
+/*!
+   \fn int bitsPerSymbol(int levelCount)
+   \return log2(levelCount), -1 if it is not a power of two between 2 and MAX_LEVELS
+*/
+int bitsPerSymbol(int levelCount);
+
+
+
+/*!
+   \fn int createLevelPreamble(int levelCount, int *symbols)
+   \brief Extended init sequence: 1010 then every level, in increasing order
+   \return Its number of symbols, INIT_SYMBOLS + levelCount
+*/
+int createLevelPreamble(int levelCount, int *symbols);
+
+
+
+/*!
+   \fn int bitsToSymbols(bool *bits, int bitCount, int levelCount, int *symbols)
+   \brief Groups the bits in Gray coded symbols, the last one padded with 0s
+   \return Number of symbols
+*/
+int bitsToSymbols(bool *bits, int bitCount, int levelCount, int *symbols);
+
+
+
+/*!
+   \fn int symbolsToBits(int *symbols, int symbolCount, int levelCount, bool *bits, int bitCount)
+   \brief Inverse of bitsToSymbols, up to bitCount bits
+*/
+int symbolsToBits(int *symbols, int symbolCount, int levelCount, bool *bits, int bitCount);
+
+
+
+/*!
+   \fn int decodeLevels(unsigned int *points, size_t pointCount, LinkProfile *lp, int levelCount, int *symbols, int symbolCount, LevelResults *lr)
+   \brief Finds the extended init sequence in the points (with the threshold
+          and spike size of the profile), learns the levels and classifies up
+          to symbolCount symbols after it. Each symbol is the median of the
+          central half of its points, away from the edges.
+   \return Number of symbols decoded, -1 if there is no init sequence or its
+           levels are not increasing
+*/
+int decodeLevels(unsigned int *points, size_t pointCount, LinkProfile *lp, int levelCount, int *symbols, int symbolCount, LevelResults *lr);
+
+
+
+/*!
+   \fn int decodeBinary(unsigned int *points, size_t pointCount, LinkProfile *lp, int *symbols, int symbolCount, LevelResults *lr)
+   \brief decodeLevels for binary frames starting with the plain 1010 init
+          sequence: the levels of the 0s and 1s are learned from it, so the
+          threshold between them follows the link instead of lp->jmpThreshold,
+          which is only used to find the edges
+   \return Number of bits decoded, -1 if there is no init sequence
+*/
+int decodeBinary(unsigned int *points, size_t pointCount, LinkProfile *lp, int *symbols, int symbolCount, LevelResults *lr);
+
+
+
+int printLevelResults(LevelResults *lr);
+
+#endif
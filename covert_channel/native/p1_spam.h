@@ -25,6 +25,7 @@
 #ifndef __ASSEMBLER__
 #include <stdint.h>
 extern void spam_port1();
+extern void spam_port1_n(uint64_t repetitions); // repetitions > 0
 #endif
 
 #endif
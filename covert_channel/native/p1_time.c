@@ -14,8 +14,10 @@
 *   See the License for the specific language governing permissions and
 *   limitations under the License.
 **/
-include "p1_time.h"
+#include "p1_time.h"
 #include "config.h"
+#include "trace.h"
+#include "linkProfile.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,26 +26,27 @@ include "p1_time.h"
 #include <string.h>
 #include <unistd.h>
 
-int startTimings() {
-  char path[100];
-  for (size_t i = 0; i < 100; i++) {
-    // sprintf(path, "./raw_data/timings_%zu.bin", i);
-    size_t ret;
-    ret = 0;
-    uint64_t *timings = (uint64_t *)calloc(RECEIVER_REP, sizeof(uint64_t));
-    assert(timings != NULL);
-    read_timings(timings);
-    FILE *fp;
-    fp = fopen(path, "wb");
-    //assert(fp != NULL);
-
-    ret = fwrite(timings, sizeof(uint64_t), RECEIVER_REP, fp);
-    assert(ret == RECEIVER_REP);
+// Standalone capture: records passCount back-to-back read_timings passes of
+// the calling thread in a trace file that can be fed to the replay tool.
+int startTimings(const char *path, size_t passCount) {
+  TraceWriter tw;
+  size_t passes = linkProfile.receiverRep;
+  if (openTraceWriter(&tw, path, passes, 1) == -1) {
+    fprintf(stderr, "Cannot open trace file %s\n", path);
+    return -1;
+  }
 
-    fclose(fp);
-    free(timings);
-    sleep(1);
+  uint64_t *timings = (uint64_t *)calloc(passes, sizeof(uint64_t));
+  assert(timings != NULL);
+  for (size_t i = 0; i < passCount; i++) {
+    read_timings_n(timings, passes);
+    if (writeTracePass(&tw, 0, timings, passes) == -1) {
+      fprintf(stderr, "Short write on trace file %s\n", path);
+      break;
+    }
   }
+  free(timings);
 
+  closeTraceWriter(&tw);
   return 0;
 }
@@ -22,8 +22,10 @@
 #define SPY_PIPE "pipe.fifo"
 #ifndef __ASSEMBLER__
 #include <stdint.h>
+#include <stddef.h>
 
 extern void read_timings(uint64_t *buffer);
-int startTimings();
+extern void read_timings_n(uint64_t *buffer, uint64_t passCount); // passCount > 0
+int startTimings(const char *path, size_t passCount);
 #endif
 #endif
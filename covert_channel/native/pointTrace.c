@@ -0,0 +1,63 @@
+/*!
+   \file pointTrace.c
+   \brief Memory mapped ring traces of the listener points, see pointTrace.h
+*/
+
+#include "pointTrace.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// The format is read by plot.py
+_Static_assert(sizeof(PointTraceHeader) == 64, "PointTraceHeader is a cache line");
+_Static_assert(sizeof(PointRecord) == 24, "PointRecord is 24 bytes");
+
+
+int openPointTrace(PointTraceWriter *pw, const char *path, size_t capacity, int threadNumber) {
+  size_t slots = 1;
+  while (slots < capacity) slots <<= 1;
+  size_t mapSize = sizeof(PointTraceHeader) + slots * sizeof(PointRecord);
+
+  pw->header = NULL;
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    return -1;
+  }
+  if (ftruncate(fd, mapSize) == -1) {
+    close(fd);
+    return -1;
+  }
+  void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // The mapping keeps the file
+  if (map == MAP_FAILED) {
+    return -1;
+  }
+  // Dirty every page now, not on the measurement path
+  memset(map, 0, mapSize);
+  mlock(map, mapSize); // Best effort, may be denied by RLIMIT_MEMLOCK
+
+  pw->header = (PointTraceHeader *) map;
+  pw->records = (PointRecord *) ((char *) map + sizeof(PointTraceHeader));
+  pw->mask = slots - 1;
+  pw->mapSize = mapSize;
+  memcpy(pw->header->magic, POINT_TRACE_MAGIC, 4);
+  pw->header->version = POINT_TRACE_VERSION;
+  pw->header->headerSize = sizeof(PointTraceHeader);
+  pw->header->recordSize = sizeof(PointRecord);
+  pw->header->capacity = slots;
+  pw->header->threadNumber = threadNumber;
+  atomic_store(&pw->header->head, 0);
+  return 1;
+}
+
+
+
+int closePointTrace(PointTraceWriter *pw) {
+  if (pw->header != NULL) {
+    munmap(pw->header, pw->mapSize);
+    pw->header = NULL;
+  }
+  return 1;
+}
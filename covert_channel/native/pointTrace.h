@@ -0,0 +1,107 @@
+/*!
+   \file pointTrace.h
+   \brief Trace of what a listener fed its detector: for every listen() the
+          timing, the filtered point when the filter output one, and the state
+          of the detector after it.
+          Each listener writes its own file, mapped in memory as a ring of
+          fixed size records: a PointTraceHeader then capacity PointRecords.
+          Writing a record is a copy in the mapping and a store of the head,
+          without lock nor system call, and the memory used is bounded by the
+          capacity. Once the ring is full the oldest records are overwritten:
+          record i is at slot i % capacity, head is the number of records
+          written so far. The kernel writes the pages back to the file, even
+          if the process is killed.
+          Everything is stored in host (little-endian) byte order, plot.py
+          reads these files.
+*/
+
+#ifndef POINTTRACE_H
+#define POINTTRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define POINT_TRACE_MAGIC "PCPT"
+#define POINT_TRACE_VERSION 1
+#define POINT_TRACE_SIZE (1<<16) // Records kept per listener, 1.5 MB
+
+// Flags of a record
+#define POINT_FILTERED 1 // The filter output a point for this timing
+#define POINT_INIT_SEQUENCE 2 // The detector has found the init sequence
+#define POINT_FRAME_END 4 // The detector holds a full frame after this point
+
+
+/*!
+   \struct PointTraceHeader
+   \brief First bytes of a point trace, a whole cache line so the records
+          stay aligned
+*/
+typedef struct {
+  char magic[4]; // POINT_TRACE_MAGIC, not null terminated
+  uint16_t version; // POINT_TRACE_VERSION
+  uint16_t headerSize; // sizeof(PointTraceHeader), the records start there
+  uint32_t recordSize; // sizeof(PointRecord)
+  uint32_t capacity; // Records in the ring, a power of two
+  uint32_t threadNumber; // Listener that wrote the trace
+  uint32_t reserved;
+  _Atomic uint64_t head; // Records written so far
+  char padding[32];
+} PointTraceHeader;
+
+
+/*!
+   \struct PointRecord
+   \brief One listen() of a listener
+*/
+typedef struct {
+  uint64_t tsc; // When the timing was measured, simulated TSC on a simulated channel
+  uint32_t timing; // listen() output, in the unit of the points
+  uint32_t point; // Filter output, 0 without POINT_FILTERED
+  uint16_t bitCount; // Bits held by the detector
+  uint8_t flags; // POINT_*
+  uint8_t reserved;
+  uint32_t padding;
+} PointRecord;
+
+
+typedef struct {
+  PointTraceHeader *header; // Mapped file, NULL when closed
+  PointRecord *records;
+  size_t mask; // capacity - 1
+  size_t mapSize;
+} PointTraceWriter;
+
+
+
+/*!
+   \fn int openPointTrace(PointTraceWriter *pw, const char *path, size_t capacity, int threadNumber)
+   \brief Creates (or truncates) a trace file of capacity records, rounded up to
+          a power of two, and maps it. The pages are touched (and locked when
+          allowed) right away so writing a record never faults.
+   \return 1 if ok, -1 if the file cannot be created or mapped
+*/
+int openPointTrace(PointTraceWriter *pw, const char *path, size_t capacity, int threadNumber);
+
+
+
+/*!
+   \fn void writePointRecord(PointTraceWriter *pw, const PointRecord *record)
+   \brief Appends a record. A single thread may write a trace at a time.
+*/
+static inline void writePointRecord(PointTraceWriter *pw, const PointRecord *record) {
+  uint64_t head = atomic_load_explicit(&pw->header->head, memory_order_relaxed);
+  pw->records[head & pw->mask] = *record;
+  // A reader of the mapping sees the record before the new head
+  atomic_store_explicit(&pw->header->head, head + 1, memory_order_release);
+}
+
+
+
+/*!
+   \fn int closePointTrace(PointTraceWriter *pw)
+   \brief Unmaps the trace, the file keeps the last capacity records
+*/
+int closePointTrace(PointTraceWriter *pw);
+
+#endif
@@ -3,11 +3,21 @@
 #include "receiver.h"
 #include "config.h"
 #include "p1_time.h"
+#include "p5_time.h"
 #include "utils.h"
 // #include "readBits.h"
 #include "frame.h"
 #include "covertChannel.h"
 #include "thresholdDetection.h"
+#include "trace.h"
+#include "ring.h"
+#include "filter.h"
+#include "linkProfile.h"
+#include "workerPool.h"
+#include "softDecision.h"
+#include "stageProfile.h"
+#include "pointTrace.h"
+#include "topology.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,8 +28,109 @@
 #include <time.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <stdatomic.h>
 #include <pthread.h>
+#include <immintrin.h>
+
+
+// Trace of the raw read_timings passes, only open when recording (-r)
+static TraceWriter receiverTrace = {NULL, 0};
+
+// Timing loop of port 1, a generated kernel may replace it (see kernelRegistry.h)
+static TimingKernel timingKernel = read_timings_n;
+
+// Point traces of the listeners, only open when tracing (-t)
+static PointTraceWriter pointTraces[MAX_PHY_CORE];
+
+// Pipelined mode (-p): listeners only measure and push their timings in a ring,
+// a single detection thread runs the median and the detector for all of them.
+static int pipelined = 0;
+static SpscRing rings[MAX_PHY_CORE];
+
+// Per listener buffers, allocated on the first multiListen and reused after
+static ListenBuffers listenBuffers[MAX_PHY_CORE];
+
+// Listeners, one pinned on each physical core (see topology.h)
+static int listenerCpus[MAX_PHY_CORE];
+static int listenerCount = 0;
+
+// Reads the listener CPUs on the first call, returns the number of listeners
+static int initListenerCpus() {
+  if (listenerCount == 0) {
+    listenerCount = coreSlots(listenerCpus, MAX_PHY_CORE);
+  }
+  return listenerCount;
+}
+
+// Detection thread of the pipelined mode, chosen by setPipelinedReceiver
+static int consumerCpu = -1;
+
+// Whether a listener runs on one of the SMT siblings of a physical core
+static int hostsListener(const PhysicalCore *core) {
+  for (int s = 0; s < core->siblingCount; s++) {
+    for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+      if (core->siblings[s] == listenerCpus[threadNumber]) return 1;
+    }
+  }
+  return 0;
+}
+
+// Picks the CPU of the detection thread on a physical core without any
+// listener, so it does not contend the ports they time. CONSUMER_CPU forces
+// one, which must be such a core. Otherwise, if every physical core hosts a
+// listener, the last listener gives its core up.
+// Returns the CPU, -1 if there is none (a single physical core, or a
+// CONSUMER_CPU next to a listener).
+static int initConsumerCpu() {
+  initListenerCpus();
+  const Topology *topology = getTopology();
+  for (int c = 0; c < topology->coreCount; c++) {
+    const PhysicalCore *core = &topology->cores[c];
+    if (hostsListener(core)) continue;
+    if (CONSUMER_CPU == -1) return core->siblings[0];
+    for (int s = 0; s < core->siblingCount; s++) {
+      if (core->siblings[s] == CONSUMER_CPU) return CONSUMER_CPU;
+    }
+  }
+  if ((CONSUMER_CPU != -1) || (listenerCount < 2)) {
+    return -1;
+  }
+  return listenerCpus[--listenerCount];
+}
+
+// Listener threads, pinned on each physical core, and the detection thread of
+// the pipelined mode. Created on the first multiListen and woken for each one.
+static WorkerPool listenerPool;
+static WorkerPool detectorPool;
+static int poolsStarted = 0;
+
+// Filter smoothing the timings before the detector, a median of 10 by default
+static struct {
+  FilterType type;
+  size_t size;
+  size_t hop;
+} receiverFilter = {FILTER_NETWORK, 10, 0};
+
+// Detector fed with the filtered points, threshold by default (see
+// setReceiverDetector). The DenStream state of each listener is allocated once.
+static DetectorType receiverDetector = DETECTOR_THRESHOLD;
+static FastDenStream *denStreams[MAX_PHY_CORE];
+static Results *denStreamResults[MAX_PHY_CORE];
+
+
+/*!
+   \struct StreamDetector
+   \brief Detector of a single listener, whichever its type
+*/
+typedef struct {
+  DetectorType type;
+  ThresholdResults tr;
+  FastDenStream *ds;
+  Results *results;
+  size_t index; // Point number, x axis of DenStream
+} StreamDetector;
 
 
 /* Computes the difference between two successive timestamps in an array and
@@ -48,32 +159,199 @@ unsigned int median(unsigned int *values, size_t valueNumber) {
 }
 
 
+/**
+* Allocates the buffers of a listener thread once, so that listen() does not
+* touch the allocator on the measurement path. The pages are written (and
+* locked when allowed) right away so they do not fault during a measurement.
+**/
+int initListenBuffers(ListenBuffers *lb, int threadNumber) {
+  // Sized for any link profile
+  size_t size = MAX_RECEIVER_REP * sizeof(uint64_t);
+  size = (size + 63) & ~((size_t) 63); // aligned_alloc wants a multiple of the alignment
+  lb->timings = (uint64_t *)aligned_alloc(64, size);
+  lb->differences = (uint64_t *)aligned_alloc(64, size);
+  if ((lb->timings == NULL) | (lb->differences == NULL)) {
+    return -1;
+  }
+  memset(lb->timings, 0, size);
+  memset(lb->differences, 0, size);
+  mlock(lb->timings, size); // Best effort, may be denied by RLIMIT_MEMLOCK
+  mlock(lb->differences, size);
+  lb->threadNumber = threadNumber;
+  lb->passCount = linkProfile.receiverRep;
+  lb->port = 1;
+  lb->sim = NULL;
+  return 1;
+}
+
+
 /**
 * Repeatedly calls p1_time.S, timing access of repeated calls to crc32,
-* measuring contention on port 1.
+* measuring contention on port 1 (or p5_time.S, timing vpermd, for port 5 when
+* lb->port is 5), or the simulated channel of lb->sim.
 *
-* We return the average of the RECEIVER REP measurements
+* We return the average of the lb->passCount (RECEIVER_REP by default) measurements
+* If a trace is being recorded, the raw pass is appended to it first. Otherwise
+* the simulated channel draws the average directly (simulateListen).
+* All the work is done in the preallocated buffers of the listener thread.
 *
 **/
-uint64_t listen() {
-  size_t nbTimings = RECEIVER_REP; // defined in config.h
-
-  // Arrays
-  uint64_t *timings = (uint64_t *)calloc(nbTimings, sizeof(uint64_t));
-  uint64_t *differences = (uint64_t *)calloc(nbTimings - 1, sizeof(uint64_t));
-  assert(timings != NULL);
-  assert(differences != NULL);
+uint64_t listen(ListenBuffers *lb) {
+  size_t nbTimings = lb->passCount;
 
   // Measuring
-  read_timings(timings);
-  computeDifferences(differences, timings, nbTimings);
-  free(timings);
-  uint64_t timingAverage = average(differences, nbTimings);
-  free(differences);
-  return timingAverage;
+  STAGE_TIMER(measureStart);
+  if ((lb->sim != NULL) && !lb->sim->everyPass && (receiverTrace.fp == NULL)) {
+    uint64_t mean = simulateListen(lb->sim, nbTimings);
+    STAGE_RECORD(STAGE_READ_TIMINGS, measureStart);
+    return mean;
+  }
+  if (lb->sim != NULL) {
+    simulateTimings(lb->sim, lb->timings, nbTimings);
+  }
+  else if (lb->port == 5) {
+    read_timings_p5_n(lb->timings, nbTimings);
+  }
+  else {
+    timingKernel(lb->timings, nbTimings);
+  }
+  STAGE_RECORD(STAGE_READ_TIMINGS, measureStart);
+  if (receiverTrace.fp != NULL) writeTracePass(&receiverTrace, lb->threadNumber, lb->timings, nbTimings);
+  STAGE_TIMER(averageStart);
+  computeDifferences(lb->differences, lb->timings, nbTimings);
+  uint64_t mean = average(lb->differences, nbTimings);
+  STAGE_RECORD(STAGE_DIFFERENCES, averageStart);
+  return mean;
+}
+
+
+int initStreamDetector(StreamDetector *sd, int threadNumber) {
+  sd->type = receiverDetector;
+  sd->index = 0;
+  if (sd->type == DETECTOR_DENSTREAM) {
+    sd->ds = denStreams[threadNumber];
+    sd->results = denStreamResults[threadNumber];
+    initFastDenStream(sd->ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+    initResults(sd->results);
+  }
+  else {
+    initThresholdDetection(&sd->tr, linkProfile.jmpThreshold);
+    setThresholdParameters(&sd->tr, linkProfile.minSpike, linkProfile.maxSpike, linkProfile.bitSize_0, linkProfile.bitSize_1);
+  }
+  return 1;
+}
+
+
+
+// Feeds a point to the detector.
+// Returns 1 once it holds a full request frame, 0 otherwise.
+int streamDetectorPush(StreamDetector *sd, unsigned int point) {
+  STAGE_TIMER(detectorStart);
+  if (sd->type == DETECTOR_DENSTREAM) {
+    parseNewPointFast(sd->ds, sd->index++ * DS_X_WEIGHT, point, sd->results);
+    if ((sd->ds->pClusters.len >= MAX_CLUSTER - 1) | (sd->ds->oClusters.len >= MAX_CLUSTER - 1)) {
+      // Out of clusters without a frame, start over
+      initFastDenStream(sd->ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+      initResults(sd->results);
+      sd->index = 0;
+    }
+    STAGE_RECORD(STAGE_DETECTOR, detectorStart);
+    return sd->results->bitNumber >= REQUEST_FRAME_SIZE;
+  }
+  parseNewPointThreshold(point, &sd->tr);
+  STAGE_RECORD(STAGE_DETECTOR, detectorStart);
+  return sd->tr.bitCount >= REQUEST_FRAME_SIZE;
+}
+
+
+
+int printStreamDetector(StreamDetector *sd) {
+  if (sd->type == DETECTOR_DENSTREAM) {
+    return printResults(sd->results);
+  }
+  return printThresholdDetector(&sd->tr);
 }
 
 
+
+// Appends a timing, and the point the filter output for it if any, to the
+// point trace of the listener
+void tracePoint(StreamDetector *sd, ListenBuffers *lb, unsigned int timing, unsigned int point, int flags) {
+  PointTraceWriter *pw = &pointTraces[lb->threadNumber];
+  if (pw->header == NULL) {
+    return;
+  }
+  PointRecord record = {0};
+  record.tsc = lb->sim != NULL ? (uint64_t) lb->sim->tsc : __rdtsc();
+  record.timing = timing;
+  record.point = point;
+  if (sd->type == DETECTOR_DENSTREAM) {
+    record.bitCount = sd->results->bitNumber;
+    flags |= sd->results->bitNumber > 0 ? POINT_INIT_SEQUENCE : 0;
+  }
+  else {
+    record.bitCount = sd->tr.bitCount;
+    flags |= sd->tr.initSequenceDetected ? POINT_INIT_SEQUENCE : 0;
+  }
+  record.flags = flags;
+  writePointRecord(pw, &record);
+}
+
+
+
+// Parses the bits held by the detector and sets the frame in the
+// ThreadRequestInfos object.
+// With SOFT_DECISION, the detector gives the log-likelihood of each bit
+// instead, and the fields are soft decoded when the hard decoding fails.
+int decodeStreamFrame(StreamDetector *sd, ThreadRequestInfos *infos) {
+  STAGE_TIMER(decodeStart);
+  if (SOFT_DECISION) {
+    double llrs[REQUEST_FRAME_SIZE];
+    if (sd->type == DETECTOR_DENSTREAM) {
+      getSoftBits(sd->results, llrs);
+    }
+    else {
+      getSoftBitsThreshold(&sd->tr, llrs);
+    }
+    if (DEBUG) {
+      for (int i = 0; i < REQUEST_FRAME_SIZE; i++) printf("%.1f ", llrs[i]);
+      printf("\n");
+    }
+    for (int i = 0; i < REQUEST_FRAME_SIZE; i++) infos->bits[i] = llrs[i] > 0.;
+    infos->rFrame = softDecodeRequestFrame(llrs, REQUEST_FRAME_SIZE);
+    infos->code = VALID_ANSWER;
+    STAGE_RECORD(STAGE_DECODE, decodeStart);
+    return 1;
+  }
+
+  // Parses timings to bits
+  int bits[REQUEST_FRAME_SIZE];
+  if (sd->type == DETECTOR_DENSTREAM) {
+    getBits(sd->results);
+    memcpy(bits, sd->results->bits, sizeof(bits));
+  }
+  else {
+    getBitsThreshold(&sd->tr, bits);
+  }
+
+
+  bool bits_b[REQUEST_FRAME_SIZE];
+  for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
+    if (DEBUG) printf("%i",bits[i]);
+    bits_b[i] = bits[i] == 1;
+    infos->bits[i] = bits_b[i];
+  }
+  if (DEBUG) printf("\n");
+
+  // Set the frame in the ThreadRequestInfos object!
+  infos->rFrame = decodeRequestFrame(bits_b, REQUEST_FRAME_SIZE);
+  infos->code = VALID_ANSWER;
+  STAGE_RECORD(STAGE_DECODE, decodeStart);
+  return 1;
+}
+
+
+
 // Main receiver function, it uses each measurement as a new data point to feed
 // the stream algorithm.
 // It is made to be used with pthread, hence the void pointer arguments.
@@ -85,43 +363,47 @@ void* listenStream(void *vargp) {
   // Important object, sharing information between threads.
   ThreadRequestInfos *infos = (ThreadRequestInfos *)vargp;
 
-  // Here we use Threshold based detection as our stream algorithm
-  ThresholdResults tr;
-  initThresholdDetection(&tr, JMP_THRESHOLD);
+  // Threshold based detection by default, or DenStream (see setReceiverDetector)
+  StreamDetector sd;
+  initStreamDetector(&sd, infos->threadNumber);
+  int complete = 0;
 
-  // To reduce noise, we smoothen the results with a median sliding window.
-  size_t medianSize = 10;
-  unsigned int timingTmp[medianSize];
+  // To reduce noise, we smoothen the results with a median window (by
+  // default, see setReceiverFilter).
+  Filter filter;
+  initFilter(&filter, receiverFilter.type, receiverFilter.size, receiverFilter.hop);
 
-  // We need a clock to measure the timeouts.
+  // We need a clock to measure the timeouts, the simulated one if the channel is
   clockid_t clk_id = CLOCK_MONOTONIC;
   struct timespec tp;
   clock_gettime(clk_id, &tp);
   long start_ns = tp.tv_nsec;
   long start_s = tp.tv_sec;
+  ChannelSim *sim = infos->buffers->sim;
+  double simStart = sim != NULL ? simNowNs(sim) : 0.;
 
-  // Data to store the results, not necessary but useful for debug
-  size_t index = 0;
-  unsigned int timing = 0;
-  unsigned int timings[1000000];
+  unsigned int point = 0;
 
 
-  while ((((long) (tp.tv_sec - start_s))*1000000000 + (tp.tv_nsec - start_ns) < REQUEST_TIMEOUT) // Timeout condition
-        & (tr.bitCount < REQUEST_FRAME_SIZE) // We received enough information to create a frame, we may stop listening
+  while (((sim != NULL ? simNowNs(sim) - simStart : ((long) (tp.tv_sec - start_s))*1000000000 + (tp.tv_nsec - start_ns)) < REQUEST_TIMEOUT) // Timeout condition
+        & (!complete) // We received enough information to create a frame, we may stop listening
         & (*infos->finished == 0)) // Another thread has received a frame, stop condition.
   {
 
-    // Median loop !
-    for (size_t i = 0; i <medianSize; i++) {
-      timing = (unsigned int) (listen() / 1000000000);
-      timingTmp[i] = timing;
-    }
-    int point = median(timingTmp, medianSize);
+    // Median loop ! The filter outputs a point once its window is full
+    unsigned int timing;
+    int ready;
+    do {
+      timing = (unsigned int) (listen(infos->buffers) / 1000000000);
+      STAGE_TIMER(filterStart);
+      ready = filterPush(&filter, timing, &point);
+      STAGE_RECORD(STAGE_FILTER, filterStart);
+      if (!ready) tracePoint(&sd, infos->buffers, timing, 0, 0);
+    } while (!ready);
 
     // Feed the median to the stream algorithm
-    parseNewPointThreshold(point, &tr);
-
-    if (DEBUG) timings[++index] = point;
+    complete = streamDetectorPush(&sd, point);
+    tracePoint(&sd, infos->buffers, timing, point, POINT_FILTERED | (complete ? POINT_FRAME_END : 0));
 
     //Update clock for tiemout
     clock_gettime(clk_id, &tp);
@@ -129,80 +411,287 @@ void* listenStream(void *vargp) {
 
 
   // This means that this is the first thread to receive a full frame
-  if (*infos-> finished ==0) {
-    *infos->finished = 1; // Stop the other frames
+  if (atomic_exchange(infos->finished, 1) == 0) { // Also stops the other threads
 
-    // Write results to a file to allow plots
-    if (DEBUG) {
-      printThresholdDetector(&tr);
-      char file_title[100];
-      sprintf(file_title, "./data_%i", rand()%100);
-      FILE *fp;
-      fp = fopen(file_title, "w+");
-      for (int w = 0; w < index; w++) {
-        fprintf(fp, "%i\t", timings[w]);
-      }
-      fclose(fp);
-    }
+    // The points themselves are in the point trace (-t), see plot.py
+    if (DEBUG) printStreamDetector(&sd);
 
-    // Parses timings to bits
-    int bits[REQUEST_FRAME_SIZE];
-    getBitsThreshold(&tr, bits);
+    decodeStreamFrame(&sd, infos);
+  }
+  flushStageProfile();
+  return NULL;
+}
 
 
-    bool bits_b[REQUEST_FRAME_SIZE];
-    for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
-      if (DEBUG) printf("%i",bits[i]);
-      bits_b[i] = bits[i];
-    }
-    if (DEBUG) printf("\n");
 
-    // Set the frame in the ThreadRequestInfos object!
-    infos->rFrame = decodeRequestFrame(bits_b, REQUEST_FRAME_SIZE);
 
-    return NULL;
-  }
-  else {
-    return NULL;
+// Measurement side of the pipelined receiver.
+// The pinned listener only measures and pushes every timing in its ring, until
+// the detection thread has a frame or the request timeouts.
+void* measureStream(void *vargp) {
+  ThreadRequestInfos *infos = (ThreadRequestInfos *)vargp;
+  SpscRing *ring = &rings[infos->threadNumber];
+
+  clockid_t clk_id = CLOCK_MONOTONIC;
+  struct timespec tp;
+  clock_gettime(clk_id, &tp);
+  long start_ns = tp.tv_nsec;
+  long start_s = tp.tv_sec;
+
+  while ((((long) (tp.tv_sec - start_s))*1000000000 + (tp.tv_nsec - start_ns) < REQUEST_TIMEOUT)
+        & (*infos->finished == 0))
+  {
+    ringPush(ring, (unsigned int) (listen(infos->buffers) / 1000000000));
+    clock_gettime(clk_id, &tp);
   }
+  flushStageProfile();
+  return NULL;
 }
 
 
 
+// Detection side of the pipelined receiver.
+// Drains the rings of all listeners in turn and runs the median window and the
+// detector of each of them, exactly like listenStream does inline.
+// vargp points to the array of listenerCount ThreadRequestInfos.
+void* detectStream(void *vargp) {
+  ThreadRequestInfos *infos = (ThreadRequestInfos *)vargp;
+
+  StreamDetector sd[MAX_PHY_CORE];
+  Filter filters[MAX_PHY_CORE];
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    initStreamDetector(&sd[threadNumber], threadNumber);
+    initFilter(&filters[threadNumber], receiverFilter.type, receiverFilter.size, receiverFilter.hop);
+  }
+
+  clockid_t clk_id = CLOCK_MONOTONIC;
+  struct timespec tp;
+  clock_gettime(clk_id, &tp);
+  long start_ns = tp.tv_nsec;
+  long start_s = tp.tv_sec;
+  int pending = 1;
+
+  // After the timeout, we still drain what the listeners pushed
+  while ((((long) (tp.tv_sec - start_s))*1000000000 + (tp.tv_nsec - start_ns) < REQUEST_TIMEOUT) | pending) {
+    pending = 0;
+    for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+      unsigned int timing, point;
+      while (ringPop(&rings[threadNumber], &timing)) {
+        pending = 1;
+        STAGE_TIMER(filterStart);
+        int ready = filterPush(&filters[threadNumber], timing, &point);
+        STAGE_RECORD(STAGE_FILTER, filterStart);
+        if (!ready) {
+          tracePoint(&sd[threadNumber], infos[threadNumber].buffers, timing, 0, 0);
+          continue;
+        }
+
+        int complete = streamDetectorPush(&sd[threadNumber], point);
+        tracePoint(&sd[threadNumber], infos[threadNumber].buffers, timing, point, POINT_FILTERED | (complete ? POINT_FRAME_END : 0));
+        if (complete) {
+          if (atomic_exchange(infos[threadNumber].finished, 1) == 0) { // Also stops the listeners
+            if (DEBUG) printStreamDetector(&sd[threadNumber]);
+            decodeStreamFrame(&sd[threadNumber], &infos[threadNumber]);
+          }
+          flushStageProfile();
+          return NULL;
+        }
+      }
+    }
+    if (!pending) _mm_pause();
+    clock_gettime(clk_id, &tp);
+  }
+  flushStageProfile();
+  return NULL;
+}
+
 // Handles multithreading of the listener.
 // Basically creates a thread on each physical core and makes it listening to
 // the cover channel.
 // Waits for all of them to finishe
 // Checks the validity of the (potential) received frame.
 requestFrame multiListen() {
-  cpu_set_t cpuset;
+  if (!poolsStarted) {
+    initListenerCpus();
+    int ret = initWorkerPool(&listenerPool, listenerCount, listenerCpus);
+    assert(ret == 1);
+    ret = initWorkerPool(&detectorPool, 1, &consumerCpu);
+    assert(ret == 1);
+    poolsStarted = 1;
+  }
 
-  pthread_t threads[PHY_CORE];
-  ThreadRequestInfos infos;
+  // One object per thread so each listener knows its number, they share the
+  // finished flag
+  ThreadRequestInfos infos[MAX_PHY_CORE];
+  void *args[MAX_PHY_CORE];
   atomic_int finished = 0;
-  for (int j = 0; j < PHY_CORE; j++) {
-    infos.threads[j] = threads[j];
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    if (listenBuffers[threadNumber].timings == NULL) {
+      int ret = initListenBuffers(&listenBuffers[threadNumber], threadNumber);
+      assert(ret == 1);
+    }
+    listenBuffers[threadNumber].passCount = linkProfile.receiverRep;
+    infos[threadNumber].buffers = &listenBuffers[threadNumber];
+    infos[threadNumber].threadNumber = threadNumber;
+    infos[threadNumber].finished = &finished;
+    infos[threadNumber].code = TIMEOUT;
+    args[threadNumber] = &infos[threadNumber];
   }
-  infos.finished = &finished;
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
-    pthread_create(&threads[threadNumber], NULL, listenStream, (void *)&infos);
-    CPU_ZERO(&cpuset);
-    CPU_SET(threadNumber, &cpuset);
-    pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
+  void *detectorArgs[1] = {infos};
+  if (pipelined) {
+    for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+      resetRing(&rings[threadNumber]);
+    }
+    startWorkerPool(&detectorPool, detectStream, detectorArgs);
   }
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
-    pthread_join(threads[threadNumber], NULL);
+  runWorkerPool(&listenerPool, pipelined ? measureStream : listenStream, args);
+  if (pipelined) {
+    waitWorkerPool(&detectorPool);
   }
+  // Only the thread that received a full frame has a decoded request
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    if ((infos[threadNumber].code == VALID_ANSWER) && checkRequestFrame(infos[threadNumber].rFrame)) {
+      return infos[threadNumber].rFrame;
+    }
+  }
+  requestFrame rFrame;
+  rFrame.initSeq = 0; // invalid frame
+  return rFrame;
+}
+
+
+
+// Start skew of the listeners across the cores, see workerPool.h
+int printListenerPoolStats() {
+  return printPoolStats(&listenerPool, "Listener");
+}
+
+
+
+// Starts recording every read_timings pass of the listeners in a trace file.
+int startReceiverTrace(const char *path) {
+  return openTraceWriter(&receiverTrace, path, linkProfile.receiverRep, initListenerCpus());
+}
+
 
 
-  if(checkRequestFrame(infos.rFrame)){
-    infos.code = VALID_ANSWER;
-    return infos.rFrame;
+int stopReceiverTrace() {
+  return closeTraceWriter(&receiverTrace);
+}
+
+
+
+// Starts tracing the points of each listener in <prefix>.<listener number>,
+// see pointTrace.h
+int startPointTrace(const char *prefix) {
+  char path[512];
+  initListenerCpus();
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    snprintf(path, sizeof(path), "%s.%i", prefix, threadNumber);
+    if (openPointTrace(&pointTraces[threadNumber], path, POINT_TRACE_SIZE, threadNumber) == -1) {
+      stopPointTrace();
+      return -1;
+    }
   }
-  else {
-    infos.code = INVALID_FRAME;
-    requestFrame rFrame;
-    rFrame.initSeq = 0; // invalid frame
-    return rFrame;
+  return 1;
+}
+
+
+
+int stopPointTrace() {
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    closePointTrace(&pointTraces[threadNumber]);
+  }
+  return 1;
+}
+
+
+
+// Switches the listeners to the pipelined mode, see measureStream/detectStream.
+// The detection thread gets a physical core of its own, see initConsumerCpu.
+int setPipelinedReceiver(int enabled) {
+  if (enabled) {
+    if ((consumerCpu == -1) && ((consumerCpu = initConsumerCpu()) == -1)) {
+      return -1;
+    }
+    for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+      if ((rings[threadNumber].buffer == NULL) && (initRing(&rings[threadNumber], RING_SIZE) == -1)) {
+        return -1;
+      }
+    }
+  }
+  pipelined = enabled;
+  return 1;
+}
+
+
+
+int getConsumerCpu() {
+  return consumerCpu;
+}
+
+
+
+// Total number of timings dropped because a ring was full, since startup.
+uint64_t getRingOverflowCount() {
+  uint64_t overflowCount = 0;
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    overflowCount += atomic_load(&rings[threadNumber].overflowCount);
+  }
+  return overflowCount;
+}
+
+
+
+int printRingStats() {
+  printf("------------------------------- Ring Statistics --------------------------------\n");
+  for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+    printf("Listener %i: \t Pushed: %" PRIu64 " \t Overflows: %" PRIu64 "\n", threadNumber,
+           rings[threadNumber].pushCount, (uint64_t) atomic_load(&rings[threadNumber].overflowCount));
+  }
+  return 0;
+}
+
+
+
+// Replaces the timing loop of port 1 of the listeners. The points scale with
+// the length of its passes, calibrate the link (-c) for another kernel.
+int setReceiverTimingKernel(TimingKernel kernel) {
+  timingKernel = kernel;
+  return 1;
+}
+
+
+
+// Selects the filter applied to the timings of each listener, see filter.h.
+int setReceiverFilter(FilterType type, size_t size, size_t hop) {
+  Filter filter;
+  if (initFilter(&filter, type, size, hop) == -1) {
+    return -1;
+  }
+  receiverFilter.type = type;
+  receiverFilter.size = size;
+  receiverFilter.hop = hop;
+  return 1;
+}
+
+
+
+// Selects the detector of the listeners. DenStream uses the structure of arrays
+// engine (see fastDenStream.h), allocated here once per listener.
+int setReceiverDetector(DetectorType type) {
+  if (type == DETECTOR_DENSTREAM) {
+    initListenerCpus();
+    for (int threadNumber = 0; threadNumber < listenerCount; threadNumber++) {
+      if (denStreams[threadNumber] == NULL) {
+        denStreams[threadNumber] = malloc(sizeof(FastDenStream));
+        denStreamResults[threadNumber] = malloc(sizeof(Results));
+        if ((denStreams[threadNumber] == NULL) | (denStreamResults[threadNumber] == NULL)) {
+          return -1;
+        }
+      }
+    }
   }
+  receiverDetector = type;
+  return 1;
 }
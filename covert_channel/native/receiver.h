@@ -7,12 +7,55 @@
 #include "denStreamDetection.h"
 #include "DenStream.h"
 #include "MicroCluster.h"
+#include "filter.h"
+#include "fastDenStream.h"
+#include "channelSim.h"
+#include "kernelRegistry.h"
 
-//
+#include <stddef.h>
 
 
-// int computeDifferences(uint64_t *differences, uint64_t *timings, size_t nbTimings);
-uint64_t listen();
-// void *listenStream(void *vargp);
+/*!
+   \struct ListenBuffers
+   \brief Buffers of a listener thread, allocated once and reused by every
+          listen() call so the measurement path never allocates
+*/
+typedef struct {
+  uint64_t *timings; // Raw timestamps from read_timings, up to MAX_RECEIVER_REP
+  uint64_t *differences; // Differences between them
+  size_t passCount; // Passes of read_timings per listen(), receiverRep of the link profile
+  int port; // Port timed by listen(), 1 (read_timings) or 5 (read_timings_p5)
+  ChannelSim *sim; // Simulated channel timed instead of a port when not NULL, see channelSim.h
+  int threadNumber;
+} ListenBuffers;
+
+
+
+// Detectors of the listeners
+typedef enum {
+  DETECTOR_THRESHOLD,
+  DETECTOR_DENSTREAM
+} DetectorType;
+
+
+
+int computeDifferences(uint64_t *differences, uint64_t *timings, size_t nbTimings);
+uint64_t average(uint64_t *differences, size_t nbTimings);
+unsigned int median(unsigned int *values, size_t valueNumber);
+int initListenBuffers(ListenBuffers *lb, int threadNumber);
+uint64_t listen(ListenBuffers *lb);
+void *listenStream(void *vargp);
 requestFrame multiListen();
+int startReceiverTrace(const char *path);
+int stopReceiverTrace();
+int startPointTrace(const char *prefix);
+int stopPointTrace();
+int setPipelinedReceiver(int enabled);
+int getConsumerCpu();
+int setReceiverFilter(FilterType type, size_t size, size_t hop);
+int setReceiverDetector(DetectorType type);
+int setReceiverTimingKernel(TimingKernel kernel);
+uint64_t getRingOverflowCount();
+int printRingStats();
+int printListenerPoolStats();
 #endif
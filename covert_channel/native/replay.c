@@ -0,0 +1,548 @@
+/*!
+   \file replay.c
+   \brief Offline replay of receiver traces (see trace.h) through the native
+          detectors. Each pass is reduced exactly like listen() and the filter
+          loop of listenStream do, then the resulting points are pushed through
+          the threshold and DenStream detectors as fast as possible.
+          For each detector, we report the throughput in points per second and
+          the number of request frames decoded, so detector changes can be
+          benchmarked without SMT contention. The filter turning timings into
+          points (see filter.h) is timed separately.
+          Instead of a trace, the passes can be simulated (see channelSim.h),
+          random request frames being sent as in benchSim. The equivalence
+          check of both DenStream engines then needs no recording.
+*/
+
+#include "trace.h"
+#include "receiver.h"
+#include "thresholdDetection.h"
+#include "denStreamDetection.h"
+#include "DenStream.h"
+#include "fastDenStream.h"
+#include "frame.h"
+#include "config.h"
+#include "filter.h"
+#include "linkProfile.h"
+#include "softDecision.h"
+#include "channelSim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+
+
+/*!
+   \struct ThreadPoints
+   \brief Timings (listen() output) and points (post filter) measured by a
+          single listener thread
+*/
+typedef struct {
+  unsigned int *timings;
+  size_t timingCount;
+  size_t timingCapacity;
+  unsigned int *points;
+  size_t pointCount;
+} ThreadPoints;
+
+
+typedef struct {
+  size_t points;
+  size_t frames; // Frames the detector considered complete
+  size_t validFrames; // Frames with a valid init sequence and hamming code
+  size_t softFrames; // Invalid ones recovered by soft decoding, see softDecision.h
+  double seconds;
+} ReplayStats;
+
+
+
+double elapsedSeconds(struct timespec *start, struct timespec *end) {
+  return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+
+int pushTiming(ThreadPoints *tp, unsigned int timing) {
+  if (tp->timingCount == tp->timingCapacity) {
+    tp->timingCapacity = tp->timingCapacity ? tp->timingCapacity * 2 : 4096;
+    tp->timings = realloc(tp->timings, tp->timingCapacity * sizeof(unsigned int));
+    if (tp->timings == NULL) return -1;
+  }
+  tp->timings[tp->timingCount++] = timing;
+  return 1;
+}
+
+
+
+// Reduces a pass to a timing like listen() does
+int pushPass(ThreadPoints *tp, uint64_t *timings, uint64_t *differences, size_t sampleCount) {
+  computeDifferences(differences, timings, sampleCount);
+  return pushTiming(tp, (unsigned int) (average(differences, sampleCount) / 1000000000));
+}
+
+
+
+/*!
+   \fn int loadTrace(TraceReader *tr, ThreadPoints threads[], size_t *passCount)
+   \brief Reads every pass of the trace and converts it into a timing,
+          reproducing listen()
+   \return 1 if ok, -1 if the trace is truncated
+*/
+int loadTrace(TraceReader *tr, ThreadPoints threads[], size_t *passCount) {
+  size_t maxSamples = tr->header.samplesPerPass;
+  uint64_t *timings = calloc(maxSamples, sizeof(uint64_t));
+  uint64_t *differences = calloc(maxSamples, sizeof(uint64_t));
+  TracePassHeader ph;
+  int ret;
+  *passCount = 0;
+
+  while ((ret = readTracePass(tr, &ph, timings, maxSamples)) == 1) {
+    if ((ph.threadNumber >= tr->header.threadCount) | (ph.sampleCount < 2)) continue;
+    pushPass(&threads[ph.threadNumber], timings, differences, ph.sampleCount);
+    (*passCount)++;
+  }
+
+  free(timings);
+  free(differences);
+  return ret == 0 ? 1 : -1;
+}
+
+
+
+/*!
+   \fn int simulateTrace(ChannelModel *model, size_t frameCount, uint64_t seed, ThreadPoints *thread, size_t *passCount)
+   \brief Fills the timings of a single listener thread from a simulated
+          channel, random request frames being scheduled a few bits apart
+          like benchSim does. Passes have the receiverRep samples of the link
+          profile.
+   \return 1 if ok, -1 if the profile has too many samples per pass
+*/
+int simulateTrace(ChannelModel *model, size_t frameCount, uint64_t seed, ThreadPoints *thread, size_t *passCount) {
+  size_t sampleCount = linkProfile.receiverRep;
+  if ((sampleCount < 2) | (sampleCount > MAX_RECEIVER_REP)) return -1;
+  uint64_t *timings = calloc(sampleCount, sizeof(uint64_t));
+  uint64_t *differences = calloc(sampleCount, sizeof(uint64_t));
+  ChannelSim sim;
+  initChannelSim(&sim, model, seed);
+  srand(seed);
+  *passCount = 0;
+
+  for (size_t f = 0; f < frameCount; f++) {
+    bool frame[REQUEST_FRAME_SIZE];
+    createRequestFrame(rand() % 16, rand() % 16, frame, REQUEST_FRAME_SIZE);
+    double frameStart = simNowNs(&sim) + linkProfile.bitDuration * (1. + rand() % 3);
+    simScheduleSequence(&sim, frameStart, linkProfile.bitDuration, frame, REQUEST_FRAME_SIZE);
+    double frameEnd = frameStart + (double) REQUEST_FRAME_SIZE * linkProfile.bitDuration;
+    while (simNowNs(&sim) < frameEnd) {
+      simulateTimings(&sim, timings, sampleCount);
+      pushPass(thread, timings, differences, sampleCount);
+      (*passCount)++;
+    }
+  }
+
+  free(timings);
+  free(differences);
+  return 1;
+}
+
+
+
+/*!
+   \fn int filterTimings(ThreadPoints threads[], int threadCount, FilterType type, size_t size, size_t hop, ReplayStats *stats)
+   \brief Runs the filter of listenStream on the timings of every thread
+*/
+int filterTimings(ThreadPoints threads[], int threadCount, FilterType type, size_t size, size_t hop, ReplayStats *stats) {
+  Filter filter;
+  struct timespec start, end;
+  memset(stats, 0, sizeof(ReplayStats));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int t = 0; t < threadCount; t++) {
+    initFilter(&filter, type, size, hop);
+    free(threads[t].points);
+    threads[t].points = malloc((threads[t].timingCount + 1) * sizeof(unsigned int));
+    threads[t].pointCount = 0;
+    for (size_t i = 0; i < threads[t].timingCount; i++) {
+      threads[t].pointCount += filterPush(&filter, threads[t].timings[i], &threads[t].points[threads[t].pointCount]);
+    }
+    stats->points += threads[t].timingCount;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  stats->seconds = elapsedSeconds(&start, &end);
+  return 1;
+}
+
+
+
+// Soft decoding of a frame toRequestFrame rejected
+int toSoftRequestFrame(double *llrs, requestFrame *rFrame) {
+  *rFrame = softDecodeRequestFrame(llrs, REQUEST_FRAME_SIZE);
+  return checkRequestFrame(*rFrame);
+}
+
+
+
+int toRequestFrame(int *bits, requestFrame *rFrame) {
+  bool bits_b[REQUEST_FRAME_SIZE];
+  for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
+    bits_b[i] = (bits[i] == 1);
+  }
+  *rFrame = decodeRequestFrame(bits_b, REQUEST_FRAME_SIZE);
+  return checkRequestFrame(*rFrame);
+}
+
+
+
+/*!
+   \fn int replayThreshold(ThreadPoints threads[], int threadCount, ReplayStats *stats, int verbose)
+   \brief Runs parseNewPointThreshold on every point. As in listenStream, a
+          frame is complete once bitCount reaches REQUEST_FRAME_SIZE, after
+          which the detector is reset.
+*/
+int replayThreshold(ThreadPoints threads[], int threadCount, ReplayStats *stats, int verbose) {
+  ThresholdResults tr;
+  int bits[REQUEST_FRAME_SIZE];
+  double llrs[REQUEST_FRAME_SIZE];
+  requestFrame rFrame;
+  struct timespec start, end;
+  memset(stats, 0, sizeof(ReplayStats));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int t = 0; t < threadCount; t++) {
+    initThresholdDetection(&tr, linkProfile.jmpThreshold);
+    setThresholdParameters(&tr, linkProfile.minSpike, linkProfile.maxSpike, linkProfile.bitSize_0, linkProfile.bitSize_1);
+    for (size_t i = 0; i < threads[t].pointCount; i++) {
+      parseNewPointThreshold(threads[t].points[i], &tr);
+      if (tr.bitCount >= REQUEST_FRAME_SIZE) {
+        memset(bits, 0, sizeof(bits));
+        getBitsThreshold(&tr, bits);
+        int valid = toRequestFrame(bits, &rFrame);
+        if (!valid) {
+          getSoftBitsThreshold(&tr, llrs);
+          stats->softFrames += toSoftRequestFrame(llrs, &rFrame);
+        }
+        stats->frames++;
+        stats->validFrames += valid;
+        if (verbose && valid) printf("threshold\tthread %i\tpoint %zu\tsequence number %u\n", t, i, rFrame.sequenceNumber);
+        initThresholdDetection(&tr, linkProfile.jmpThreshold);
+        setThresholdParameters(&tr, linkProfile.minSpike, linkProfile.maxSpike, linkProfile.bitSize_0, linkProfile.bitSize_1);
+      }
+    }
+    stats->points += threads[t].pointCount;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  stats->seconds = elapsedSeconds(&start, &end);
+  return 1;
+}
+
+
+
+/*!
+   \fn int replayDenStream(ThreadPoints threads[], int threadCount, ReplayStats *stats, int verbose)
+   \brief Runs parseNewPoint (hence partialFit) on every point, with the point
+          index as x axis like the web offline detector.
+*/
+int replayDenStream(ThreadPoints threads[], int threadCount, ReplayStats *stats, int verbose) {
+  // Both objects hold MAX_CLUSTER clusters, too big for the stack
+  DenStream *ds = malloc(sizeof(DenStream));
+  Results *results = malloc(sizeof(Results));
+  requestFrame rFrame;
+  double llrs[REQUEST_FRAME_SIZE];
+  struct timespec start, end;
+  memset(stats, 0, sizeof(ReplayStats));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int t = 0; t < threadCount; t++) {
+    initDenStream(ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+    initResults(results);
+    size_t index = 0;
+    for (size_t i = 0; i < threads[t].pointCount; i++) {
+      Sample s = {index++ * DS_X_WEIGHT, threads[t].points[i]};
+      parseNewPoint(s, ds, results);
+      if ((results->bitNumber >= REQUEST_FRAME_SIZE) | (ds->pLen >= MAX_CLUSTER - 1) | (ds->oLen >= MAX_CLUSTER - 1)) {
+        if (results->bitNumber >= REQUEST_FRAME_SIZE) {
+          getBits(results);
+          int valid = toRequestFrame(results->bits, &rFrame);
+          if (!valid) {
+            getSoftBits(results, llrs);
+            stats->softFrames += toSoftRequestFrame(llrs, &rFrame);
+          }
+          stats->frames++;
+          stats->validFrames += valid;
+          if (verbose && valid) printf("denstream\tthread %i\tpoint %zu\tsequence number %u\n", t, i, rFrame.sequenceNumber);
+        }
+        initDenStream(ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+        initResults(results);
+        index = 0;
+      }
+    }
+    stats->points += threads[t].pointCount;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  stats->seconds = elapsedSeconds(&start, &end);
+
+  free(ds);
+  free(results);
+  return 1;
+}
+
+
+
+/*!
+   \fn int replayFastDenStream(ThreadPoints threads[], int threadCount, ReplayStats *stats, int verbose)
+   \brief Same as replayDenStream with the structure of arrays engine
+*/
+int replayFastDenStream(ThreadPoints threads[], int threadCount, ReplayStats *stats, int verbose) {
+  FastDenStream *ds = malloc(sizeof(FastDenStream));
+  Results *results = malloc(sizeof(Results));
+  requestFrame rFrame;
+  double llrs[REQUEST_FRAME_SIZE];
+  struct timespec start, end;
+  memset(stats, 0, sizeof(ReplayStats));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int t = 0; t < threadCount; t++) {
+    initFastDenStream(ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+    initResults(results);
+    size_t index = 0;
+    for (size_t i = 0; i < threads[t].pointCount; i++) {
+      parseNewPointFast(ds, index++ * DS_X_WEIGHT, threads[t].points[i], results);
+      if ((results->bitNumber >= REQUEST_FRAME_SIZE) | (ds->pClusters.len >= MAX_CLUSTER - 1) | (ds->oClusters.len >= MAX_CLUSTER - 1)) {
+        if (results->bitNumber >= REQUEST_FRAME_SIZE) {
+          getBits(results);
+          int valid = toRequestFrame(results->bits, &rFrame);
+          if (!valid) {
+            getSoftBits(results, llrs);
+            stats->softFrames += toSoftRequestFrame(llrs, &rFrame);
+          }
+          stats->frames++;
+          stats->validFrames += valid;
+          if (verbose && valid) printf("fast\tthread %i\tpoint %zu\tsequence number %u\n", t, i, rFrame.sequenceNumber);
+        }
+        initFastDenStream(ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+        initResults(results);
+        index = 0;
+      }
+    }
+    stats->points += threads[t].pointCount;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  stats->seconds = elapsedSeconds(&start, &end);
+
+  free(ds);
+  free(results);
+  return 1;
+}
+
+
+
+/*!
+   \fn int checkEquivalence(ThreadPoints threads[], int threadCount)
+   \brief Runs both DenStream engines side by side on every point and compares
+          their clusters and decoded bits. Both are reset together, whenever
+          one of them completes a frame or runs out of clusters.
+          Agreeing on garbage proves little, so the frames must also decode:
+          at least one of them has to be a valid request frame.
+   \return 1 if they always agree and decode a valid frame, -1 otherwise
+*/
+int checkEquivalence(ThreadPoints threads[], int threadCount) {
+  DenStream *ds = malloc(sizeof(DenStream));
+  Results *results = malloc(sizeof(Results));
+  FastDenStream *fds = malloc(sizeof(FastDenStream));
+  Results *fastResults = malloc(sizeof(Results));
+  size_t points = 0, divergingPoints = 0, frames = 0, validFrames = 0, divergingFrames = 0;
+  requestFrame rFrame;
+  long double largestError = 0.;
+
+  for (int t = 0; t < threadCount; t++) {
+    initDenStream(ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+    initResults(results);
+    initFastDenStream(fds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+    initResults(fastResults);
+    size_t index = 0;
+    for (size_t i = 0; i < threads[t].pointCount; i++, points++) {
+      Sample s = {index * DS_X_WEIGHT, threads[t].points[i]};
+      parseNewPoint(s, ds, results);
+      parseNewPointFast(fds, index * DS_X_WEIGHT, threads[t].points[i], fastResults);
+      index++;
+
+      int diverging = (ds->pLen != fds->pClusters.len) | (ds->oLen != fds->oClusters.len) |
+                      (results->bitNumber != fastResults->bitNumber);
+      for (int c = 0; (c < ds->pLen) & (c < fds->pClusters.len); c++) {
+        long double error = fabsl(ds->pMicroClusters[c].center_y - fds->pClusters.centerY[c]) +
+                            fabsl(ds->pMicroClusters[c].center_x - fds->pClusters.centerX[c]);
+        largestError = error > largestError ? error : largestError;
+        diverging |= error > 1e-6 * (1 + fabsl(ds->pMicroClusters[c].center_y));
+      }
+      if (diverging && (divergingPoints++ == 0)) {
+        printf("First divergence: thread %i, point %zu (p %i/%i, o %i/%i, bits %i/%i)\n", t, i, ds->pLen, fds->pClusters.len,
+               ds->oLen, fds->oClusters.len, results->bitNumber, fastResults->bitNumber);
+      }
+
+      int complete = (results->bitNumber >= REQUEST_FRAME_SIZE) | (fastResults->bitNumber >= REQUEST_FRAME_SIZE);
+      int overflow = (ds->pLen >= MAX_CLUSTER - 1) | (ds->oLen >= MAX_CLUSTER - 1) |
+                     (fds->pClusters.len >= MAX_CLUSTER - 1) | (fds->oClusters.len >= MAX_CLUSTER - 1);
+      if (complete | overflow) {
+        if (complete) {
+          getBits(results);
+          getBits(fastResults);
+          frames++;
+          divergingFrames += memcmp(results->bits, fastResults->bits, sizeof(results->bits)) != 0;
+          validFrames += toRequestFrame(fastResults->bits, &rFrame);
+        }
+        initDenStream(ds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+        initResults(results);
+        initFastDenStream(fds, DS_LAMBDA, DS_EPS, DS_BETA, DS_MU);
+        initResults(fastResults);
+        index = 0;
+      }
+    }
+  }
+  printf("Equivalence (%s kernel): %zu points, %zu diverging, largest center error %Lg, %zu frames, %zu valid, %zu diverging\n",
+         getNearestClusterKernel(), points, divergingPoints, largestError, frames, validFrames, divergingFrames);
+  if (validFrames == 0) {
+    printf("No valid frame decoded, the frame decoding path was not compared\n");
+  }
+
+  free(ds);
+  free(results);
+  free(fds);
+  free(fastResults);
+  return ((divergingPoints == 0) & (divergingFrames == 0) & (validFrames > 0)) ? 1 : -1;
+}
+
+
+
+int printReplayStats(const char *name, ReplayStats *stats) {
+  printf("%-10s\t%zu points\t%.3f s\t%.0f points/s\t%zu frames\t%zu valid\t%zu soft\n", name, stats->points, stats->seconds,
+         stats->seconds > 0 ? stats->points / stats->seconds : 0., stats->frames, stats->validFrames, stats->softFrames);
+  return 1;
+}
+
+
+
+int usage(char *name) {
+  printf("Usage: %s [-d threshold|denstream|fast|all] [-e] [-f filter] [-w window] [-H hop] [-P profile] [-v] trace\n", name);
+  printf("       %s [options] -s model [-n frames] [-S seed]\n", name);
+  printf("\t-d\tDetector to replay the trace through, fast is the structure of arrays DenStream (default all)\n");
+  printf("\t-e\tCheck both DenStream engines agree on every point and decode a valid frame, exits with 2 if not\n");
+  printf("\t-f\tFilter: qsort, network, sliding, hampel or trimmed (default network)\n");
+  printf("\t-w\tNumber of timings in a filter window, as in listenStream (default 10)\n");
+  printf("\t-H\tTimings between two points of the sliding filter (default window)\n");
+  printf("\t-P\tLink profile with the threshold detector parameters (default: compile time values)\n");
+  printf("\t-v\tPrint every valid frame\n");
+  printf("\t-s\tReplay a simulated channel instead of a trace: clean, noisy, drift, bursts, load or hostile\n");
+  printf("\t-n\tRequest frames sent on the simulated channel (default 200)\n");
+  printf("\t-S\tSeed of the simulation (default 1)\n");
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  char *detector = "all";
+  int filterType = FILTER_NETWORK;
+  size_t filterSize = 10;
+  size_t filterHop = 0;
+  int verbose = 0;
+  int equivalence = 0;
+  const char *modelName = NULL;
+  size_t frameCount = 200;
+  uint64_t seed = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:ef:w:H:P:vs:n:S:h")) != -1) {
+    switch (opt) {
+      case 'd': detector = optarg; break;
+      case 'e': equivalence = 1; break;
+      case 'f': filterType = filterTypeFromName(optarg); break;
+      case 'w': filterSize = strtoul(optarg, NULL, 10); break;
+      case 'H': filterHop = strtoul(optarg, NULL, 10); break;
+      case 'P':
+        if (loadLinkProfile(&linkProfile, optarg) != 1) {
+          fprintf(stderr, "Cannot load link profile %s\n", optarg);
+          return 1;
+        }
+        break;
+      case 'v': verbose = 1; break;
+      case 's': modelName = optarg; break;
+      case 'n': frameCount = strtoul(optarg, NULL, 10); break;
+      case 'S': seed = strtoull(optarg, NULL, 10); break;
+      default: return usage(argv[0]);
+    }
+  }
+  Filter check;
+  if (((optind >= argc) && (modelName == NULL)) || (filterType == -1) || (initFilter(&check, filterType, filterSize, filterHop) == -1)) {
+    return usage(argv[0]);
+  }
+
+  int threadCount;
+  ThreadPoints *threads;
+  size_t passCount;
+  struct timespec start, end;
+  if (modelName != NULL) {
+    ChannelModel model;
+    if (initChannelModel(&model, modelName) == -1) {
+      fprintf(stderr, "Unknown model %s\n", modelName);
+      return usage(argv[0]);
+    }
+    threadCount = 1;
+    threads = calloc(threadCount, sizeof(ThreadPoints));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (simulateTrace(&model, frameCount, seed, &threads[0], &passCount) == -1) {
+      fprintf(stderr, "The link profile has %u samples per pass, at most %i\n", linkProfile.receiverRep, MAX_RECEIVER_REP);
+      return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Simulated %s channel: %zu frames, %zu passes of %u samples, in %.3f s\n", modelName, frameCount, passCount,
+           linkProfile.receiverRep, elapsedSeconds(&start, &end));
+  }
+  else {
+    TraceReader tr;
+    if (openTraceReader(&tr, argv[optind]) == -1) {
+      fprintf(stderr, "%s is not a readable trace\n", argv[optind]);
+      return 1;
+    }
+    threadCount = tr.header.threadCount;
+    threads = calloc(threadCount, sizeof(ThreadPoints));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (loadTrace(&tr, threads, &passCount) == -1) {
+      fprintf(stderr, "Warning: truncated trace, replaying what could be read\n");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    closeTraceReader(&tr);
+    printf("Trace: %zu passes of %u samples, %i threads, loaded in %.3f s\n", passCount, tr.header.samplesPerPass, threadCount, elapsedSeconds(&start, &end));
+  }
+
+  ReplayStats stats;
+  filterTimings(threads, threadCount, filterType, filterSize, filterHop, &stats);
+  printf("%-10s\t%zu timings\t%.3f s\t%.0f timings/s\n", filterName(filterType), stats.points, stats.seconds,
+         stats.seconds > 0 ? stats.points / stats.seconds : 0.);
+  if ((strcmp(detector, "threshold") == 0) | (strcmp(detector, "all") == 0)) {
+    replayThreshold(threads, threadCount, &stats, verbose);
+    printReplayStats("threshold", &stats);
+  }
+  if ((strcmp(detector, "denstream") == 0) | (strcmp(detector, "all") == 0)) {
+    replayDenStream(threads, threadCount, &stats, verbose);
+    printReplayStats("denstream", &stats);
+  }
+  if ((strcmp(detector, "fast") == 0) | (strcmp(detector, "all") == 0)) {
+    replayFastDenStream(threads, threadCount, &stats, verbose);
+    printReplayStats("fast", &stats);
+  }
+  int ret = 0;
+  if (equivalence && (checkEquivalence(threads, threadCount) == -1)) {
+    ret = 2;
+  }
+
+  for (int t = 0; t < threadCount; t++) {
+    free(threads[t].timings);
+    free(threads[t].points);
+  }
+  free(threads);
+  return ret;
+}
@@ -0,0 +1,70 @@
+/*!
+   \file ring.c
+   \brief Lock-free single-producer/single-consumer ring of timings
+*/
+
+#include "ring.h"
+
+#include <stdlib.h>
+#include <stdatomic.h>
+
+
+int initRing(SpscRing *ring, size_t size) {
+  size_t slots = 1;
+  while (slots < size) slots <<= 1;
+
+  ring->buffer = calloc(slots, sizeof(unsigned int));
+  if (ring->buffer == NULL) {
+    return -1;
+  }
+  ring->mask = slots - 1;
+  ring->pushCount = 0;
+  atomic_init(&ring->overflowCount, 0);
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  return 1;
+}
+
+
+
+int resetRing(SpscRing *ring) {
+  atomic_store(&ring->head, 0);
+  atomic_store(&ring->tail, 0);
+  return 1;
+}
+
+
+
+int ringPush(SpscRing *ring, unsigned int value) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail > ring->mask) { // Full, the measurement thread must not wait
+    atomic_fetch_add_explicit(&ring->overflowCount, 1, memory_order_relaxed);
+    return 0;
+  }
+  ring->buffer[head & ring->mask] = value;
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  ring->pushCount++;
+  return 1;
+}
+
+
+
+int ringPop(SpscRing *ring, unsigned int *value) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (tail == head) {
+    return 0;
+  }
+  *value = ring->buffer[tail & ring->mask];
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+
+
+int freeRing(SpscRing *ring) {
+  free(ring->buffer);
+  ring->buffer = NULL;
+  return 1;
+}
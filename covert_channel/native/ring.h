@@ -0,0 +1,74 @@
+/*!
+   \file ring.h
+   \brief Lock-free single-producer/single-consumer ring of timings.
+          The producer is a pinned listener thread that only measures, the
+          consumer is the detection thread. The producer never waits: when the
+          ring is full, the sample is dropped and counted as an overflow.
+*/
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_LINE 64
+
+
+/*!
+   \struct SpscRing
+   \brief Ring buffer, head and tail live on their own cache lines so the
+          producer and consumer do not share a line for every sample.
+*/
+typedef struct {
+  _Alignas(CACHE_LINE) atomic_size_t head; // Next slot written by the producer
+  uint64_t pushCount; // Samples pushed, producer side only
+  _Alignas(CACHE_LINE) atomic_size_t tail; // Next slot read by the consumer
+  _Alignas(CACHE_LINE) atomic_uint_fast64_t overflowCount; // Dropped samples
+  unsigned int *buffer;
+  size_t mask; // size - 1, size is a power of two
+} SpscRing;
+
+
+
+/*!
+   \fn int initRing(SpscRing *ring, size_t size)
+   \brief Allocates the ring
+   \param size Number of slots, rounded up to a power of two
+   \return 1 if ok, -1 if the allocation failed
+*/
+int initRing(SpscRing *ring, size_t size);
+
+
+
+/*!
+   \fn int resetRing(SpscRing *ring)
+   \brief Empties the ring. Only call it when neither side is running.
+          Counters are kept.
+*/
+int resetRing(SpscRing *ring);
+
+
+
+/*!
+   \fn int ringPush(SpscRing *ring, unsigned int value)
+   \brief Producer side. Never blocks.
+   \return 1 if pushed, 0 if the ring was full and the value dropped
+*/
+int ringPush(SpscRing *ring, unsigned int value);
+
+
+
+/*!
+   \fn int ringPop(SpscRing *ring, unsigned int *value)
+   \brief Consumer side. Never blocks.
+   \return 1 if a value was popped, 0 if the ring was empty
+*/
+int ringPop(SpscRing *ring, unsigned int *value);
+
+
+
+int freeRing(SpscRing *ring);
+
+#endif
@@ -1,43 +1,146 @@
+#define _GNU_SOURCE
+
 #include "sendBit.h"
 #include "config.h"
 
 #include "p1_time.h"
 #include "p1_spam.h"
+#include "p5_spam.h"
+#include "tsc.h"
 
 #include <stdio.h>
 #include <stdbool.h>
 #include <math.h>
 #include <time.h>
 #include <unistd.h>
+#include <pthread.h>
 
-// Physical layer function to send a 1-bit
-// Creates contention on port 1 by calling p1_spam.S repeatedly for a given
-// time period
-int sendOne(long bitDuration, clockid_t clk_id) {
-  // We need a  (nano) clock to delimitate the timer period
-  struct timespec tp;
-  clock_gettime(clk_id, &tp);
-  long start_ns = tp.tv_nsec;
-  long start_s = tp.tv_sec;
 
-  // Spam for a whole millisecond
-  while (((long) (tp.tv_sec - start_s))*1000000000 + (tp.tv_nsec - start_ns) < bitDuration) {
-    spam_port1();
-    clock_gettime(clk_id, &tp);
+// Spam loops by contended ports: bit 0 for port 1, bit 1 for port 5
+// The port 5 ones use vpermd, see spamPortsSupported
+static SpamKernel spamKernels[SPAM_PORTS_BOTH + 1] = {NULL, spam_port1_n, spam_port5_n, spam_ports15_n};
+
+// TSC ticks of one repetition of each spam loop, measured on its first use
+static pthread_once_t spamOnce[SPAM_PORTS_BOTH + 1] = {PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT};
+static uint64_t ticksPerRep[SPAM_PORTS_BOTH + 1] = {1, 1, 1, 1};
+
+static void calibrateSpam(int ports) {
+  initTsc();
+  spamKernels[ports](1024); // Warm up
+  uint64_t start = readTsc();
+  spamKernels[ports](1024);
+  ticksPerRep[ports] = (readTsc() - start) / 1024;
+  if (ticksPerRep[ports] == 0) ticksPerRep[ports] = 1;
+}
+
+// pthread_once takes no argument
+static void calibratePort1() { calibrateSpam(SPAM_PORT1); }
+static void calibratePort5() { calibrateSpam(SPAM_PORT5); }
+static void calibratePortsBoth() { calibrateSpam(SPAM_PORTS_BOTH); }
+static void (*calibrateKernels[SPAM_PORTS_BOTH + 1])() = {NULL, calibratePort1, calibratePort5, calibratePortsBoth};
+
+static void initSpam(int ports) {
+  pthread_once(&spamOnce[ports], calibrateKernels[ports]);
+}
+
+
+
+int spamPortsSupported(int ports) {
+  if (ports & SPAM_PORT5) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
   }
   return 1;
 }
 
 
+
+// Replaces the port 1 spam loop, by a generated kernel for instance (see
+// kernelRegistry.h). Its repetitions are timed with the first frame, so it
+// must be set before.
+int setSpamKernel(SpamKernel kernel) {
+  spamKernels[SPAM_PORT1] = kernel;
+  return 1;
+}
+
+SpamKernel getSpamKernel() {
+  return spamKernels[SPAM_PORT1];
+}
+
+
+
+// Physical layer function to send a 1-bit
+// Creates contention on the ports (port 1 with p1_spam.S by default) until the
+// deadline. Bursts hold at most senderRep repetitions, and no more than
+// SENDER_EDGE_TOLERANCE, and the last one is cut to the time left, so the edge
+// lands within a repetition of the deadline.
+static void sendOne(uint64_t deadline, unsigned senderRep, int ports) {
+  uint64_t burstRep = nsToTsc(SENDER_EDGE_TOLERANCE) / ticksPerRep[ports];
+  if (burstRep > senderRep) burstRep = senderRep;
+  if (burstRep == 0) burstRep = 1;
+
+  uint64_t now = readTsc();
+  while (now + ticksPerRep[ports] <= deadline) {
+    uint64_t rep = (deadline - now) / ticksPerRep[ports];
+    spamKernels[ports](rep < burstRep ? rep : burstRep);
+    now = readTsc();
+  }
+  while (now < deadline) now = readTsc();
+}
+
+
 // Physical layer function to send a 0-bit
-// Very complex behaviour: does nothing for a given timer period.
-int sendZero(long bitDuration, clockid_t clk_id) {
-  struct timespec tp;
-  clock_gettime(clk_id, &tp);
-  long start_ns = tp.tv_nsec;
-  long start_s = tp.tv_sec;
-  while (((long) (tp.tv_sec - start_s))*1000000000 + (tp.tv_nsec - start_ns) < bitDuration) {
-    clock_gettime(clk_id, &tp);
+// Very complex behaviour: does nothing until the deadline.
+static void sendZero(uint64_t deadline) {
+  while (readTsc() < deadline) {
+    _mm_pause();
+  }
+}
+
+
+
+int initEdgeStats(EdgeStats *stats) {
+  for (int bit = 0; bit < 2; bit++) {
+    stats->count[bit] = 0;
+    stats->errorSum[bit] = 0.;
+    stats->errorSquareSum[bit] = 0.;
+    stats->errorMax[bit] = 0;
+  }
+  return 1;
+}
+
+
+
+int mergeEdgeStats(EdgeStats *total, EdgeStats *stats) {
+  for (int bit = 0; bit < 2; bit++) {
+    total->count[bit] += stats->count[bit];
+    total->errorSum[bit] += stats->errorSum[bit];
+    total->errorSquareSum[bit] += stats->errorSquareSum[bit];
+    if (stats->errorMax[bit] > total->errorMax[bit]) total->errorMax[bit] = stats->errorMax[bit];
+  }
+  return 1;
+}
+
+
+
+// Records the lateness of an edge on its deadline
+static void recordEdge(EdgeStats *stats, uint64_t deadline, int bit) {
+  uint64_t error = readTsc() - deadline;
+  stats->count[bit]++;
+  stats->errorSum[bit] += error;
+  stats->errorSquareSum[bit] += (double) error * error;
+  if (error > stats->errorMax[bit]) stats->errorMax[bit] = error;
+}
+
+
+
+int printEdgeStats(EdgeStats *stats) {
+  for (int bit = 0; bit < 2; bit++) {
+    if (stats->count[bit] == 0) continue;
+    double mean = stats->errorSum[bit] / stats->count[bit];
+    double variance = stats->errorSquareSum[bit] / stats->count[bit] - mean * mean;
+    printf("%i bits: %lu edges \t Error: mean %.0f ns, std %.0f ns, max %.0f ns\n", bit, stats->count[bit],
+           tscToNs(mean), tscToNs(sqrt(variance > 0. ? variance : 0.)), tscToNs(stats->errorMax[bit]));
   }
   return 1;
 }
@@ -45,17 +148,82 @@ int sendZero(long bitDuration, clockid_t clk_id) {
 
 
 // Sends a bit sequence by using port contention
-int sendSequence(long bitDuration, bool* sequence, int sequenceSize) {
-  clockid_t clk_id = CLOCK_MONOTONIC;
-  struct timespec tp;
-  clock_gettime(clk_id, &tp);
+// Bit i ends at the absolute deadline startTsc + (i+1)*bitDuration, so errors
+// on an edge do not accumulate over the frame.
+int sendSequenceAt(uint64_t startTsc, long bitDuration, unsigned senderRep, bool* sequence, int sequenceSize, EdgeStats *stats) {
+  initSpam(SPAM_PORT1);
+  uint64_t bitTicks = nsToTsc(bitDuration);
+
+  sendZero(startTsc);
   for (int bitIndex = 0; bitIndex < sequenceSize; bitIndex++) {
+    uint64_t deadline = startTsc + (bitIndex + 1) * bitTicks;
     if (sequence[bitIndex] == 1) {
-      sendOne(bitDuration, clk_id);
+      sendOne(deadline, senderRep, SPAM_PORT1);
     }
     else {
-      sendZero(bitDuration,clk_id);
+      sendZero(deadline);
     }
+    if (stats != NULL) recordEdge(stats, deadline, sequence[bitIndex] == 1);
   }
   return 1;
 }
+
+
+
+// Sends two bit sequences at once, port1 with contention on port 1 and port5
+// on port 5: each bit period runs the spam loop of the ports of its 1 bits.
+// Errors are recorded as 1 bits when at least one of the ports is contended.
+int sendDualSequenceAt(uint64_t startTsc, long bitDuration, unsigned senderRep, bool *port1, bool *port5, int sequenceSize, EdgeStats *stats) {
+  if (!spamPortsSupported(SPAM_PORTS_BOTH)) {
+    return -1;
+  }
+  for (int ports = SPAM_PORT1; ports <= SPAM_PORTS_BOTH; ports++) initSpam(ports);
+  uint64_t bitTicks = nsToTsc(bitDuration);
+
+  sendZero(startTsc);
+  for (int bitIndex = 0; bitIndex < sequenceSize; bitIndex++) {
+    uint64_t deadline = startTsc + (bitIndex + 1) * bitTicks;
+    int ports = (port1[bitIndex] ? SPAM_PORT1 : 0) | (port5[bitIndex] ? SPAM_PORT5 : 0);
+    if (ports != 0) {
+      sendOne(deadline, senderRep, ports);
+    }
+    else {
+      sendZero(deadline);
+    }
+    if (stats != NULL) recordEdge(stats, deadline, ports != 0);
+  }
+  return 1;
+}
+
+
+
+// Sends multi-level symbols (see multiLevel.h) by modulating the contention:
+// level k spams port 1 during k/(levelCount-1) of every SYMBOL_DUTY_PERIOD.
+// Symbol edges are TSC deadlines like the bit edges of sendSequenceAt, errors
+// are recorded as 0 bits for idle symbols and 1 bits for the others.
+int sendSymbolsAt(uint64_t startTsc, long symbolDuration, unsigned senderRep, int levelCount, int *symbols, int symbolCount, EdgeStats *stats) {
+  initSpam(SPAM_PORT1);
+  uint64_t symbolTicks = nsToTsc(symbolDuration);
+  uint64_t periodTicks = nsToTsc(SYMBOL_DUTY_PERIOD);
+
+  sendZero(startTsc);
+  for (int symbolIndex = 0; symbolIndex < symbolCount; symbolIndex++) {
+    uint64_t symbolStart = startTsc + symbolIndex * symbolTicks;
+    uint64_t deadline = symbolStart + symbolTicks;
+    uint64_t activeTicks = periodTicks * symbols[symbolIndex] / (levelCount - 1);
+    for (uint64_t period = symbolStart; period < deadline; period += periodTicks) {
+      uint64_t periodEnd = period + periodTicks < deadline ? period + periodTicks : deadline;
+      uint64_t activeEnd = period + activeTicks < periodEnd ? period + activeTicks : periodEnd;
+      if (activeEnd > period) sendOne(activeEnd, senderRep, SPAM_PORT1);
+      sendZero(periodEnd);
+    }
+    if (stats != NULL) recordEdge(stats, deadline, symbols[symbolIndex] > 0);
+  }
+  return 1;
+}
+
+
+
+int sendSequence(long bitDuration, unsigned senderRep, bool* sequence, int sequenceSize) {
+  return sendSequenceAt(readTsc(), bitDuration, senderRep, sequence, sequenceSize, NULL);
+}
@@ -2,7 +2,46 @@
 #define SENDBIT_H
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
-int sendSequence(long bitDuration, bool* sequence, int sequenceSize);
+#include "kernelRegistry.h"
+
+
+// Ports contended by a 1 bit, see sendDualSequenceAt
+#define SPAM_PORT1 1
+#define SPAM_PORT5 2
+#define SPAM_PORTS_BOTH (SPAM_PORT1 | SPAM_PORT5)
+
+
+/*!
+   \struct EdgeStats
+   \brief Lateness of the bit edges on their TSC deadline, in ticks, for the
+          0 bits and the 1 bits
+*/
+typedef struct {
+  unsigned long count[2];
+  double errorSum[2];
+  double errorSquareSum[2];
+  uint64_t errorMax[2];
+} EdgeStats;
+
+
+int initEdgeStats(EdgeStats *stats);
+int mergeEdgeStats(EdgeStats *total, EdgeStats *stats);
+int printEdgeStats(EdgeStats *stats);
+
+// Sends the sequence with its first bit starting at startTsc, stats may be NULL
+int sendSequenceAt(uint64_t startTsc, long bitDuration, unsigned senderRep, bool* sequence, int sequenceSize, EdgeStats *stats);
+// Same for two sequences sent in parallel on ports 1 and 5, see dualPort.h
+// Returns -1 without AVX2, see spamPortsSupported
+int sendDualSequenceAt(uint64_t startTsc, long bitDuration, unsigned senderRep, bool *port1, bool *port5, int sequenceSize, EdgeStats *stats);
+// Same for multi-level symbols, see multiLevel.h
+int sendSymbolsAt(uint64_t startTsc, long symbolDuration, unsigned senderRep, int levelCount, int *symbols, int symbolCount, EdgeStats *stats);
+int sendSequence(long bitDuration, unsigned senderRep, bool* sequence, int sequenceSize);
+// Spam loop of port 1, spam_port1_n by default. Set it before the first frame.
+int setSpamKernel(SpamKernel kernel);
+SpamKernel getSpamKernel();
+// 1 if this CPU runs the spam loops of the ports (SPAM_PORT*), port 5 needs AVX2
+int spamPortsSupported(int ports);
 
 #endif
@@ -6,6 +6,13 @@
 #include "sendBit.h"
 #include "p1_spam.h"
 #include "frame.h"
+#include "linkProfile.h"
+#include "workerPool.h"
+#include "tsc.h"
+#include "multiLevel.h"
+#include "dualPort.h"
+#include "stageProfile.h"
+#include "topology.h"
 
 
 #include <stdio.h>
@@ -15,52 +22,206 @@
 #include <pthread.h>
 
 
+// Sender threads, pinned on each physical core. Created on the first frame
+// and woken for each burst.
+static WorkerPool senderPool;
+static int poolStarted = 0;
+static int senderCount = 0;
+
+// Bit edge errors of each sender thread
+static EdgeStats edgeStats[MAX_PHY_CORE];
+
+// Levels per symbol, binary unless set by setSymbolLevels
+static int symbolLevels = SYMBOL_LEVELS;
+
+// Frames striped over ports 1 and 5, see setDualPort
+static int dualPort = 0;
+
+// Code of the data frames, see setFecMode
+static int fecMode = FEC_MODE;
+
+
 // Given a char, convert it into a frame and send it.
 // This is the base sending function of the data link layer.
 int send(char message, int sequenceNumber) {
-  int frameSize = DATA_FRAME_SIZE;
-  bool frame[frameSize];
-  long bitDuration = BIT_DURATION;
+  bool frame[MAX_DATA_FRAME_SIZE];
+  long bitDuration = linkProfile.bitDuration;
 
-  createDataFrame(message, sequenceNumber, frame, frameSize);
+  STAGE_TIMER(encodeStart);
+  int frameSize = createCodedDataFrame(message, sequenceNumber, fecMode, frame);
+  STAGE_RECORD(STAGE_ENCODE, encodeStart);
   if (DEBUG){
-    for (int i = 0; i < DATA_FRAME_SIZE; i ++) {
+    for (int i = 0; i < frameSize; i ++) {
       printf("%i", frame[i]);
     }
     printf("\n");
   }
-  sendSequence(bitDuration, frame, frameSize);
+  STAGE_TIMER(sendStart);
+  sendSequence(bitDuration, linkProfile.senderRep, frame, frameSize);
+  STAGE_RECORD(STAGE_SEND, sendStart);
+  return 1;
+}
+
+// Sends frames back to back, separated by ARQ_FRAME_GAP idle bits so the
+// receiver can restart its detector between two frames.
+// The first bit starts at startTsc, stats may be NULL.
+int sendFrames(dataFrame *frames, int frameCount, uint64_t startTsc, EdgeStats *stats) {
+  if (symbolLevels > 2) {
+    return sendSymbolFrames(frames, frameCount, startTsc, stats);
+  }
+  if (dualPort) {
+    return sendDualPortFrames(frames, frameCount, startTsc, stats);
+  }
+  bool sequence[ARQ_MAX_WINDOW * (MAX_DATA_FRAME_SIZE + ARQ_FRAME_GAP)] = {0};
+  int sequenceSize = 0;
+  STAGE_TIMER(encodeStart);
+  for (int i = 0; i < frameCount; i++) {
+    if (i > 0) sequenceSize += ARQ_FRAME_GAP;
+    sequenceSize += createCodedDataFrame(frames[i].data, frames[i].sequenceNumber, fecMode, &sequence[sequenceSize]);
+  }
+  STAGE_RECORD(STAGE_ENCODE, encodeStart);
+  STAGE_TIMER(sendStart);
+  sendSequenceAt(startTsc, linkProfile.bitDuration, linkProfile.senderRep, sequence, sequenceSize, stats);
+  STAGE_RECORD(STAGE_SEND, sendStart);
+  return 1;
+}
+
+// Same with multi-level symbols: each frame starts with the extended init
+// sequence of multiLevel.h, then its bits are sent by groups.
+int sendSymbolFrames(dataFrame *frames, int frameCount, uint64_t startTsc, EdgeStats *stats) {
+  int symbols[ARQ_MAX_WINDOW * (ARQ_FRAME_GAP + INIT_SYMBOLS + MAX_LEVELS + MAX_DATA_FRAME_SIZE)] = {0};
+  int symbolCount = 0;
+  STAGE_TIMER(encodeStart);
+  for (int i = 0; i < frameCount; i++) {
+    if (i > 0) symbolCount += ARQ_FRAME_GAP;
+    bool frame[MAX_DATA_FRAME_SIZE];
+    int frameSize = createCodedDataFrame(frames[i].data, frames[i].sequenceNumber, fecMode, frame);
+    symbolCount += createLevelPreamble(symbolLevels, &symbols[symbolCount]);
+    symbolCount += bitsToSymbols(frame, frameSize, symbolLevels, &symbols[symbolCount]);
+  }
+  STAGE_RECORD(STAGE_ENCODE, encodeStart);
+  STAGE_TIMER(sendStart);
+  sendSymbolsAt(startTsc, linkProfile.bitDuration, linkProfile.senderRep, symbolLevels, symbols, symbolCount, stats);
+  STAGE_RECORD(STAGE_SEND, sendStart);
+  return 1;
+}
+
+
+// Same with each frame striped over ports 1 and 5 (see dualPort.h): both
+// sub-frames are sent at once, so a frame lasts DUAL_PORT_FRAME_SIZE bits.
+int sendDualPortFrames(dataFrame *frames, int frameCount, uint64_t startTsc, EdgeStats *stats) {
+  bool port1[ARQ_MAX_WINDOW * (DUAL_PORT_FRAME_SIZE + ARQ_FRAME_GAP)] = {0};
+  bool port5[ARQ_MAX_WINDOW * (DUAL_PORT_FRAME_SIZE + ARQ_FRAME_GAP)] = {0};
+  int sequenceSize = 0;
+  STAGE_TIMER(encodeStart);
+  for (int i = 0; i < frameCount; i++) {
+    if (i > 0) sequenceSize += ARQ_FRAME_GAP;
+    sequenceSize += createDualPortFrame(frames[i].data, frames[i].sequenceNumber, &port1[sequenceSize], &port5[sequenceSize]);
+  }
+  STAGE_RECORD(STAGE_ENCODE, encodeStart);
+  STAGE_TIMER(sendStart);
+  sendDualSequenceAt(startTsc, linkProfile.bitDuration, linkProfile.senderRep, port1, port5, sequenceSize, stats);
+  STAGE_RECORD(STAGE_SEND, sendStart);
+  return 1;
+}
+
+
+
+// Selects the number of levels per symbol of the data frames
+// Returns -1 if it is not a power of two up to MAX_LEVELS
+int setSymbolLevels(int levels) {
+  if (bitsPerSymbol(levels) == -1) {
+    return -1;
+  }
+  symbolLevels = levels;
   return 1;
 }
 
+
+
+// Stripes the binary data frames over ports 1 and 5 when enabled
+int setDualPort(int enabled) {
+  dualPort = enabled;
+  return 1;
+}
+
+
+
+// Selects the code of the data frames, see convCode.h
+// Returns -1 if the mode is invalid
+int setFecMode(int mode) {
+  if (dataFrameSize(mode) == -1) {
+    return -1;
+  }
+  fecMode = mode;
+  return 1;
+}
+
+typedef struct {
+  dataFrame *frames;
+  int frameCount;
+  uint64_t startTsc; // Shared by every core, so their edges are aligned
+  EdgeStats *stats;
+} FrameBurst;
+
 // Wrapper of sender to be used with pthread
-// vargp is a void pointer pointing to a the dataframe to send.
+// vargp is a void pointer pointing to a the burst of frames to send.
 void *sendWrapper(void *vargp) {
-  dataFrame *dFrame = (dataFrame *)vargp;
-  send(dFrame->data, dFrame->sequenceNumber);
+  FrameBurst *burst = (FrameBurst *)vargp;
+  sendFrames(burst->frames, burst->frameCount, burst->startTsc, burst->stats);
+  flushStageProfile();
   return NULL;
 }
 
 
 /// Main sender function.
-// Creates a sender on each physical core.
+// Wakes a sender on each physical core, each sending the whole burst.
 // Waits for all sender to finish to return
+int multiThreadedSendFrames(dataFrame *frames, int frameCount) {
+  if(DEBUG) printf("Sending %i data frames from sequence number %u\n", frameCount, frames[0].sequenceNumber);
+  if (!poolStarted) {
+    int cpus[MAX_PHY_CORE];
+    senderCount = coreSlots(cpus, MAX_PHY_CORE);
+    if (initWorkerPool(&senderPool, senderCount, cpus) == -1) {
+      return -1;
+    }
+    for (int threadNumber = 0; threadNumber < senderCount; threadNumber++) {
+      initEdgeStats(&edgeStats[threadNumber]);
+    }
+    initTsc();
+    poolStarted = 1;
+  }
+  // Every core starts the first bit at the same TSC deadline
+  uint64_t startTsc = readTsc() + nsToTsc(SENDER_START_LEAD);
+  FrameBurst bursts[MAX_PHY_CORE];
+  void *args[MAX_PHY_CORE];
+  for (int threadNumber = 0; threadNumber < senderCount; threadNumber++) {
+    bursts[threadNumber] = (FrameBurst) {frames, frameCount, startTsc, &edgeStats[threadNumber]};
+    args[threadNumber] = &bursts[threadNumber];
+  }
+  runWorkerPool(&senderPool, sendWrapper, args);
+  return 1;
+}
+
+
+// Start skew of the senders across the cores, see workerPool.h, and error
+// of their bit edges on the TSC deadlines
+int printSenderPoolStats() {
+  printPoolStats(&senderPool, "Sender");
+  EdgeStats total;
+  initEdgeStats(&total);
+  for (int threadNumber = 0; threadNumber < senderCount; threadNumber++) {
+    mergeEdgeStats(&total, &edgeStats[threadNumber]);
+  }
+  return printEdgeStats(&total);
+}
+
+
+// Sends a single data frame
 int multiThreadedSender(char message, int sequenceNumber) {
   if(DEBUG) printf("Sending data frame:\n\t message: %c, \n\t sequenceNumber: %i\n",message, sequenceNumber );
   dataFrame dFrame;
   dFrame.data = message;
   dFrame.sequenceNumber = sequenceNumber;
-  cpu_set_t cpuset;
-  pthread_t threads[PHY_CORE];
-
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
-    pthread_create(&threads[threadNumber], NULL, sendWrapper, (void *)&dFrame);
-    CPU_ZERO(&cpuset);
-    CPU_SET(threadNumber, &cpuset);
-    pthread_setaffinity_np(threads[threadNumber], sizeof(cpuset), &cpuset);
-  }
-  for (int threadNumber = 0; threadNumber < PHY_CORE; threadNumber++) {
-    pthread_join(threads[threadNumber], NULL);
-  }
-  return 1;
+  return multiThreadedSendFrames(&dFrame, 1);
 }
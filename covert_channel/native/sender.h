@@ -1,8 +1,21 @@
 #ifndef SENDER_H
 #define SENDER_H
 
+#include "frame.h"
+#include "sendBit.h"
+
+#include <stdint.h>
+
 int send(char message, int sequenceNumber);
+int sendFrames(dataFrame *frames, int frameCount, uint64_t startTsc, EdgeStats *stats);
+int sendSymbolFrames(dataFrame *frames, int frameCount, uint64_t startTsc, EdgeStats *stats);
+int sendDualPortFrames(dataFrame *frames, int frameCount, uint64_t startTsc, EdgeStats *stats);
+int setSymbolLevels(int levels);
+int setDualPort(int enabled);
+int setFecMode(int mode);
+int multiThreadedSendFrames(dataFrame *frames, int frameCount);
 int multiThreadedSender(char message, int sequenceNumber);
+int printSenderPoolStats();
 
 
 
@@ -0,0 +1,123 @@
+/*!
+   \file softDecision.c
+   \brief Soft decisions, see softDecision.h
+*/
+
+#include "softDecision.h"
+#include "hammingCode.h"
+#include "config.h"
+
+#include <math.h>
+#include <stdatomic.h>
+
+#define INIT_SEQUENCE 0xA // 1010
+
+static atomic_ulong recoveries;
+
+
+int clustersToLlrs(SoftCluster *clusters, int clusterCount, double *llrs, int llrCount) {
+  // The noise of a point and the distance of the levels to the threshold
+  double points = 0., noise = 0., separation = 0.;
+  for (int c = 0; c < clusterCount; c++) {
+    points += clusters[c].pointCount;
+    noise += clusters[c].pointCount * clusters[c].variance;
+    separation += clusters[c].pointCount * fabs(clusters[c].margin);
+  }
+  if (points > 0.) {
+    noise /= points;
+    separation /= points;
+  }
+  if (noise < 1.) noise = 1.;
+
+  int bitCount = 0;
+  for (int c = 0; (c < clusterCount) & (bitCount < llrCount); c++) {
+    int clusterBits = (int) round(clusters[c].bitCount);
+    if (clusterBits == 0) continue;
+    // Gaussian levels at threshold +- separation: the LLR of the mean of the
+    // points of a bit is 2 * separation * (mean - threshold) / (noise / points)
+    double towards = clusters[c].bitPosition ? clusters[c].margin : -clusters[c].margin;
+    double llr = 2. * separation * towards * clusters[c].pointCount / clusterBits / noise;
+    if (llr < 0.) llr = 0.;
+    if (llr > SOFT_MAX_LLR) llr = SOFT_MAX_LLR;
+    if (!clusters[c].bitPosition) llr = -llr;
+
+    for (int b = 0; (b < clusterBits) & (bitCount < llrCount); b++) {
+      // Whether the last bit exists depends on the rounding
+      double weight = b == clusterBits - 1 ? 1. - 2. * fabs(clusters[c].bitCount - clusterBits) : 1.;
+      llrs[bitCount++] = llr * weight;
+    }
+  }
+  int givenBits = bitCount;
+  while (bitCount < llrCount) llrs[bitCount++] = 0.;
+  return givenBits;
+}
+
+
+
+int softDecodeField(double *llrs, double *gap) {
+  double best = -INFINITY, second = -INFINITY;
+  int bestNibble = -1;
+  for (int nibble = 0; nibble < (1 << ACTUAL_BIT); nibble++) {
+    uint8_t codeword = hammingEncodeNibble(nibble);
+    double metric = 0.;
+    for (int bit = 0; bit < CODED_BITS; bit++) {
+      metric += (codeword >> bit) & 1 ? llrs[bit] : -llrs[bit];
+    }
+    if (metric > best) {
+      second = best;
+      best = metric;
+      bestNibble = nibble;
+    }
+    else if (metric > second) {
+      second = metric;
+    }
+  }
+  if (gap != NULL) *gap = best - second;
+  if (best - second < SOFT_MIN_MARGIN) {
+    return -1;
+  }
+  // The bits flipped from the hard decisions must be unreliable ones
+  uint8_t codeword = hammingEncodeNibble(bestNibble);
+  double flipped = 0.;
+  for (int bit = 0; bit < CODED_BITS; bit++) {
+    if (((codeword >> bit) & 1) != (llrs[bit] > 0.)) flipped += fabs(llrs[bit]);
+  }
+  return flipped <= SOFT_MAX_FLIPPED ? bestNibble : -1;
+}
+
+
+
+requestFrame softDecodeRequestFrame(double *llrs, int frameSize) {
+  bool bits[REQUEST_FRAME_SIZE];
+  for (int i = 0; i < REQUEST_FRAME_SIZE; i++) {
+    bits[i] = llrs[i] > 0.;
+  }
+  requestFrame rFrame = decodeRequestFrame(bits, frameSize);
+  if (checkRequestFrame(rFrame) == 1) {
+    return rFrame;
+  }
+
+  rFrame.initSeq = 0;
+  for (int i = 0; i < 4; i++) {
+    int expected = (INIT_SEQUENCE >> (3 - i)) & 1;
+    if (expected ? llrs[i] < 0. : llrs[i] > 0.) {
+      return rFrame;
+    }
+  }
+  int sequenceNumber = softDecodeField(&llrs[4], NULL);
+  int sack = softDecodeField(&llrs[4 + CODED_BITS], NULL);
+  if ((sequenceNumber == -1) | (sack == -1)) {
+    return rFrame;
+  }
+  rFrame.initSeq = INIT_SEQUENCE;
+  rFrame.sequenceNumber = sequenceNumber;
+  rFrame.sack = sack;
+  atomic_fetch_add_explicit(&recoveries, 1, memory_order_relaxed);
+  return rFrame;
+}
+
+
+
+unsigned long getSoftRecoveries() {
+  return atomic_load(&recoveries);
+}
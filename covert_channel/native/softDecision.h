@@ -0,0 +1,75 @@
+/*!
+   \file softDecision.h
+   \brief Soft decisions: the detectors give a log-likelihood ratio (LLR) per
+          bit instead of a hard 0/1, log(P(1)/P(0)), positive for a 1. The
+          magnitude grows with how far the cluster of the bit sat from the
+          threshold, relative to the noise of the points, and drops for the
+          last bit of a cluster whose length was halfway between two numbers
+          of bits. Bits the detector did not reach are erasures, with a LLR of
+          0.
+          A request frame field is then decoded by maximum likelihood over the
+          16 Hamming codewords: the one that best agrees with the LLRs. It is
+          accepted when it beats the next one by SOFT_MIN_MARGIN, so a frame
+          the hard decoder rejects (two errors in a field, or bits missing at
+          its end) may still be recovered when the errors are on unreliable
+          bits.
+*/
+
+#ifndef SOFT_DECISION_H
+#define SOFT_DECISION_H
+
+#include "frame.h"
+
+
+/*!
+   \struct SoftCluster
+   \brief What the LLRs of a cluster of points are computed from
+*/
+typedef struct {
+  int bitPosition; // Hard value of its bits
+  int pointCount;
+  double margin; // Mean distance of its points to the threshold, signed
+  double variance; // Of its points
+  double bitCount; // pointCount / the bit size of its level, before rounding
+} SoftCluster;
+
+
+
+/*!
+   \fn int clustersToLlrs(SoftCluster *clusters, int clusterCount, double *llrs, int llrCount)
+   \brief Expands the clusters to round(bitCount) bits each, like the hard
+          detectors, with their LLRs. The noise and the distance between the
+          levels are pooled over the clusters. The bits after the last
+          cluster, up to llrCount, are erasures.
+   \return Number of bits given by the clusters, up to llrCount
+*/
+int clustersToLlrs(SoftCluster *clusters, int clusterCount, double *llrs, int llrCount);
+
+
+
+/*!
+   \fn int softDecodeField(double *llrs, double *gap)
+   \brief Maximum likelihood decoding of a Hamming coded field from the LLRs
+          of its CODED_BITS bits. gap (if not NULL) is set to the metric gap
+          between the two most likely codewords.
+   \return The data nibble, -1 if the gap is under SOFT_MIN_MARGIN
+*/
+int softDecodeField(double *llrs, double *gap);
+
+
+
+/*!
+   \fn requestFrame softDecodeRequestFrame(double *llrs, int frameSize)
+   \brief decodeRequestFrame on the hard decisions of the LLRs, then, if it
+          fails and no init sequence bit has the wrong sign, soft decoding of
+          both fields
+   \return The frame, its initSeq is 0 if it is invalid
+*/
+requestFrame softDecodeRequestFrame(double *llrs, int frameSize);
+
+
+
+// Frames rejected by the hard decoder and recovered by soft decoding since the start
+unsigned long getSoftRecoveries();
+
+#endif
@@ -0,0 +1,172 @@
+/*!
+   \file stageProfile.c
+   \brief Latency histograms of the hot path stages, see stageProfile.h
+*/
+
+#include "stageProfile.h"
+#include "tsc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+
+
+static const char *stageNames[STAGE_COUNT] = {
+  "read_timings", "differences", "filter", "detector", "decode", "encode", "send"
+};
+
+#if STAGE_PROFILING
+__thread StageHistogram localStageHistograms[STAGE_COUNT];
+#endif
+
+static StageHistogram stageHistograms[STAGE_COUNT];
+static pthread_mutex_t stageMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+int flushStageProfile() {
+#if STAGE_PROFILING
+  pthread_mutex_lock(&stageMutex);
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    StageHistogram *local = &localStageHistograms[stage];
+    StageHistogram *shared = &stageHistograms[stage];
+    if (local->count == 0) continue;
+    shared->count += local->count;
+    shared->sum += local->sum;
+    if (local->max > shared->max) shared->max = local->max;
+    for (int b = 0; b < STAGE_BUCKETS; b++) {
+      shared->buckets[b] += local->buckets[b];
+    }
+    memset(local, 0, sizeof(*local));
+  }
+  pthread_mutex_unlock(&stageMutex);
+#endif
+  return 1;
+}
+
+
+
+int resetStageProfile() {
+  pthread_mutex_lock(&stageMutex);
+  memset(stageHistograms, 0, sizeof(stageHistograms));
+  pthread_mutex_unlock(&stageMutex);
+  return 1;
+}
+
+
+
+// Smallest value of a bucket, the next bucket starts at bucketLow(b + 1)
+static uint64_t bucketLow(int bucket) {
+  if (bucket < STAGE_SUB_BUCKETS) {
+    return bucket;
+  }
+  int shift = bucket / STAGE_SUB_BUCKETS - 1;
+  return (uint64_t) (STAGE_SUB_BUCKETS + bucket % STAGE_SUB_BUCKETS) << shift;
+}
+
+
+
+// Value below which a fraction q of the durations are, the middle of its bucket
+static double percentileTicks(StageHistogram *histogram, double q) {
+  if (histogram->count == 0) {
+    return 0.;
+  }
+  uint64_t rank = (uint64_t) (q * (histogram->count - 1));
+  uint64_t seen = 0;
+  for (int b = 0; b < STAGE_BUCKETS; b++) {
+    seen += histogram->buckets[b];
+    if (seen > rank) {
+      double middle = (bucketLow(b) + (double) (bucketLow(b + 1) - 1)) / 2.;
+      return middle < histogram->max ? middle : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+
+
+static int writeJson(FILE *fp) {
+  fprintf(fp, "{\n  \"ticksPerNs\": %.6f,\n  \"stages\": [\n", tscTicksPerNs());
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    StageHistogram *histogram = &stageHistograms[stage];
+    fprintf(fp, "    {\"name\": \"%s\", \"count\": %" PRIu64 ", \"totalNs\": %.1f, \"meanNs\": %.1f, "
+            "\"p50Ns\": %.1f, \"p90Ns\": %.1f, \"p99Ns\": %.1f, \"p999Ns\": %.1f, \"maxNs\": %.1f,\n",
+            stageNames[stage], histogram->count, tscToNs(histogram->sum),
+            histogram->count > 0 ? tscToNs((double) histogram->sum / histogram->count) : 0.,
+            tscToNs(percentileTicks(histogram, 0.5)), tscToNs(percentileTicks(histogram, 0.9)),
+            tscToNs(percentileTicks(histogram, 0.99)), tscToNs(percentileTicks(histogram, 0.999)),
+            tscToNs(histogram->max));
+    // Non empty buckets, as [lowest ns, count]
+    fprintf(fp, "     \"buckets\": [");
+    int first = 1;
+    for (int b = 0; b < STAGE_BUCKETS; b++) {
+      if (histogram->buckets[b] == 0) continue;
+      fprintf(fp, "%s[%.1f, %" PRIu64 "]", first ? "" : ", ", tscToNs(bucketLow(b)), histogram->buckets[b]);
+      first = 0;
+    }
+    fprintf(fp, "]}%s\n", stage < STAGE_COUNT - 1 ? "," : "");
+  }
+  fprintf(fp, "  ]\n}\n");
+  return 1;
+}
+
+
+
+static int writeCsv(FILE *fp) {
+  fprintf(fp, "stage,low_ns,high_ns,count\n");
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    StageHistogram *histogram = &stageHistograms[stage];
+    for (int b = 0; b < STAGE_BUCKETS; b++) {
+      if (histogram->buckets[b] == 0) continue;
+      fprintf(fp, "%s,%.1f,%.1f,%" PRIu64 "\n", stageNames[stage], tscToNs(bucketLow(b)), tscToNs(bucketLow(b + 1)), histogram->buckets[b]);
+    }
+  }
+  return 1;
+}
+
+
+
+int writeStageProfile(const char *path) {
+  if (!STAGE_PROFILING) {
+    return -1;
+  }
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    return -1;
+  }
+  initTsc();
+  size_t length = strlen(path);
+  pthread_mutex_lock(&stageMutex);
+  if ((length >= 5) && (strcmp(path + length - 5, ".json") == 0)) {
+    writeJson(fp);
+  }
+  else {
+    writeCsv(fp);
+  }
+  pthread_mutex_unlock(&stageMutex);
+  return fclose(fp) == 0 ? 1 : -1;
+}
+
+
+
+int printStageProfile() {
+  initTsc();
+  pthread_mutex_lock(&stageMutex);
+  uint64_t total = 0;
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    total += stageHistograms[stage].sum;
+  }
+  printf("------------------------------- Stage latencies (ns) -----------------------------\n");
+  printf("stage       \tcount\tp50\tp90\tp99\tmax\ttime share\n");
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    StageHistogram *histogram = &stageHistograms[stage];
+    if (histogram->count == 0) continue;
+    printf("%-12s\t%" PRIu64 "\t%.0f\t%.0f\t%.0f\t%.0f\t%.1f%%\n", stageNames[stage], histogram->count,
+           tscToNs(percentileTicks(histogram, 0.5)), tscToNs(percentileTicks(histogram, 0.9)),
+           tscToNs(percentileTicks(histogram, 0.99)), tscToNs(histogram->max),
+           total > 0 ? 100. * histogram->sum / total : 0.);
+  }
+  pthread_mutex_unlock(&stageMutex);
+  return 1;
+}
@@ -0,0 +1,116 @@
+/*!
+   \file stageProfile.h
+   \brief Latency histograms of the stages of the hot paths, in TSC ticks.
+          Each thread records in its own histograms without any lock, and
+          merges them in the shared ones with flushStageProfile at the end
+          of every frame. The histograms are log-linear (HDR style): values
+          below 2^STAGE_SUB_BITS have a bucket each, above that every power of
+          two is split in 2^STAGE_SUB_BITS buckets, so a bucket is within 6%
+          of its values for any duration.
+          STAGE_TIMER and STAGE_RECORD compile to nothing unless
+          STAGE_PROFILING is set in config.h, and the per-thread histograms
+          only exist then, so production runs do not pay for them. The read_timings stage is the measurement itself, the
+          others are the processing overhead around it.
+*/
+
+#ifndef STAGEPROFILE_H
+#define STAGEPROFILE_H
+
+#include "config.h"
+
+#include <stdint.h>
+#include <x86intrin.h>
+
+#define STAGE_SUB_BITS 4
+#define STAGE_SUB_BUCKETS (1 << STAGE_SUB_BITS)
+#define STAGE_BUCKETS ((64 - STAGE_SUB_BITS + 1) * STAGE_SUB_BUCKETS)
+
+
+// Stages of the receiver, then of the sender
+typedef enum {
+  STAGE_READ_TIMINGS, // read_timings_n, or the simulated channel
+  STAGE_DIFFERENCES, // computeDifferences and average
+  STAGE_FILTER, // Median (or other filter) of the points
+  STAGE_DETECTOR, // parseNewPointThreshold or the DenStream update
+  STAGE_DECODE, // Bits to request frame, Hamming or soft decoding
+  STAGE_ENCODE, // createCodedDataFrame of a burst
+  STAGE_SEND, // sendSequenceAt and the other bit senders
+  STAGE_COUNT
+} Stage;
+
+
+/*!
+   \struct StageHistogram
+   \brief Durations of a stage, in TSC ticks
+*/
+typedef struct {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  uint64_t buckets[STAGE_BUCKETS];
+} StageHistogram;
+
+
+static inline int stageBucket(uint64_t ticks) {
+  if (ticks < STAGE_SUB_BUCKETS) {
+    return (int) ticks;
+  }
+  int shift = 63 - __builtin_clzll(ticks) - STAGE_SUB_BITS;
+  return (shift + 1) * STAGE_SUB_BUCKETS + (int) (ticks >> shift) - STAGE_SUB_BUCKETS;
+}
+
+#if STAGE_PROFILING
+extern __thread StageHistogram localStageHistograms[STAGE_COUNT];
+
+static inline void recordStage(Stage stage, uint64_t ticks) {
+  StageHistogram *histogram = &localStageHistograms[stage];
+  histogram->count++;
+  histogram->sum += ticks;
+  if (ticks > histogram->max) histogram->max = ticks;
+  histogram->buckets[stageBucket(ticks)]++;
+}
+
+#define STAGE_TIMER(name) uint64_t name = __rdtsc()
+#define STAGE_RECORD(stage, name) recordStage(stage, __rdtsc() - (name))
+#else
+#define STAGE_TIMER(name)
+#define STAGE_RECORD(stage, name)
+#endif
+
+
+
+/*!
+   \fn int flushStageProfile()
+   \brief Merges the histograms of the calling thread in the shared ones and
+          clears them. Does nothing without STAGE_PROFILING.
+*/
+int flushStageProfile();
+
+
+
+/*!
+   \fn int resetStageProfile()
+   \brief Clears the shared histograms
+*/
+int resetStageProfile();
+
+
+
+/*!
+   \fn int writeStageProfile(const char *path)
+   \brief Writes the shared histograms, as JSON if the path ends with .json
+          (count, total, mean, percentiles and buckets of each stage) or as
+          CSV otherwise (one line per non empty bucket). Durations are in ns.
+   \return 1 if ok, -1 if the file cannot be written or STAGE_PROFILING is 0
+*/
+int writeStageProfile(const char *path);
+
+
+
+/*!
+   \fn int printStageProfile()
+   \brief Prints the percentiles of each stage, and its share of the time
+*/
+int printStageProfile();
+
+#endif
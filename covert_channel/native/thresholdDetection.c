@@ -18,6 +18,7 @@
 
 
 #include "thresholdDetection.h"
+#include "softDecision.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,8 +31,10 @@ int initThresholdDetection(ThresholdResults * tr, int threshold) {
   tr->threshold = threshold;
   tr->bitCount = 0;
   tr->initSequenceDetected = 0;
-  tr->bitSize_0 = 5.;
-  tr->bitSize_1 = 4.;
+  tr->minSpike = MIN_SPIKE;
+  tr->maxSpike = MAX_SPIKE;
+  tr->bitSize_0 = BIT_SIZE_0;
+  tr->bitSize_1 = BIT_SIZE_1;
 
   for (int i = 0; i < MAX_TCLUSTER; i++) {
     ThresholdCluster tc = {0,-1};
@@ -41,6 +44,15 @@ int initThresholdDetection(ThresholdResults * tr, int threshold) {
   return 0;
 }
 
+// Overrides the hardcoded values, for instance with a calibrated link profile
+int setThresholdParameters(ThresholdResults * tr, int minSpike, int maxSpike, double bitSize_0, double bitSize_1) {
+  tr->minSpike = minSpike;
+  tr->maxSpike = maxSpike;
+  tr->bitSize_0 = bitSize_0;
+  tr->bitSize_1 = bitSize_1;
+  return 0;
+}
+
 // Given a point, returns if it is a 0bit or a 1bit by comparing it to the threshold
 int getBitPositionThreshold(int point, ThresholdResults * tr) {
   return (point > tr->threshold);
@@ -98,8 +110,8 @@ int getClusterCount(ThresholdResults * tr) {
 int detectInitSequenceThreshold(ThresholdResults * tr) {
   if ((tr->clusters[0].bitPosition != -1) & (tr->clusters[1].bitPosition != -1) & (tr->clusters[2].bitPosition != -1)) { // We have 3 clusters
     if ((tr->clusters[0].bitPosition == 1) & (tr->clusters[1].bitPosition == 0) & (tr->clusters[2].bitPosition == 1)) { // Proper init sequence 101
-      if ((tr->clusters[0].pointCount > MIN_SPIKE) & (tr->clusters[1].pointCount > MIN_SPIKE) & (tr->clusters[2].pointCount > MIN_SPIKE) // No spikes
-         & (tr->clusters[0].pointCount < MAX_SPIKE) & (tr->clusters[1].pointCount < MAX_SPIKE) & (tr->clusters[2].pointCount < MAX_SPIKE)) // No too long clusters
+      if ((tr->clusters[0].pointCount > tr->minSpike) & (tr->clusters[1].pointCount > tr->minSpike) & (tr->clusters[2].pointCount > tr->minSpike) // No spikes
+         & (tr->clusters[0].pointCount < tr->maxSpike) & (tr->clusters[1].pointCount < tr->maxSpike) & (tr->clusters[2].pointCount < tr->maxSpike)) // No too long clusters
       {
         tr->initSequenceDetected = 1; // Change the flag
         return 1;
@@ -114,9 +126,12 @@ int detectInitSequenceThreshold(ThresholdResults * tr) {
 int smoothen(ThresholdResults * tr) {
   int clusterCount = getClusterCount(tr);
   if (clusterCount > 2) {
-    if (tr->clusters[clusterCount - 2].pointCount < MIN_SPIKE) {
-      tr->clusters[clusterCount - 3].pointCount += tr->clusters[clusterCount - 2].pointCount;
-      tr->clusters[clusterCount - 3].pointCount += tr->clusters[clusterCount - 1].pointCount;
+    if (tr->clusters[clusterCount - 2].pointCount < tr->minSpike) {
+      for (int merged = clusterCount - 2; merged < clusterCount; merged++) {
+        tr->clusters[clusterCount - 3].pointCount += tr->clusters[merged].pointCount;
+        tr->clusters[clusterCount - 3].marginSum += tr->clusters[merged].marginSum;
+        tr->clusters[clusterCount - 3].marginSquareSum += tr->clusters[merged].marginSquareSum;
+      }
       ThresholdCluster c1 = {0, -1};
       ThresholdCluster c2 = {0, -1};
       tr->clusters[clusterCount -2] = c1;
@@ -131,7 +146,7 @@ int smoothen(ThresholdResults * tr) {
 // Used at the end, it corresponds to the frame.
 int getBitsThreshold(ThresholdResults * tr, int * bits) {
   int bitCount = 0;
-  for (int i = 0; i < MAX_TCLUSTER; i++) {
+  for (int i = 0; (i < MAX_TCLUSTER) & (bitCount < REQUEST_FRAME_SIZE); i++) {
     if (tr->clusters[i].bitPosition !=-1){
 
       for (int j = 0; j < getBitCountThreshold(&(tr->clusters[i]), tr); j ++) {
@@ -146,20 +161,50 @@ int getBitsThreshold(ThresholdResults * tr, int * bits) {
 }
 
 
+// Soft version of getBitsThreshold: the log-likelihood of each bit, see
+// softDecision.h. Bits the detector did not reach yet are erasures.
+int getSoftBitsThreshold(ThresholdResults * tr, double * llrs) {
+  SoftCluster clusters[MAX_TCLUSTER];
+  int clusterCount = 0;
+  for (int i = 0; i < MAX_TCLUSTER; i++) {
+    ThresholdCluster *tc = &tr->clusters[i];
+    if ((tc->bitPosition == -1) | (tc->pointCount == 0)) continue;
+    double margin = tc->marginSum / tc->pointCount;
+    SoftCluster sc = {tc->bitPosition, tc->pointCount, margin, tc->marginSquareSum / tc->pointCount - margin * margin,
+                      (double) tc->pointCount / (tc->bitPosition ? tr->bitSize_1 : tr->bitSize_0)};
+    clusters[clusterCount++] = sc;
+  }
+  clustersToLlrs(clusters, clusterCount, llrs, REQUEST_FRAME_SIZE);
+  return 0;
+}
+
+
+// A new cluster holding a single point
+ThresholdCluster newClusterThreshold(int point, ThresholdResults * tr) {
+  double margin = point - tr->threshold;
+  ThresholdCluster c = {1, getBitPositionThreshold(point, tr), margin, margin * margin};
+  return c;
+}
+
+
 // Main function of the detector, this is used for each new time measurement.
 int parseNewPointThreshold(int point, ThresholdResults * tr) {
   int clusterCount = getClusterCount(tr);
 
   // First case, the point is in the same cluster than before
-  if (getBitPositionThreshold(point, tr) == tr->clusters[clusterCount-1].bitPosition) {
+  // (before the init sequence fills the first clusters, there is none)
+  if ((clusterCount > 0) && (getBitPositionThreshold(point, tr) == tr->clusters[clusterCount-1].bitPosition)) {
+    double margin = point - tr->threshold;
     tr->clusters[clusterCount - 1].pointCount++;
+    tr->clusters[clusterCount - 1].marginSum += margin;
+    tr->clusters[clusterCount - 1].marginSquareSum += margin * margin;
     if (tr->initSequenceDetected) smoothen(tr); // We remove spikes
     if (tr->clusters[clusterCount -1].pointCount % 10 == 0) getTotalBitCountThreshold(tr); // We still check if we have enough bits to stop listening
   }
   // Else we may have a new cluster!
   else {
     if (!tr->initSequenceDetected){ // Check if we have a new init sequence
-      ThresholdCluster c = {1, getBitPositionThreshold(point, tr)};
+      ThresholdCluster c = newClusterThreshold(point, tr);
       tr->clusters[clusterCount] = c;
       tr->clusters[0] = tr->clusters[1];
       tr->clusters[1] = tr->clusters[2];
@@ -172,7 +217,14 @@ int parseNewPointThreshold(int point, ThresholdResults * tr) {
     }
     else {// Simply add the new threshold
       getTotalBitCountThreshold(tr);
-      ThresholdCluster c = {1, getBitPositionThreshold(point, tr)};
+      if (clusterCount == MAX_TCLUSTER) { // No room left, too noisy to be a frame
+        int minSpike = tr->minSpike, maxSpike = tr->maxSpike;
+        double bitSize_0 = tr->bitSize_0, bitSize_1 = tr->bitSize_1;
+        initThresholdDetection(tr, tr->threshold);
+        setThresholdParameters(tr, minSpike, maxSpike, bitSize_0, bitSize_1);
+        clusterCount = 0;
+      }
+      ThresholdCluster c = newClusterThreshold(point, tr);
       tr->clusters[clusterCount] = c;
     }
   }
@@ -188,7 +240,7 @@ int printThresholdDetector(ThresholdResults * tr) {
   char *str = malloc((str_size)*sizeof(char));
   char *ptr = str;
   ptr += sprintf(ptr, "------------------------------ Threshold  Results ------------------------------\n");
-  ptr += sprintf(ptr, "Threshold: %i \t\t Min Spike: %i \t\t Max Spike: %i \n", JMP_THRESHOLD, MIN_SPIKE, MAX_SPIKE);
+  ptr += sprintf(ptr, "Threshold: %i \t\t Min Spike: %i \t\t Max Spike: %i \n", tr->threshold, tr->minSpike, tr->maxSpike);
   ptr += sprintf(ptr, "Bit Size 0: %lf \t Bit Size 1: %lf \t Bit Count: %i \t InitSequence: %i\n", tr->bitSize_0, tr->bitSize_1, tr->bitCount, tr->initSequenceDetected);
   for (int i = 0; i < MAX_TCLUSTER; i++) {
     if (tr->clusters[i].bitPosition !=-1)
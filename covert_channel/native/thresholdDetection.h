@@ -4,15 +4,19 @@
 #include "config.h"
 
 
-#define MAX_TCLUSTER 20
+#define MAX_TCLUSTER 32
 #define JMP_THRESHOLD 1350
 #define MIN_SPIKE 2
 #define MAX_SPIKE 10
+#define BIT_SIZE_0 5. // Points in a 0 bit
+#define BIT_SIZE_1 4. // Points in a 1 bit
 
 
 typedef struct {
   int pointCount;
   int bitPosition;
+  double marginSum; // Of the distances of the points to the threshold, for soft decisions
+  double marginSquareSum;
 } ThresholdCluster;
 
 
@@ -20,6 +24,8 @@ typedef struct {
   int threshold;
   int bitCount;
   int initSequenceDetected;
+  int minSpike;
+  int maxSpike;
   double bitSize_0;
   double bitSize_1;
   ThresholdCluster clusters[MAX_TCLUSTER];
@@ -27,7 +33,9 @@ typedef struct {
 } ThresholdResults;
 
 int getBitsThreshold(ThresholdResults * tr, int * bits);
+int getSoftBitsThreshold(ThresholdResults * tr, double * llrs);
 int initThresholdDetection(ThresholdResults * tr, int threshold);
+int setThresholdParameters(ThresholdResults * tr, int minSpike, int maxSpike, double bitSize_0, double bitSize_1);
 int parseNewPointThreshold(int point, ThresholdResults * tr);
 int printThresholdDetector(ThresholdResults * tr);
 #endif
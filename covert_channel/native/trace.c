@@ -0,0 +1,107 @@
+/*!
+   \file trace.c
+   \brief Binary traces of the raw read_timings output
+*/
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+
+int openTraceWriter(TraceWriter *tw, const char *path, uint32_t samplesPerPass, uint32_t threadCount) {
+  tw->passCount = 0;
+  tw->fp = fopen(path, "wb");
+  if (tw->fp == NULL) {
+    return -1;
+  }
+
+  TraceHeader header;
+  memcpy(header.magic, TRACE_MAGIC, 4);
+  header.version = TRACE_VERSION;
+  header.headerSize = sizeof(TraceHeader);
+  header.samplesPerPass = samplesPerPass;
+  header.threadCount = threadCount;
+  if (fwrite(&header, sizeof(TraceHeader), 1, tw->fp) != 1) {
+    fclose(tw->fp);
+    tw->fp = NULL;
+    return -1;
+  }
+  return 1;
+}
+
+
+
+int writeTracePass(TraceWriter *tw, int threadNumber, uint64_t *timings, size_t sampleCount) {
+  TracePassHeader ph;
+  ph.threadNumber = threadNumber;
+  ph.reserved = 0;
+  ph.sampleCount = sampleCount;
+
+  // Listener threads share the writer, keep the header next to its samples
+  flockfile(tw->fp);
+  size_t ret = fwrite(&ph, sizeof(TracePassHeader), 1, tw->fp);
+  ret += fwrite(timings, sizeof(uint64_t), sampleCount, tw->fp);
+  tw->passCount++;
+  funlockfile(tw->fp);
+
+  return (ret == sampleCount + 1) ? 1 : -1;
+}
+
+
+
+int closeTraceWriter(TraceWriter *tw) {
+  if (tw->fp != NULL) {
+    fclose(tw->fp);
+    tw->fp = NULL;
+  }
+  return 1;
+}
+
+
+
+int openTraceReader(TraceReader *tr, const char *path) {
+  tr->fp = fopen(path, "rb");
+  if (tr->fp == NULL) {
+    return -1;
+  }
+  if ((fread(&tr->header, sizeof(TraceHeader), 1, tr->fp) != 1)
+      | (memcmp(tr->header.magic, TRACE_MAGIC, 4) != 0)
+      | (tr->header.headerSize < sizeof(TraceHeader))) {
+    fclose(tr->fp);
+    tr->fp = NULL;
+    return -1;
+  }
+  // Newer versions may append fields to the header
+  fseek(tr->fp, tr->header.headerSize, SEEK_SET);
+  return 1;
+}
+
+
+
+int readTracePass(TraceReader *tr, TracePassHeader *ph, uint64_t *timings, size_t maxSamples) {
+  if (fread(ph, sizeof(TracePassHeader), 1, tr->fp) != 1) {
+    return feof(tr->fp) ? 0 : -1;
+  }
+  size_t toRead = ph->sampleCount < maxSamples ? ph->sampleCount : maxSamples;
+  if (fread(timings, sizeof(uint64_t), toRead, tr->fp) != toRead) {
+    return -1;
+  }
+  if (toRead < ph->sampleCount) {
+    fseek(tr->fp, (ph->sampleCount - toRead) * sizeof(uint64_t), SEEK_CUR);
+    ph->sampleCount = toRead;
+  }
+  return 1;
+}
+
+
+
+int closeTraceReader(TraceReader *tr) {
+  if (tr->fp != NULL) {
+    fclose(tr->fp);
+    tr->fp = NULL;
+  }
+  return 1;
+}
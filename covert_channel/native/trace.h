@@ -0,0 +1,105 @@
+/*!
+   \file trace.h
+   \brief Binary traces of the raw read_timings output, used to record what the
+          receiver measured and replay it offline through the detectors.
+
+          A trace is a TraceHeader followed by passes. Each pass is a
+          TracePassHeader followed by sampleCount uint64_t words, exactly as
+          written by read_timings (start in the low 32 bits, end in the high 32
+          bits). Everything is stored in host (little-endian) byte order.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRACE_MAGIC "PCTR"
+#define TRACE_VERSION 1
+
+
+/*!
+   \struct TraceHeader
+   \brief First bytes of a trace file
+*/
+typedef struct {
+  char magic[4]; // TRACE_MAGIC, not null terminated
+  uint16_t version; // TRACE_VERSION
+  uint16_t headerSize; // sizeof(TraceHeader), to skip future extensions
+  uint32_t samplesPerPass; // RECEIVER_REP of the recording binary
+  uint32_t threadCount; // Listeners of the recording binary, one per physical core
+} TraceHeader;
+
+
+/*!
+   \struct TracePassHeader
+   \brief Header of a single read_timings pass
+*/
+typedef struct {
+  uint16_t threadNumber; // Listener thread that measured this pass
+  uint16_t reserved;
+  uint32_t sampleCount; // Number of uint64_t words following this header
+} TracePassHeader;
+
+
+typedef struct {
+  FILE *fp;
+  uint64_t passCount; // Number of passes written so far
+} TraceWriter;
+
+
+typedef struct {
+  FILE *fp;
+  TraceHeader header;
+} TraceReader;
+
+
+
+/*!
+   \fn int openTraceWriter(TraceWriter *tw, const char *path, uint32_t samplesPerPass, uint32_t threadCount)
+   \brief Creates (or truncates) a trace file and writes its header
+   \return 1 if ok, -1 if the file cannot be written
+*/
+int openTraceWriter(TraceWriter *tw, const char *path, uint32_t samplesPerPass, uint32_t threadCount);
+
+
+
+/*!
+   \fn int writeTracePass(TraceWriter *tw, int threadNumber, uint64_t *timings, size_t sampleCount)
+   \brief Appends one read_timings pass to the trace.
+          Safe to call from several threads on the same writer: the pass header
+          and its samples are written under the stream lock.
+   \return 1 if ok, -1 on a short write
+*/
+int writeTracePass(TraceWriter *tw, int threadNumber, uint64_t *timings, size_t sampleCount);
+
+
+
+int closeTraceWriter(TraceWriter *tw);
+
+
+
+/*!
+   \fn int openTraceReader(TraceReader *tr, const char *path)
+   \brief Opens a trace and checks its header
+   \return 1 if ok, -1 if the file cannot be read or is not a trace
+*/
+int openTraceReader(TraceReader *tr, const char *path);
+
+
+
+/*!
+   \fn int readTracePass(TraceReader *tr, TracePassHeader *ph, uint64_t *timings, size_t maxSamples)
+   \brief Reads the next pass of the trace. Samples beyond maxSamples are skipped
+          and ph->sampleCount is clamped to what was actually read.
+   \return 1 if a pass was read, 0 at the end of the trace, -1 if truncated
+*/
+int readTracePass(TraceReader *tr, TracePassHeader *ph, uint64_t *timings, size_t maxSamples);
+
+
+
+int closeTraceReader(TraceReader *tr);
+
+#endif
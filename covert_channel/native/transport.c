@@ -0,0 +1,135 @@
+/*!
+   \file transport.c
+   \brief Sliding window transport, see transport.h
+*/
+
+#include "transport.h"
+#include "hammingCode.h"
+#include "softDecision.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define SEQUENCE_SPACE 16 // 4 bit sequence numbers
+
+
+static long elapsedSince(struct timespec *t) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((long) (now.tv_sec - t->tv_sec))*1000000000 + (now.tv_nsec - t->tv_nsec);
+}
+
+
+
+int initArqSender(ArqSender *as, const char *message, size_t messageLength, int window, long retransmitTimeout) {
+  if ((window < 1) | (window > ARQ_MAX_WINDOW) | (messageLength == 0)) {
+    return -1;
+  }
+  as->message = message;
+  as->messageLength = messageLength;
+  as->window = window;
+  as->retransmitTimeout = retransmitTimeout;
+  as->base = 0;
+  as->next = 0;
+  as->queuedCount = 0;
+  as->resyncRequest = -1;
+  memset(as->acked, 0, sizeof(as->acked));
+  memset(as->sentAt, 0, sizeof(as->sentAt));
+  memset(&as->stats, 0, sizeof(as->stats));
+  clock_gettime(CLOCK_MONOTONIC, &as->stats.start);
+  return 1;
+}
+
+
+
+int arqProcessRequest(ArqSender *as, requestFrame rFrame) {
+  as->stats.requests++;
+  unsigned long advance = (rFrame.sequenceNumber - as->base + SEQUENCE_SPACE) % SEQUENCE_SPACE;
+  unsigned long outstanding = as->next - as->base;
+
+  if (advance > outstanding) {
+    // Acknowledges frames never sent: corrupt, unless the receiver repeats it
+    if (as->resyncRequest != rFrame.sequenceNumber) {
+      as->resyncRequest = rFrame.sequenceNumber;
+      as->stats.dropped++;
+      return -1;
+    }
+    // The receiver restarted, follow it from the last frame of its sequence
+    // number, or from the first one at the start of the stream
+    unsigned long rewind = SEQUENCE_SPACE - advance;
+    as->stats.resyncs++;
+    as->resyncRequest = -1;
+    as->base = rewind <= as->base ? as->base - rewind : rFrame.sequenceNumber;
+    as->next = as->base;
+    memset(as->acked, 0, sizeof(as->acked));
+    return 0;
+  }
+  as->resyncRequest = -1;
+
+  // Slide the window, the first unacknowledged frame becomes index 0
+  memmove(as->acked, &as->acked[advance], (ARQ_MAX_WINDOW - advance) * sizeof(bool));
+  memmove(as->sentAt, &as->sentAt[advance], (ARQ_MAX_WINDOW - advance) * sizeof(struct timespec));
+  memset(&as->acked[ARQ_MAX_WINDOW - advance], 0, advance * sizeof(bool));
+  as->base += advance;
+  as->acked[0] = 0;
+  as->stats.acknowledged += advance;
+
+  for (int i = 0; i < ARQ_MAX_WINDOW - 1; i++) {
+    if (((rFrame.sack >> i) & 1) && (as->base + 1 + i < as->next)) {
+      as->acked[1 + i] = 1;
+    }
+  }
+  return 1;
+}
+
+
+
+int arqNextFrames(ArqSender *as, dataFrame *frames) {
+  int frameCount = 0;
+  for (int i = 0; i < as->window; i++) {
+    unsigned long index = as->base + i;
+    if (index < as->next) {
+      // Already sent, only resend it once its acknowledgement is overdue
+      if (as->acked[i] || (elapsedSince(&as->sentAt[i]) < as->retransmitTimeout)) {
+        continue;
+      }
+      as->stats.retransmissions++;
+    }
+    else {
+      as->acked[i] = 0;
+      as->next++;
+    }
+    frames[frameCount].initSeq = 10;
+    frames[frameCount].sequenceNumber = index % SEQUENCE_SPACE;
+    frames[frameCount].data = as->message[index % as->messageLength];
+    as->queued[frameCount] = i;
+    frameCount++;
+  }
+  as->queuedCount = frameCount;
+  as->stats.framesSent += frameCount;
+  return frameCount;
+}
+
+
+
+int arqBurstSent(ArqSender *as) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  for (int f = 0; f < as->queuedCount; f++) {
+    as->sentAt[as->queued[f]] = now;
+  }
+  as->queuedCount = 0;
+  return 1;
+}
+
+
+
+int printArqStats(ArqSender *as) {
+  double seconds = elapsedSince(&as->stats.start) / 1e9;
+  printf("Transport: window %i, %lu bytes acknowledged in %.2f s (%.1f bit/s)\n",
+         as->window, as->stats.acknowledged, seconds, as->stats.acknowledged * 8 / seconds);
+  printf("%lu requests (%lu Hamming corrections, %lu soft recoveries), %lu frames sent, %lu retransmissions, %lu resyncs, %lu dropped\n",
+         as->stats.requests, getHammingCorrections(), getSoftRecoveries(), as->stats.framesSent, as->stats.retransmissions, as->stats.resyncs, as->stats.dropped);
+  return 1;
+}
@@ -0,0 +1,116 @@
+/*!
+   \file transport.h
+   \brief Sliding window transport on top of frame.c.
+          The native side streams a message, byte i of the stream being sent in
+          the data frame of sequence number i % 16. Each request of the web
+          receiver acknowledges the frames it got: its sequence number is a
+          cumulative ack (the next frame it expects), and its selective ack
+          bits flag the frames it got out of order after it.
+          The sender answers a request with up to a window of data frames, back
+          to back: the unacknowledged frames old enough to have timed out, then
+          new ones. With a window of 1, this is the former stop-and-wait
+          protocol.
+*/
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "config.h"
+#include "frame.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+
+/*!
+   \struct ArqStats
+   \brief Counters of the transport, for the goodput
+*/
+typedef struct {
+  unsigned long requests; // Valid requests received
+  unsigned long acknowledged; // Bytes acknowledged by the cumulative acks
+  unsigned long resyncs; // Requests outside of the window, the receiver restarted
+  unsigned long dropped; // Requests acknowledging frames never sent, taken as corrupt
+  unsigned long framesSent; // Data frames sent, retransmissions included
+  unsigned long retransmissions;
+  struct timespec start;
+} ArqStats;
+
+
+/*!
+   \struct ArqSender
+   \brief State of the sender side of the transport
+*/
+typedef struct {
+  const char *message; // Stream to send, byte i is message[i % messageLength]
+  size_t messageLength;
+  int window; // Largest number of unacknowledged frames, up to ARQ_MAX_WINDOW
+  long retransmitTimeout; // ns
+  unsigned long base; // Stream index of the oldest unacknowledged frame
+  unsigned long next; // Stream index of the first frame never sent
+  bool acked[ARQ_MAX_WINDOW]; // Selective acks, indexed from base
+  struct timespec sentAt[ARQ_MAX_WINDOW]; // End of the last burst sending it, indexed from base
+  int queued[ARQ_MAX_WINDOW]; // Indexes from base of the frames of the burst being sent
+  int queuedCount;
+  int resyncRequest; // Sequence number of the last request outside of the window, -1 if none
+  ArqStats stats;
+} ArqSender;
+
+
+
+/*!
+   \fn int initArqSender(ArqSender *as, const char *message, size_t messageLength, int window, long retransmitTimeout)
+   \brief Starts a stream at sequence number 0
+   \param retransmitTimeout Age (ns) an unacknowledged frame must reach before
+          it is sent again
+   \return 1 if ok, -1 if the window or the message is invalid
+*/
+int initArqSender(ArqSender *as, const char *message, size_t messageLength, int window, long retransmitTimeout);
+
+
+
+/*!
+   \fn int arqProcessRequest(ArqSender *as, requestFrame rFrame)
+   \brief Slides the window up to the cumulative ack of a valid request and
+          marks its selective acks.
+          A cumulative ack outside of the window acknowledges frames never
+          sent: it comes from a corrupt request or from a receiver that
+          restarted. It is dropped, unless the previous request had the same
+          one, as a restarted receiver repeats its request. The stream then
+          goes back to the last frame of that sequence number, so acknowledged
+          bytes are sent again rather than unsent ones skipped.
+   \return 1 if the request was in the window, 0 if the stream was
+           resynchronized, -1 if the request was dropped
+*/
+int arqProcessRequest(ArqSender *as, requestFrame rFrame);
+
+
+
+/*!
+   \fn int arqNextFrames(ArqSender *as, dataFrame *frames)
+   \brief Frames to send in answer to a request: timed out unacknowledged
+          frames, then new frames up to the window
+   \param[out] frames Array of at least ARQ_MAX_WINDOW frames
+   \return Number of frames to send
+*/
+int arqNextFrames(ArqSender *as, dataFrame *frames);
+
+
+
+/*!
+   \fn int arqBurstSent(ArqSender *as)
+   \brief Starts the retransmission timeout of the frames of arqNextFrames,
+          once their burst is sent. A burst can last longer than the timeout.
+*/
+int arqBurstSent(ArqSender *as);
+
+
+
+/*!
+   \fn int printArqStats(ArqSender *as)
+   \brief Prints the acknowledged bytes, goodput and retransmissions
+*/
+int printArqStats(ArqSender *as);
+
+#endif
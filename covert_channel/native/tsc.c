@@ -0,0 +1,53 @@
+/*!
+   \file tsc.c
+   \brief TSC rate calibration, see tsc.h
+*/
+
+#include "tsc.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <cpuid.h>
+
+
+static pthread_once_t tscOnce = PTHREAD_ONCE_INIT;
+static double ticksPerNs = 1.;
+static int invariant = 0;
+
+
+static long monotonicNs() {
+  struct timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return ((long) tp.tv_sec)*1000000000 + tp.tv_nsec;
+}
+
+
+static void calibrateTsc() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    invariant = (edx >> 8) & 1;
+  }
+  if (!invariant) {
+    fprintf(stderr, "The TSC is not invariant, TSC deadlines may drift\n");
+  }
+
+  long startNs = monotonicNs();
+  uint64_t startTsc = readTsc();
+  long elapsed;
+  while ((elapsed = monotonicNs() - startNs) < TSC_CALIBRATION_TIME);
+  ticksPerNs = (double) (readTsc() - startTsc) / elapsed;
+}
+
+
+
+int initTsc() {
+  pthread_once(&tscOnce, calibrateTsc);
+  return invariant;
+}
+
+
+
+double tscTicksPerNs() {
+  return ticksPerNs;
+}
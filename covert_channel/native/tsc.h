@@ -0,0 +1,48 @@
+/*!
+   \file tsc.h
+   \brief Time stamp counter as a clock.
+          The TSC is read without a system call, and with an invariant TSC it
+          ticks at a constant rate on every core. Its rate is calibrated once
+          against CLOCK_MONOTONIC.
+*/
+
+#ifndef TSC_H
+#define TSC_H
+
+#include <stdint.h>
+#include <x86intrin.h>
+
+#define TSC_CALIBRATION_TIME 20000000 // ns spent measuring the TSC rate
+
+
+/*!
+   \fn int initTsc()
+   \brief Calibrates the TSC rate, only the first call does it. Thread safe.
+   \return 1 if the TSC is invariant, 0 if it is not (it may then drift with
+           the core frequency)
+*/
+int initTsc();
+
+
+/*!
+   \fn double tscTicksPerNs()
+   \return TSC ticks per ns, initTsc must have been called
+*/
+double tscTicksPerNs();
+
+
+static inline uint64_t nsToTsc(long ns) {
+  return (uint64_t) (ns * tscTicksPerNs());
+}
+
+static inline double tscToNs(double ticks) {
+  return ticks / tscTicksPerNs();
+}
+
+// Ordered with the previous instructions, unlike a bare rdtsc
+static inline uint64_t readTsc() {
+  _mm_lfence();
+  return __rdtsc();
+}
+
+#endif
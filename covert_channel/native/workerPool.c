@@ -0,0 +1,154 @@
+/*!
+   \file workerPool.c
+   \brief Pinned worker pool woken through futexes, see workerPool.h
+*/
+
+#define _GNU_SOURCE
+
+#include "workerPool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <x86intrin.h>
+
+
+static void futexWait(atomic_uint *word, unsigned int value) {
+  syscall(SYS_futex, (unsigned int *) word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void futexWake(atomic_uint *word) {
+  syscall(SYS_futex, (unsigned int *) word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+
+
+static void *worker(void *vargp) {
+  WorkerSlot *slot = (WorkerSlot *)vargp;
+  WorkerPool *pool = slot->pool;
+  unsigned int seen = 0;
+
+  while (1) {
+    unsigned int generation;
+    while ((generation = atomic_load(&pool->generation)) == seen) {
+      futexWait(&pool->generation, seen);
+    }
+    seen = generation;
+    pool->wakeTsc[slot->index] = __rdtsc();
+
+    // Start barrier: the last worker woken releases the others
+    atomic_fetch_add(&pool->arrived, 1);
+    unsigned int spin = 0;
+    while (atomic_load(&pool->arrived) < pool->workerCount) {
+      // On a loaded machine the others may not even be scheduled, let them run
+      if (++spin > POOL_SPIN_LIMIT) sched_yield();
+      else _mm_pause();
+    }
+    pool->startTsc[slot->index] = __rdtsc();
+
+    pool->task(pool->args[slot->index]);
+
+    if (atomic_fetch_sub(&pool->running, 1) == 1) {
+      futexWake(&pool->running);
+    }
+  }
+  return NULL;
+}
+
+
+
+int initWorkerPool(WorkerPool *pool, int workerCount, const int *cpus) {
+  if ((workerCount < 1) | (workerCount > MAX_WORKERS)) {
+    return -1;
+  }
+  memset(pool, 0, sizeof(*pool));
+  pool->workerCount = workerCount;
+  cpu_set_t allowed;
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+
+  for (int i = 0; i < workerCount; i++) {
+    pool->slots[i].pool = pool;
+    pool->slots[i].index = i;
+
+    // Pinned through the attributes, the thread never runs elsewhere
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if ((cpus != NULL) && (cpus[i] >= 0) && ((cpus[i] >= CPU_SETSIZE) || !CPU_ISSET(cpus[i], &allowed))) {
+      fprintf(stderr, "CPU %i is not available, worker %i is not pinned\n", cpus[i], i);
+    }
+    else if ((cpus != NULL) && (cpus[i] >= 0)) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpus[i], &cpuset);
+      pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+    }
+    int ret = pthread_create(&pool->threads[i], &attr, worker, &pool->slots[i]);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+      return -1;
+    }
+  }
+  return 1;
+}
+
+
+
+int startWorkerPool(WorkerPool *pool, WorkerTask task, void **args) {
+  pool->task = task;
+  pool->args = args;
+  atomic_store(&pool->arrived, 0);
+  atomic_store(&pool->running, pool->workerCount);
+  atomic_fetch_add(&pool->generation, 1);
+  futexWake(&pool->generation);
+  return 1;
+}
+
+
+
+int waitWorkerPool(WorkerPool *pool) {
+  unsigned int running;
+  while ((running = atomic_load(&pool->running)) != 0) {
+    futexWait(&pool->running, running);
+  }
+
+  uint64_t firstWake = UINT64_MAX, lastWake = 0, firstStart = UINT64_MAX, lastStart = 0;
+  for (int i = 0; i < pool->workerCount; i++) {
+    if (pool->wakeTsc[i] < firstWake) firstWake = pool->wakeTsc[i];
+    if (pool->wakeTsc[i] > lastWake) lastWake = pool->wakeTsc[i];
+    if (pool->startTsc[i] < firstStart) firstStart = pool->startTsc[i];
+    if (pool->startTsc[i] > lastStart) lastStart = pool->startTsc[i];
+  }
+  PoolStats *stats = &pool->stats;
+  stats->runs++;
+  stats->wakeSpreadSum += lastWake - firstWake;
+  if (lastWake - firstWake > stats->wakeSpreadMax) stats->wakeSpreadMax = lastWake - firstWake;
+  stats->startSpreadSum += lastStart - firstStart;
+  if (lastStart - firstStart > stats->startSpreadMax) stats->startSpreadMax = lastStart - firstStart;
+  return 1;
+}
+
+
+
+int runWorkerPool(WorkerPool *pool, WorkerTask task, void **args) {
+  startWorkerPool(pool, task, args);
+  return waitWorkerPool(pool);
+}
+
+
+
+int printPoolStats(WorkerPool *pool, const char *name) {
+  PoolStats *stats = &pool->stats;
+  if (stats->runs == 0) {
+    printf("%s pool: no run\n", name);
+    return 1;
+  }
+  printf("%s pool: %lu runs on %i workers \t Wake skew: mean %lu, max %lu cycles \t Start skew: mean %lu, max %lu cycles\n",
+         name, stats->runs, pool->workerCount,
+         stats->wakeSpreadSum / stats->runs, stats->wakeSpreadMax,
+         stats->startSpreadSum / stats->runs, stats->startSpreadMax);
+  return 1;
+}
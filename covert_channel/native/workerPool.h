@@ -0,0 +1,115 @@
+/*!
+   \file workerPool.h
+   \brief Long-lived pool of worker threads, pinned from their creation.
+          The sender and the receiver run the same task on every physical core
+          for each frame. Instead of creating and joining threads each time,
+          the workers sleep on a futex and are woken for every run. Once woken,
+          they meet at a short spin barrier so they all start the task at the
+          same time, whatever the order the kernel woke them in.
+          The pool records the spread of the wake up and start times (TSC
+          cycles between the first and the last worker) of every run.
+*/
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define MAX_WORKERS 64
+#define POOL_SPIN_LIMIT (1<<12) // Pauses before a worker yields at the start barrier
+
+
+typedef void *(*WorkerTask)(void *arg);
+typedef struct WorkerPool WorkerPool;
+
+
+/*!
+   \struct WorkerSlot
+   \brief Argument of a worker thread
+*/
+typedef struct {
+  WorkerPool *pool;
+  int index;
+} WorkerSlot;
+
+
+/*!
+   \struct PoolStats
+   \brief Start skew across the workers, in TSC cycles
+*/
+typedef struct {
+  unsigned long runs;
+  uint64_t wakeSpreadSum; // Between the first and the last worker woken
+  uint64_t wakeSpreadMax;
+  uint64_t startSpreadSum; // Between the first and the last worker leaving the barrier
+  uint64_t startSpreadMax;
+} PoolStats;
+
+
+/*!
+   \struct WorkerPool
+   \brief The futex words are the generation (workers wait for a new run) and
+          the count of running workers (the caller waits for the end of a run)
+*/
+struct WorkerPool {
+  int workerCount;
+  pthread_t threads[MAX_WORKERS];
+  WorkerSlot slots[MAX_WORKERS];
+  atomic_uint generation; // Incremented for every run
+  atomic_uint running; // Workers still running the task
+  atomic_int arrived; // Workers at the start barrier
+  WorkerTask task;
+  void **args; // One argument per worker
+  uint64_t wakeTsc[MAX_WORKERS];
+  uint64_t startTsc[MAX_WORKERS];
+  PoolStats stats;
+};
+
+
+
+/*!
+   \fn int initWorkerPool(WorkerPool *pool, int workerCount, const int *cpus)
+   \brief Creates the workers, worker i is pinned on cpus[i] before it runs.
+          The pool must not move afterwards, the workers keep a pointer to it.
+   \param cpus Logical CPU of each worker, NULL or a negative CPU leaves the
+          worker unpinned
+   \return 1 if ok, -1 if a thread could not be created
+*/
+int initWorkerPool(WorkerPool *pool, int workerCount, const int *cpus);
+
+
+
+/*!
+   \fn int startWorkerPool(WorkerPool *pool, WorkerTask task, void **args)
+   \brief Wakes the workers, worker i runs task(args[i]). Does not wait.
+*/
+int startWorkerPool(WorkerPool *pool, WorkerTask task, void **args);
+
+
+
+/*!
+   \fn int waitWorkerPool(WorkerPool *pool)
+   \brief Waits until every worker is done with the task, and updates the skew
+          statistics
+*/
+int waitWorkerPool(WorkerPool *pool);
+
+
+
+/*!
+   \fn int runWorkerPool(WorkerPool *pool, WorkerTask task, void **args)
+   \brief startWorkerPool then waitWorkerPool
+*/
+int runWorkerPool(WorkerPool *pool, WorkerTask task, void **args);
+
+
+
+/*!
+   \fn int printPoolStats(WorkerPool *pool, const char *name)
+   \brief Prints the mean and largest start skew of the runs
+*/
+int printPoolStats(WorkerPool *pool, const char *name);
+
+#endif
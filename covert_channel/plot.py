@@ -1,16 +1,58 @@
 import plotly.graph_objects as go
-import os
-def plottest():
-    for file in os.listdir('.'):
-        if file[0:5] == 'data_':
-            with open(file, "r") as f:
-                filecontent = [int(k) for k in f.read().split("\t")[:-1]]
-            fig = go.Figure([go.Bar(y=filecontent)])
-            fig.update_yaxes(range=[0,2000])
-            fig.show()
+from plotly.subplots import make_subplots
+import glob
+import struct
+import sys
+
+# Point traces of the listeners, see native/pointTrace.h
+HEADER = struct.Struct('<4sHHIIII Q')
+RECORD = struct.Struct('<QIIHBB4x')
+POINT_FILTERED = 1
+POINT_FRAME_END = 4
+
+
+def readPointTrace(path):
+    """Returns the thread number and the records of a point trace, oldest first"""
+    with open(path, 'rb') as f:
+        content = f.read()
+    magic, version, headerSize, recordSize, capacity, threadNumber, _, head = HEADER.unpack_from(content)
+    if magic != b'PCPT':
+        raise ValueError(path + ' is not a point trace')
+    count = min(head, capacity)
+    first = head - count  # The ring keeps the last capacity records
+    records = []
+    for i in range(first, head):
+        offset = headerSize + (i % capacity) * recordSize
+        tsc, timing, point, bitCount, flags, _ = RECORD.unpack_from(content, offset)
+        records.append({'tsc': tsc, 'timing': timing, 'point': point, 'bitCount': bitCount, 'flags': flags})
+    return threadNumber, records
+
+
+def plottest(prefix='points'):
+    for path in sorted(glob.glob(prefix + '.*')):
+        threadNumber, records = readPointTrace(path)
+        if not records:
+            continue
+        start = records[0]['tsc']
+        x = [r['tsc'] - start for r in records]
+        filtered = [r for r in records if r['flags'] & POINT_FILTERED]
+        fig = make_subplots(specs=[[{'secondary_y': True}]])
+        fig.add_trace(go.Scattergl(x=x, y=[r['timing'] for r in records], mode='markers', name='timings',
+                                   marker={'size': 2, 'color': 'lightgrey'}))
+        fig.add_trace(go.Scattergl(x=[r['tsc'] - start for r in filtered], y=[r['point'] for r in filtered],
+                                   mode='lines+markers', name='points'))
+        fig.add_trace(go.Scattergl(x=x, y=[r['bitCount'] for r in records], mode='lines', name='bits',
+                                   line={'shape': 'hv'}), secondary_y=True)
+        for r in records:
+            if r['flags'] & POINT_FRAME_END:
+                fig.add_vline(x=r['tsc'] - start, line_dash='dot')
+        fig.update_layout(title='Listener %i (%s)' % (threadNumber, path))
+        fig.update_xaxes(title_text='TSC ticks')
+        fig.update_yaxes(range=[0, 2000], secondary_y=False)
+        fig.show()
 
 if __name__ == '__main__':
-    plottest()
+    plottest(*sys.argv[1:])
     # denStreamToBits(0)
     # for i in range(4):
     #     densityToBits(i)
@@ -7,13 +7,41 @@ BIT_DURATION = 1; // Duration of a bit in milliseconds, ie the time we create (o
 
 
 
+// Code of the data frames, same as -F of the native sender (see convCode.js)
+const FEC_NONE = 0; // Only the Berger code, which detects errors
+const FEC_RATE_1_2 = 1;
+const FEC_RATE_2_3 = 2;
+const FEC_MODE = FEC_NONE;
+const CONV_TAIL = 4;
+
 // Length of our packet and parts (in bits).
-const DATA_FRAME_SIZE = 21;
-const REQUEST_FRAME_SIZE = 12;
+const PLAIN_FRAME_SIZE = 21; // Data frame before its convolutional code
+const DATA_FRAME_SIZE = [
+  PLAIN_FRAME_SIZE,
+  4 + 2 * (PLAIN_FRAME_SIZE - 4 + CONV_TAIL),
+  4 + Math.ceil(1.5 * (PLAIN_FRAME_SIZE - 4 + CONV_TAIL))
+][FEC_MODE];
+const REQUEST_FRAME_SIZE = 20;
 const INIT_SEQ_SIZE = 4;
 const SEQ_NB_SIZE = 4;
 const DATA_SIZE = 8;
 const CODE_SIZE = 5
+const SACK_SIZE = 4; // Selective ack bits of a request frame
+
+// Data frames the native sender answers a request with, same as ARQ_WINDOW in
+// native/config.h (or -W). Up to SACK_SIZE + 1.
+const ARQ_WINDOW = 4;
+
+// Levels per symbol of the data frames, same as -L of the native sender.
+// 2 is the binary channel, 4 or 8 use multi-level symbols (see multiLevel.js)
+const SYMBOL_LEVELS = 2;
+
+
+// Soft decisions on the data frames, see softDecision.js and native/softDecision.h
+const SOFT_DECISION = 1; // Fall back on the bit log-likelihoods when the hard bits are invalid
+const SOFT_MAX_LLR = 16; // Largest magnitude of a bit log-likelihood
+const SOFT_MIN_MARGIN = 4; // Smallest metric gap between the two most likely frames
+const SOFT_MAX_FLIPPED = 4; // Largest sum of the LLR magnitudes of the bits flipped from the hard decisions
 
 
 // CODES
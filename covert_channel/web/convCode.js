@@ -0,0 +1,123 @@
+/**
+* This module decodes the convolutional code of the data frames (FEC_MODE in
+* config.js, -F of the native sender), see native/convCode.h: constraint
+* length 5, generators 023 and 035 (octal). At rate 2/3 the second output of
+* every other bit is not sent. CONV_TAIL zeros end the input, so the encoder
+* ends in state 0.
+*
+* The Viterbi decoder takes soft values: positive for a 1, negative for a 0,
+* their magnitude being the confidence. Hard bits are +1 or -1, and the LLRs of
+* softDecision.js can be given as they are.
+**/
+
+const CONV_STATES = 1 << CONV_TAIL;
+const CONV_POLY_A = 0o23;
+const CONV_POLY_B = 0o35;
+
+
+/**
+ * parity - Parity of the bits of a number.
+ *
+ * @param  {Number} x
+ * @return {Number}   1 if it has an odd number of bits set, 0 otherwise
+ */
+function parity(x) {
+  var p = 0;
+  for (; x; x >>= 1) p ^= x & 1;
+  return p;
+}
+
+
+/**
+ * sendsSecondOutput - Whether the second output of a step is sent.
+ *
+ * @param  {Number} step    Index of the input bit
+ * @param  {Number} fecMode FEC_RATE_1_2 or FEC_RATE_2_3
+ * @return {Boolean}
+ */
+function sendsSecondOutput(step, fecMode) {
+  return (fecMode == FEC_RATE_1_2) || (step % 2 == 0);
+}
+
+
+/**
+ * convEncode - Encodes the bits followed by the tail.
+ *
+ * @param  {Array} bits     Input bits
+ * @param  {Number} fecMode FEC_RATE_1_2 or FEC_RATE_2_3
+ * @return {Array}          Coded bits
+ */
+function convEncode(bits, fecMode) {
+  var coded = [];
+  var state = 0;
+  for (var step = 0; step < bits.length + CONV_TAIL; step++) {
+    var shiftRegister = (state << 1) | (step < bits.length ? bits[step] : 0);
+    coded.push(parity(shiftRegister & CONV_POLY_A));
+    if (sendsSecondOutput(step, fecMode)) {
+      coded.push(parity(shiftRegister & CONV_POLY_B));
+    }
+    state = shiftRegister & (CONV_STATES - 1);
+  }
+  return coded;
+}
+
+
+/**
+ * viterbiDecode - Most likely input bits given the received values.
+ *
+ * @param  {Array(Number)} values Received values, positive for a 1
+ * @param  {Number} bitCount      Number of input bits, tail excluded
+ * @param  {Number} fecMode       FEC_RATE_1_2 or FEC_RATE_2_3
+ * @return {Array}                The input bits
+ */
+function viterbiDecode(values, bitCount, fecMode) {
+  // Metrics are correlations with the received values, the larger the better
+  var metrics = new Array(CONV_STATES).fill(-Infinity);
+  metrics[0] = 0;
+  var predecessors = [];
+  var index = 0;
+  for (var step = 0; step < bitCount + CONV_TAIL; step++) {
+    var a = values[index++];
+    var b = sendsSecondOutput(step, fecMode) ? values[index++] : 0;
+    var next = new Array(CONV_STATES).fill(-Infinity);
+    var from = new Array(CONV_STATES).fill(0);
+    for (var state = 0; state < CONV_STATES; state++) {
+      for (var u = 0; u < 2; u++) {
+        var shiftRegister = (state << 1) | u;
+        var metric = metrics[state]
+          + (parity(shiftRegister & CONV_POLY_A) ? a : -a)
+          + (parity(shiftRegister & CONV_POLY_B) ? b : -b);
+        var nextState = shiftRegister & (CONV_STATES - 1);
+        if (metric > next[nextState]) {
+          next[nextState] = metric;
+          from[nextState] = state;
+        }
+      }
+    }
+    metrics = next;
+    predecessors.push(from);
+  }
+
+  var bits = new Array(bitCount);
+  var state = 0;
+  for (var step = bitCount + CONV_TAIL - 1; step >= 0; step--) {
+    if (step < bitCount) bits[step] = state & 1;
+    state = predecessors[step][state];
+  }
+  return bits;
+}
+
+
+/**
+ * fecDecodeFrame - Data frame as sent before its convolutional code.
+ *
+ * @param  {Array} bitFrame Received data frame, the missing bits are -1
+ * @return {Array}          Its PLAIN_FRAME_SIZE bits before the code
+ */
+function fecDecodeFrame(bitFrame) {
+  if (FEC_MODE == FEC_NONE) {
+    return bitFrame;
+  }
+  var values = bitFrame.slice(INIT_SEQ_SIZE).map(bit => bit < 0 ? 0 : 2 * bit - 1);
+  return bitFrame.slice(0, INIT_SEQ_SIZE).concat(viterbiDecode(values, PLAIN_FRAME_SIZE - INIT_SEQ_SIZE, FEC_MODE));
+}
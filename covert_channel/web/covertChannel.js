@@ -9,7 +9,7 @@
  */
 async function request(ccState, spamFunction) {
   if (DEBUG) console.log("Sending request for frame number ", ccState.sequenceNumber);
-  var request = createRequestFrame(ccState.sequenceNumber);
+  var request = createRequestFrame(ccState.sequenceNumber, getSack(ccState));
   if (DEBUG) console.log(request)
   await sendSequence(BIT_DURATION, request, spamFunction=spamFunction);
   if (DEBUG) console.log("Done sending, waiting for answer...");
@@ -18,34 +18,83 @@ async function request(ccState, spamFunction) {
 
 
 /**
- * waitAnswer - Wait for a data frame and process it
+ * getSack - Selective ack bits of the packets received after the next expected
+ * one.
+ *
+ * @param  {Object} ccState             State of the covert channel.
+ * @return {Number}                     Bit i is set if packet sequenceNumber+1+i
+ * is buffered
+ */
+function getSack(ccState) {
+  var sack = 0;
+  for (var i = 0; i < SACK_SIZE; i++) {
+    if (ccState.buffered[(ccState.sequenceNumber + 1 + i) % 16] !== undefined) {
+      sack |= 1 << i;
+    }
+  }
+  return sack;
+}
+
+
+
+/**
+ * acceptFrame - Delivers a valid data frame in order, or buffers it if a
+ * previous one is missing.
+ *
+ * @param  {Object} ccState             State of the covert channel.
+ * @param  {Object} frame               Decoded data frame
+ * @return {Boolean}                    False if the frame was a duplicate
+ */
+function acceptFrame(ccState, frame) {
+  var offset = (frame.sequenceNumber - ccState.sequenceNumber + 16) % 16;
+  if (offset > SACK_SIZE) {
+    return false // Already delivered, its ack got lost
+  }
+  ccState.buffered[frame.sequenceNumber] = frame.data;
+  // Deliver every frame we now have in order
+  while (ccState.buffered[ccState.sequenceNumber] !== undefined) {
+    ccState.data += ccState.buffered[ccState.sequenceNumber];
+    delete ccState.buffered[ccState.sequenceNumber];
+    ccState.sequenceNumber = (ccState.sequenceNumber+1)%16;
+  }
+  return true
+}
+
+
+
+/**
+ * waitAnswer - Wait for the window of data frames and process them
  *
  * @param  {Object} ccState             State of the covert channel.
  * @param  {Function} spamFunction      Function used to receive bits by creating
  * contention on port 1. We generally use i64.ctz spamming
  * @param  {Object} clock               SharedArray buffer clock
- * @return {Number}                     A code, showing if the frame is valid or not
+ * @return {Number}                     A code, showing if at least a frame is
+ * valid or not
  */
 async function waitAnswer(ccState, spam, clock) {
-  var answer = await listenDen(spamFunction = spam, clock=clock);
-  if (answer == TIMEOUT) {
-    return TIMEOUT
-  }
-  else {
+  var code = TIMEOUT;
+  // The sender sends up to ARQ_WINDOW frames back to back, we listen for each
+  // of them until one times out
+  for (var i = 0; i < ARQ_WINDOW; i++) {
+    var answer = SYMBOL_LEVELS > 2 ? await listenLevels(spam, clock) : await listenDen(spamFunction = spam, clock=clock);
+    if (answer.results.bitCount < DATA_FRAME_SIZE) {
+      break // Timeout, no more frame
+    }
     var frame = decodeDataFrame(answer['bits']);
-    if ((frame != INVALID_CODE) && (frame !=INVALID_INIT_SEQ) && frame.sequenceNumber == ccState.sequenceNumber  && alphabet.includes(getData(bits))) {
+    if ((frame != INVALID_CODE) && (frame !=INVALID_INIT_SEQ) && (frame != INVALID_FRAME_SIZE) && alphabet.includes(frame.data)) {
       if (DEBUG) {
         console.log("Received valid frame");
-        console.log("Sequence number: ", ccState.sequenceNumber, " Data: ", frame.data);
+        console.log("Sequence number: ", frame.sequenceNumber, " Data: ", frame.data);
       }
-      ccState.sequenceNumber = (ccState.sequenceNumber+1)%16;
-      ccState.data += frame.data;
-      return VALID_ANSWER
+      acceptFrame(ccState, frame);
+      code = VALID_ANSWER;
     }
-    else {
-      return INVALID_FRAME
+    else if (code == TIMEOUT) {
+      code = INVALID_FRAME;
     }
   }
+  return code
 }
 
 
@@ -62,7 +111,8 @@ async function waitAnswer(ccState, spam, clock) {
 async function initCovertChannel(sequenceNumber=0) {
   var failedPacketCount = 0; // Used for stats about packet loss
   var ccState = { // this object represents the state of the covert channel
-    sequenceNumber: sequenceNumber,
+    sequenceNumber: sequenceNumber, // Next expected frame
+    buffered: {}, // Frames received out of order, by sequence number
     data: '',
   }
   var ctz_spam = await initCTZSpam(); // Function used to send bits
@@ -89,7 +139,7 @@ async function initCovertChannel(sequenceNumber=0) {
     }
 
     // statss
-    if (ccState.data.length == evaluationByteNumber) {
+    if (ccState.data.length >= evaluationByteNumber) {
       elapsedTime = performance.now()-start
       Bps = (evaluationByteNumber / elapsedTime)*1000
       bps = Bps*8
@@ -119,10 +119,26 @@ function checkCode(bitFrame) {
 
 
 
+/**
+ * checkDataFrame - Checks if a received data frame is valid: init sequence,
+ * Berger code (after the convolutional code, if any) and a character of the
+ * alphabet.
+ *
+ * @param  {Array} bitFrame Received data frame
+ * @return {boolean}        True if the frame is valid.
+ */
+function checkDataFrame(bitFrame) {
+  var plainFrame = fecDecodeFrame(bitFrame);
+  return checkCode(plainFrame) & checkInitSequence(plainFrame) & alphabet.includes(getData(plainFrame));
+}
+
+
+
 /**
  * decodeDataFrame - Decode a data frame given in the array form and retrieve
  * all data: the init sequence, sequence number, data, and codes.
  *
+ * The frame is first decoded with the convolutional code of FEC_MODE, if any.
  * This function checks the init sequence and berger code. If the frame is valid,
  * an object containing all data is returned. Otherwise, a string error is returned.
  *
@@ -137,6 +153,7 @@ function decodeDataFrame(bitFrame) {
     if (DEBUG) console.log("Invalid frame size.");
     return INVALID_FRAME_SIZE;
   }
+  bitFrame = fecDecodeFrame(bitFrame);
   var decodedFrame = {
     initSequence: getInitSequence(bitFrame),
     sequenceNumber: getSequenceNumber(bitFrame),
@@ -166,22 +183,27 @@ function decodeDataFrame(bitFrame) {
 /**                              Frame encoding                              **/
 /**
 The web / receiver part only has one kind of packet. It is used as an ack, and a
-request for the next packet.
+request for the next packets.
 It has the following format:
 | + + + + + + + + |
 |  INIT |  SEQN   |
-|  SEQN |         |
+|  SEQN |  SACK   |
+|  SACK |         |
 | + + + + + + + + |
 
 - INIT: A header sequence, always set to 1010. Its goal is to mark the start of
 the frame as well as allowing the receiver to calibrate the duration of a bit,
 as it varies with the core frequency.
 
-- SEQN: A 4 bit sequence number, ranging from 0 to 15, encoded with hamming code
+- SEQN: A 4 bit sequence number, ranging from 0 to 15, encoded with hamming code.
+It is a cumulative ack: every packet before SEQN was received.
+
+- SACK: 4 bits of selective ack, encoded with hamming code. Bit i (least
+significant first) is set if packet SEQN+1+i was received out of order.
 
 
-If packet N is correctly received, we send a request for SEQN = N+1
-Otherwise, we resend a request for SEQN = N
+The sender answers with up to ARQ_WINDOW packets, the ones that were not
+acknowledged yet.
 
 **/
 
@@ -225,11 +247,11 @@ function sequenceNumberToBin(sequenceNumber) {
  * @param  {type} frame description
  * @return {type}       description
  */
-function setEncodedSequenceNumber(frame, sequenceNumber) {
+function setEncodedSequenceNumber(frame, sequenceNumber, offset = 4) {
   dataBin = sequenceNumberToBin(sequenceNumber);
   encodedSeqNum = hammingEncode(dataBin);
   for (var i = 0; i < 8; i++) {
-    frame[4+i] = encodedSeqNum[i];
+    frame[offset+i] = encodedSeqNum[i];
   }
 }
 
@@ -238,13 +260,15 @@ function setEncodedSequenceNumber(frame, sequenceNumber) {
 /**
  * createRequestFrame - Create a request frame for a given sequence number
  *
- * @param  {int} sequenceNumber
+ * @param  {int} sequenceNumber   Cumulative ack, the next expected packet
+ * @param  {int} sack = 0         Selective ack bits of the following packets
  * @return {array}                The frame as an array of bits (int).
  */
-function createRequestFrame(sequenceNumber) {
+function createRequestFrame(sequenceNumber, sack = 0) {
   var frame = new Array(REQUEST_FRAME_SIZE);
   setInitSequence(frame);
   setEncodedSequenceNumber(frame, sequenceNumber);
+  setEncodedSequenceNumber(frame, sack, 12);
   return frame
 }
 
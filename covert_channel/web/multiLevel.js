@@ -0,0 +1,188 @@
+/**
+* This module receives data frames sent with multi-level symbols (see
+* native/multiLevel.h): each symbol carries log2(SYMBOL_LEVELS) Gray coded bits,
+* sent as a contention intensity.
+*
+* Frames start with an extended init sequence: 1010 with the lowest and
+* highest levels, giving the start of the frame and the symbol size, then
+* every level in increasing order, giving the median timing of each level.
+* Symbols are then classified with thresholds halfway between these medians.
+**/
+
+const INIT_SYMBOLS = 4;
+
+
+/**
+ * bitsPerSymbol - Number of bits carried by a symbol.
+ *
+ * @param  {Number} levelCount Levels per symbol, a power of two
+ * @return {Number}            log2(levelCount)
+ */
+function bitsPerSymbol(levelCount) {
+  return Math.round(Math.log2(levelCount));
+}
+
+
+/**
+ * symbolsToBits - Converts Gray coded symbols back to bits.
+ *
+ * @param  {Array} symbols     Levels of the symbols
+ * @param  {Number} levelCount Levels per symbol
+ * @param  {Number} bitCount   Number of bits to return
+ * @return {Array}             Bits, the ones without a symbol are -1
+ */
+function symbolsToBits(symbols, levelCount, bitCount) {
+  var width = bitsPerSymbol(levelCount);
+  var bits = new Array(bitCount).fill(-1);
+  for (var s = 0; s < symbols.length; s++) {
+    var value = symbols[s];
+    for (var shift = 1; shift < width; shift <<= 1) {
+      value ^= value >> shift;
+    }
+    for (var b = 0; b < width; b++) {
+      if (s * width + b < bitCount) bits[s * width + b] = (value >> (width - 1 - b)) & 1;
+    }
+  }
+  return bits;
+}
+
+
+/**
+ * findEdge - Finds the next edge, i.e. the first of MERGE_SPIKE points in a row
+ * on the other side of the threshold.
+ *
+ * @param  {Array} points    Timing measurements
+ * @param  {Number} from     Index to start from
+ * @param  {Boolean} rising  True for a rising edge, false for a falling one
+ * @return {Number}          Index of the edge, -1 if there is none
+ */
+function findEdge(points, from, rising) {
+  var run = 0;
+  for (var i = from; i < points.length; i++) {
+    run = ((points[i] > JMP_THRESHOLD) == rising) ? run + 1 : 0;
+    if (run == MERGE_SPIKE) {
+      return i + 1 - run;
+    }
+  }
+  return -1;
+}
+
+
+/**
+ * symbolLevel - Median of the central half of a symbol, away from its edges.
+ *
+ * @param  {Array} points       Timing measurements
+ * @param  {Object} levelResults Start and symbol size
+ * @param  {Number} symbolIndex Index of the symbol from the start of the frame
+ * @return {Number}             The median, -1 if the symbol is past the points
+ */
+function symbolLevel(points, levelResults, symbolIndex) {
+  var first = levelResults.start + Math.floor((symbolIndex + 0.25) * levelResults.symbolSize);
+  var last = levelResults.start + Math.floor((symbolIndex + 0.75) * levelResults.symbolSize);
+  if (last >= points.length) {
+    return -1;
+  }
+  return median(Uint16Array.from(points.slice(first, last + 1)));
+}
+
+
+/**
+ * decodeLevels - Finds the extended init sequence, learns the levels and
+ * classifies the symbols after it.
+ *
+ * @param  {Array} points      Timing measurements
+ * @param  {Number} levelCount Levels per symbol
+ * @param  {Number} symbolCount Number of symbols after the init sequence
+ * @return {Object}            {symbols, levels, thresholds, start, symbolSize},
+ * symbols is empty if the init sequence was not found
+ */
+function decodeLevels(points, levelCount, symbolCount) {
+  var levelResults = {symbols: [], levels: [], thresholds: [], start: -1, symbolSize: 0};
+  var edges = [];
+  var from = 0;
+  for (var e = 0; e < INIT_SYMBOLS; e++) {
+    from = findEdge(points, from, e % 2 == 0);
+    if (from == -1) {
+      return levelResults;
+    }
+    edges.push(from);
+  }
+  levelResults.start = edges[0];
+  levelResults.symbolSize = (edges[3] - edges[0]) / 3;
+  if (levelResults.symbolSize < 2) {
+    return levelResults;
+  }
+
+  for (var level = 0; level < levelCount; level++) {
+    var value = symbolLevel(points, levelResults, INIT_SYMBOLS + level);
+    if ((value < 0) || ((level > 0) && (value <= levelResults.levels[level - 1]))) {
+      return levelResults; // The levels must be increasing
+    }
+    levelResults.levels.push(value);
+  }
+  for (var level = 0; level < levelCount - 1; level++) {
+    levelResults.thresholds.push((levelResults.levels[level] + levelResults.levels[level + 1]) / 2);
+  }
+
+  for (var s = 0; s < symbolCount; s++) {
+    var value = symbolLevel(points, levelResults, INIT_SYMBOLS + levelCount + s);
+    if (value < 0) {
+      break;
+    }
+    var symbol = 0;
+    while ((symbol < levelCount - 1) && (value > levelResults.thresholds[symbol])) {
+      symbol++;
+    }
+    levelResults.symbols.push(symbol);
+  }
+  return levelResults;
+}
+
+
+/**
+ * listenLevels - Receiver of multi-level data frames, the counterpart of
+ * listenDen. It records the timings (with the same median window) until the
+ * frame is complete or the timeout, then decodes them.
+ *
+ * Ths is an async function, use it with await.
+ *
+ * @param  {Function} spamFunction Function creating contention on port 1.
+ * @param  {Object} clock          SharedArrayBuffer clock.
+ * @return {Object}                The received bits, and in results the
+ * learned levels and bitCount, the number of bits received
+ */
+async function listenLevels(spamFunction, clock) {
+  var medianSize = 3;
+  var medianArray = new Uint16Array(medianSize).fill(0);
+  var width = bitsPerSymbol(SYMBOL_LEVELS);
+  var symbolCount = Math.ceil(DATA_FRAME_SIZE / width);
+  var frameSymbols = INIT_SYMBOLS + SYMBOL_LEVELS + symbolCount;
+  var points = [];
+  var levelResults = null;
+  var start = performance.now();
+
+  while (performance.now() < start + DATA_TIMEOUT) {
+    for (var i = 0; i < medianSize; i ++) {
+      medianArray[i] = await clocklessListener(clock, spamFunction);
+    }
+    points.push(median3(medianArray[0], medianArray[1], medianArray[2]));
+
+    // Once the symbol size is known, we know when the frame ends
+    if ((levelResults === null) && (points.length % 32 == 0)) {
+      var found = decodeLevels(points, SYMBOL_LEVELS, 0);
+      if (found.symbolSize >= 2) levelResults = found;
+    }
+    if ((levelResults !== null) && (points.length > levelResults.start + (frameSymbols + 0.5) * levelResults.symbolSize)) {
+      break;
+    }
+  }
+
+  levelResults = decodeLevels(points, SYMBOL_LEVELS, symbolCount);
+  var bits = symbolsToBits(levelResults.symbols, SYMBOL_LEVELS, DATA_FRAME_SIZE);
+  levelResults.bitCount = Math.min(DATA_FRAME_SIZE, levelResults.symbols.length * width);
+  if (DEBUG) {
+    console.log(levelResults);
+    plotEvolution([...points.keys()], points);
+  }
+  return {bits: bits, results: levelResults}
+}
@@ -89,7 +89,8 @@ async function listenDen(spamFunction=null, clock=null, frameSize = DATA_FRAME_S
     for (var i = 0; i < medianSize; i ++) {
       medianArray[i] = await clocklessListener(clock, spamFunction);
     }
-    point = median(medianArray);
+    // Windows of 3 (our default) skip the sort
+    point = medianSize == 3 ? median3(medianArray[0], medianArray[1], medianArray[2]) : median(medianArray);
     parseNewPointThreshold(point, thresholdResults); //  This is the main function
     // parsing points by our detector.
     // This is the function that will also modify thresholdResults.bitCount,
@@ -125,19 +126,26 @@ async function listenDen(spamFunction=null, clock=null, frameSize = DATA_FRAME_S
    * these errors.
    *
   **/
-  if (!checkCode(bits) & checkInitSequence(bits) & !alphabet.includes(getData(bits))) {
+  if (!checkDataFrame(bits) & checkInitSequence(bits)) {
     mainLoop:
     for (var bit0offset = -3; bit0offset <= 3; bit0offset+=2) {
       for (var bit1offset = -3; bit1offset <= 3; bit1offset+=2) {
         if (bit1offset != 0 | bit0offset !=0) { //Don't check the default frame since its already incorect
           bits = getBitsThresholdCustom(thresholdResults, thresholdResults.bitSize[0] - bit0offset, thresholdResults.bitSize[1] + bit1offset);
-          if (checkCode(bits) & checkInitSequence(bits) & alphabet.includes(getData(bits))) {
+          if (checkDataFrame(bits)) {
             break mainLoop; // breaks out of the two nested loops.
           }
         }
       }
     }
   }
+  // Last resort: the most likely valid frame given the confidence of each bit
+  if (SOFT_DECISION & !checkDataFrame(bits)) {
+    var softBits = softDecodeDataFrame(getSoftBitsThreshold(thresholdResults));
+    if (softBits !== null) {
+      bits = softBits;
+    }
+  }
   if (DEBUG) {
     console.log(bits)
     plotEvolution(Xs, points);
@@ -0,0 +1,123 @@
+/**
+* This module makes soft decisions on the data frames, the counterpart of
+* native/softDecision.h.
+*
+* Instead of a bit, the detector gives the log-likelihood (LLR) of each bit:
+* positive for a 1, negative for a 0, and the larger its magnitude the more
+* reliable the bit. It comes from the distance of the points of the bit to the
+* threshold, compared with their spread.
+*
+* When the hard bits of a frame are invalid, the receiver picks the most likely
+* valid frame, i.e. the one whose bits agree the most with the LLRs. It is only
+* accepted if it is clearly more likely than the next one (SOFT_MIN_MARGIN) and
+* if the bits it flips were unreliable ones (SOFT_MAX_FLIPPED).
+**/
+
+
+/**
+ * clustersToLlrs - Log-likelihoods of the bits of clusters of points.
+ *
+ * Both levels are taken as Gaussians, at the same distance of the threshold:
+ * the LLR of the mean of the points of a bit is then
+ * 2 * separation * (mean - threshold) / (noise / points).
+ *
+ * @param  {Array} softClusters {bitPosition, pointCount, margin (mean distance
+ * of the points to the threshold), variance, bitCount (not rounded)}
+ * @param  {Number} llrCount    Number of bits to return
+ * @return {Array(Number)}      The LLRs, 0 for the bits after the clusters
+ */
+function clustersToLlrs(softClusters, llrCount) {
+  var points = 0, noise = 0, separation = 0;
+  for (var cluster of softClusters) {
+    points += cluster.pointCount;
+    noise += cluster.pointCount * cluster.variance;
+    separation += cluster.pointCount * Math.abs(cluster.margin);
+  }
+  if (points > 0) {
+    noise /= points;
+    separation /= points;
+  }
+  noise = Math.max(noise, 1);
+
+  var llrs = [];
+  for (var cluster of softClusters) {
+    var clusterBits = Math.round(cluster.bitCount);
+    if (clusterBits == 0) continue;
+    var towards = cluster.bitPosition ? cluster.margin : -cluster.margin;
+    var llr = 2 * separation * towards * cluster.pointCount / clusterBits / noise;
+    llr = Math.min(Math.max(llr, 0), SOFT_MAX_LLR);
+    if (!cluster.bitPosition) llr = -llr;
+
+    for (var b = 0; (b < clusterBits) & (llrs.length < llrCount); b++) {
+      // Whether the last bit exists depends on the rounding
+      var weight = b == clusterBits - 1 ? 1 - 2 * Math.abs(cluster.bitCount - clusterBits) : 1;
+      llrs.push(llr * weight);
+    }
+  }
+  while (llrs.length < llrCount) llrs.push(0);
+  return llrs;
+}
+
+
+/**
+ * softDecodeDataFrame - Most likely valid data frame given the LLRs: init
+ * sequence 1010, any sequence number, a byte of the alphabet and its Berger code.
+ * With a convolutional code, this is the Viterbi decoder fed with the LLRs,
+ * whose Berger code must then be valid.
+ *
+ * @param  {Array(Number)} llrs DATA_FRAME_SIZE log-likelihoods
+ * @return {Array}              The bits of the frame, null if no frame is
+ * reliable enough or the init sequence disagrees with the LLRs
+ */
+function softDecodeDataFrame(llrs) {
+  var init = [1, 0, 1, 0];
+  for (var i = 0; i < INIT_SEQ_SIZE; i++) {
+    if (init[i] ? llrs[i] < 0 : llrs[i] > 0) {
+      return null;
+    }
+  }
+  if (FEC_MODE != FEC_NONE) {
+    var plainFrame = init.concat(viterbiDecode(llrs.slice(INIT_SEQ_SIZE), PLAIN_FRAME_SIZE - INIT_SEQ_SIZE, FEC_MODE));
+    if (!checkCode(plainFrame) || !alphabet.includes(getData(plainFrame))) {
+      return null;
+    }
+    return init.concat(convEncode(plainFrame.slice(INIT_SEQ_SIZE), FEC_MODE));
+  }
+
+  var best = -Infinity, second = -Infinity, bestFrame = null;
+  for (var sequenceNumber = 0; sequenceNumber < (1 << SEQ_NB_SIZE); sequenceNumber++) {
+    for (var letter of alphabet) {
+      var frame = init.slice();
+      var value = (sequenceNumber << DATA_SIZE) | letter.charCodeAt(0);
+      for (var b = SEQ_NB_SIZE + DATA_SIZE - 1; b >= 0; b--) {
+        frame.push((value >> b) & 1);
+      }
+      var zeroCount = frame.filter(bit => bit == 0).length;
+      for (var b = CODE_SIZE - 1; b >= 0; b--) {
+        frame.push((zeroCount >> b) & 1);
+      }
+
+      var metric = 0;
+      for (var i = INIT_SEQ_SIZE; i < DATA_FRAME_SIZE; i++) {
+        metric += frame[i] ? llrs[i] : -llrs[i];
+      }
+      if (metric > best) {
+        second = best;
+        best = metric;
+        bestFrame = frame;
+      }
+      else if (metric > second) {
+        second = metric;
+      }
+    }
+  }
+  if (best - second < SOFT_MIN_MARGIN) {
+    return null;
+  }
+  // The bits flipped from the hard decisions must be unreliable ones
+  var flipped = 0;
+  for (var i = 0; i < DATA_FRAME_SIZE; i++) {
+    if (bestFrame[i] != (llrs[i] > 0)) flipped += Math.abs(llrs[i]);
+  }
+  return flipped <= SOFT_MAX_FLIPPED ? bestFrame : null;
+}
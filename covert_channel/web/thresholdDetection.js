@@ -23,6 +23,8 @@
 *  clusters: [{ A list of clusters, each composed of:
 *    pointCount {Number}: Number of timing measurements in the cluster,
 *    bitPosition {Number}: the vbit value of the cluster (1 or 0)
+*    marginSum {Number}: Sum of the distances of its points to the threshold
+*    marginSquareSum {Number}: Sum of their squares, both for soft decisions
 *  }],
 *};
 *
@@ -128,6 +130,31 @@ function getBitsThreshold(thresholdResults) {
 
 
 
+/**
+ * getSoftBitsThreshold - Soft version of getBitsThreshold: the log-likelihood
+ * of each bit of the frame, see softDecision.js.
+ *
+ * @param  {Object} thresholdResults
+ * @return {Array(Number)}  DATA_FRAME_SIZE log-likelihoods, positive for a 1
+ */
+function getSoftBitsThreshold(thresholdResults) {
+ var softClusters = [];
+ for (var cluster of thresholdResults.clusters) {
+   if (cluster.pointCount == 0) continue;
+   var margin = cluster.marginSum / cluster.pointCount;
+   softClusters.push({
+     bitPosition: Number(cluster.bitPosition),
+     pointCount: cluster.pointCount,
+     margin: margin,
+     variance: cluster.marginSquareSum / cluster.pointCount - margin * margin,
+     bitCount: cluster.pointCount / thresholdResults.bitSize[Number(cluster.bitPosition)]
+   });
+ }
+ return clustersToLlrs(softClusters, DATA_FRAME_SIZE);
+}
+
+
+
 /**
  * getBitCountThresholdCustom - Given a cluster threshold, returns the number of bits
  * it contains by using a custom bitsize, instead of thresholdResults
@@ -196,7 +223,9 @@ function initThresholdDetection(threshold) {
     clusters: [{ // We initalize the cluster array with a empty cluster
       // We set it to 0 as when we start listening, it is rare to directly receive a 1
       pointCount: 0,
-      bitPosition: 0
+      bitPosition: 0,
+      marginSum: 0,
+      marginSquareSum: 0
     }],
   };
   return thresholdResults
@@ -257,10 +286,13 @@ function smoothen(thresholdResults) {
   // That is because it does not have its full point count yet.
   // Hence we work on the second to last cluster, which is fully formed
   if (thresholdResults.clusters[thresholdResults.clusters.length -2].pointCount <= MERGE_SPIKE) {
-    // We merge the second to last in the third to last
-    thresholdResults.clusters[thresholdResults.clusters.length - 3].pointCount += thresholdResults.clusters[thresholdResults.clusters.length -2].pointCount;
-    // And the last one too !
-    thresholdResults.clusters[thresholdResults.clusters.length - 3].pointCount += thresholdResults.clusters.last().pointCount;
+    // We merge the second to last in the third to last, and the last one too !
+    var merged = thresholdResults.clusters[thresholdResults.clusters.length - 3];
+    for (var cluster of thresholdResults.clusters.slice(-2)) {
+      merged.pointCount += cluster.pointCount;
+      merged.marginSum += cluster.marginSum;
+      merged.marginSquareSum += cluster.marginSquareSum;
+    }
     // Remove obsolete clusters
     thresholdResults.clusters.pop();
     thresholdResults.clusters.pop();
@@ -285,7 +317,10 @@ function parseNewPointThreshold(point, thresholdResults) {
   // This means it belongs to this cluster
   if (getBitPositionThreshold(point, thresholdResults) == thresholdResults.clusters.last().bitPosition) {
     // So we update it
+    var margin = point - thresholdResults.threshold;
     thresholdResults.clusters.last().pointCount++;
+    thresholdResults.clusters.last().marginSum += margin;
+    thresholdResults.clusters.last().marginSquareSum += margin * margin;
 
 
     // We still sometime check if we have enough bits to have the whole frame,
@@ -314,9 +349,12 @@ function parseNewPointThreshold(point, thresholdResults) {
     }
 
     // In the end, let's add the new cluster !
+    var margin = point - thresholdResults.threshold;
     thresholdResults.clusters.push({
       pointCount: 1,
-      bitPosition: getBitPositionThreshold(point, thresholdResults)
+      bitPosition: getBitPositionThreshold(point, thresholdResults),
+      marginSum: margin,
+      marginSquareSum: margin * margin
     });
   }
 }
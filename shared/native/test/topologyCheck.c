@@ -0,0 +1,119 @@
+/*!
+   \file topologyCheck.c
+   \brief Checks topology.c against the fake sysfs trees of test/sysfs:
+          interleaved    8 CPUs, siblings numbered 0-1, 2-3...
+          coreMajor      siblings numbered 0,4, 1,5... on 2 packages and 2
+                         NUMA nodes, CPU 7 offline
+          noTopology     cpu<n> folders only, no online file
+          A missing tree must fail readTopology, and getTopology must then fall
+          back on sysconf.
+          Usage: topologyCheck <folder of the trees>
+*/
+
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+
+
+#define MAX_EXPECTED 8
+
+
+typedef struct {
+  const char *tree;
+  int cpuCount;
+  int nodeCount;
+  int slotCount;
+  int slots[MAX_EXPECTED];
+  int siblingCount; // Pairs of siblings below
+  int siblings[MAX_EXPECTED][2]; // A CPU and its expected siblingCpu
+} TopologyCase;
+
+
+static const TopologyCase cases[] = {
+  {"interleaved", 8, 1, 4, {0, 2, 4, 6}, 3, {{0, 1}, {1, 0}, {6, 7}}},
+  {"coreMajor", 7, 2, 4, {0, 1, 2, 3}, 3, {{0, 4}, {6, 2}, {3, -1}}},
+  {"noTopology", 3, 1, 3, {0, 1, 2}, 2, {{0, -1}, {2, -1}}},
+};
+
+static int failures = 0;
+
+
+
+static void expect(const char *tree, const char *what, int value, int expected) {
+  if (value != expected) {
+    printf("FAIL %s: %s is %i, expected %i\n", tree, what, value, expected);
+    failures++;
+  }
+}
+
+
+
+static int checkCase(const char *folder, const TopologyCase *tc) {
+  char root[PATH_MAX];
+  snprintf(root, sizeof(root), "%s/%s", folder, tc->tree);
+  static Topology topology;
+  if (readTopology(&topology, root) != 1) {
+    printf("FAIL %s: cannot read %s\n", tc->tree, root);
+    failures++;
+    return -1;
+  }
+  int failed = failures;
+  expect(tc->tree, "cpuCount", topology.cpuCount, tc->cpuCount);
+  expect(tc->tree, "nodeCount", topology.nodeCount, tc->nodeCount);
+
+  int slots[TOPOLOGY_MAX_CORES];
+  int slotCount = topologySlots(&topology, slots, TOPOLOGY_MAX_CORES);
+  expect(tc->tree, "slot count", slotCount, tc->slotCount);
+  for (int s = 0; (s < slotCount) && (s < tc->slotCount); s++) {
+    expect(tc->tree, "slot", slots[s], tc->slots[s]);
+  }
+  for (int p = 0; p < tc->siblingCount; p++) {
+    char what[64];
+    snprintf(what, sizeof(what), "sibling of CPU %i", tc->siblings[p][0]);
+    expect(tc->tree, what, topologySibling(&topology, tc->siblings[p][0]), tc->siblings[p][1]);
+  }
+  if (failures == failed) printf("ok   %s\n", tc->tree);
+  return 1;
+}
+
+
+
+// The public functions on a missing tree, through TOPOLOGY_ROOT
+static int checkMissing(const char *folder) {
+  char root[PATH_MAX];
+  snprintf(root, sizeof(root), "%s/missing", folder);
+  static Topology topology;
+  int failed = failures;
+  expect("missing", "readTopology", readTopology(&topology, root), -1);
+
+  setenv(TOPOLOGY_ROOT_ENV, root, 1);
+  long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+  int slots[TOPOLOGY_MAX_CORES];
+  int slotCount = coreSlots(slots, TOPOLOGY_MAX_CORES);
+  expect("missing", "slot count", slotCount, cpuCount > 0 ? (int) cpuCount : 1);
+  expect("missing", "first slot", slots[0], 0);
+  expect("missing", "sibling of CPU 0", siblingCpu(0), -1);
+  if (failures == failed) printf("ok   missing\n");
+  return 1;
+}
+
+
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    printf("Usage: %s <folder of the trees>\n", argv[0]);
+    return 1;
+  }
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    checkCase(argv[1], &cases[c]);
+  }
+  checkMissing(argv[1]);
+  if (failures > 0) {
+    printf("%i topology checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
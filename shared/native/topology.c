@@ -0,0 +1,239 @@
+/*!
+   \file topology.c
+   \brief sysfs topology, see topology.h
+*/
+
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+
+
+static Topology systemTopology;
+static pthread_once_t systemTopologyOnce = PTHREAD_ONCE_INIT;
+
+
+
+// Reads a list of CPUs like 0-3,8,10-11, returns the number read or -1
+static int readCpuList(const char *path, int *cpus, int maxCount) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return -1;
+  }
+  int count = 0, first, last;
+  char separator;
+  while (fscanf(fp, "%d", &first) == 1) {
+    last = first;
+    if ((fscanf(fp, "%c", &separator) == 1) && (separator == '-')) {
+      if (fscanf(fp, "%d", &last) != 1) break;
+      if (fscanf(fp, "%c", &separator) != 1) separator = '\n';
+    }
+    for (int cpu = first; (cpu <= last) && (count < maxCount); cpu++) {
+      cpus[count++] = cpu;
+    }
+    if (separator != ',') break;
+  }
+  fclose(fp);
+  return count;
+}
+
+
+
+static int readInt(const char *path, int fallback) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return fallback;
+  }
+  int value;
+  if (fscanf(fp, "%d", &value) != 1) {
+    value = fallback;
+  }
+  fclose(fp);
+  return value;
+}
+
+
+
+static int compareInts(const void *a, const void *b) {
+  return *(const int *) a - *(const int *) b;
+}
+
+
+
+// The logical CPUs of the cpu<n> folders, when there is no online file
+static int scanCpus(const char *root, int *cpus, int maxCount) {
+  DIR *dir = opendir(root);
+  if (dir == NULL) {
+    return -1;
+  }
+  int count = 0, cpu;
+  char end;
+  struct dirent *entry;
+  while (((entry = readdir(dir)) != NULL) && (count < maxCount)) {
+    if (sscanf(entry->d_name, "cpu%d%c", &cpu, &end) == 1) {
+      cpus[count++] = cpu;
+    }
+  }
+  closedir(dir);
+  return count;
+}
+
+
+
+// NUMA node of a CPU, from its node<n> link
+static int readNode(const char *root, int cpu) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/cpu%i", root, cpu);
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    return 0;
+  }
+  int node = 0, value;
+  char end;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (sscanf(entry->d_name, "node%d%c", &value, &end) == 1) {
+      node = value;
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+
+
+int readTopology(Topology *topology, const char *root) {
+  memset(topology, 0, sizeof(Topology));
+  static int online[TOPOLOGY_MAX_CPUS];
+  static int keys[TOPOLOGY_MAX_CORES]; // First logical CPU of the siblings of each core
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/online", root);
+  int cpuCount = readCpuList(path, online, TOPOLOGY_MAX_CPUS);
+  if (cpuCount <= 0) {
+    cpuCount = scanCpus(root, online, TOPOLOGY_MAX_CPUS);
+  }
+  if (cpuCount <= 0) {
+    return -1;
+  }
+  qsort(online, cpuCount, sizeof(int), compareInts);
+
+  for (int i = 0; i < cpuCount; i++) {
+    int cpu = online[i];
+    int siblings[TOPOLOGY_MAX_SIBLINGS];
+    snprintf(path, sizeof(path), "%s/cpu%i/topology/thread_siblings_list", root, cpu);
+    // Without a siblings list, the CPU is its own physical core
+    int key = readCpuList(path, siblings, TOPOLOGY_MAX_SIBLINGS) > 0 ? siblings[0] : cpu;
+
+    int c = 0;
+    while ((c < topology->coreCount) && (keys[c] != key)) c++;
+    if (c == topology->coreCount) {
+      if (c == TOPOLOGY_MAX_CORES) continue;
+      PhysicalCore *core = &topology->cores[topology->coreCount++];
+      keys[c] = key;
+      snprintf(path, sizeof(path), "%s/cpu%i/topology/physical_package_id", root, cpu);
+      core->package = readInt(path, 0);
+      snprintf(path, sizeof(path), "%s/cpu%i/topology/core_id", root, cpu);
+      core->coreId = readInt(path, -1);
+      core->node = readNode(root, cpu);
+      if (core->node >= topology->nodeCount) topology->nodeCount = core->node + 1;
+    }
+    PhysicalCore *core = &topology->cores[c];
+    if (core->siblingCount < TOPOLOGY_MAX_SIBLINGS) {
+      core->siblings[core->siblingCount++] = cpu;
+    }
+    topology->cpuCount++;
+  }
+  return 1;
+}
+
+
+
+static void readSystemTopology() {
+  const char *root = getenv(TOPOLOGY_ROOT_ENV);
+  if (readTopology(&systemTopology, root != NULL ? root : TOPOLOGY_ROOT) == 1) {
+    return;
+  }
+  long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+  fprintf(stderr, "Warning: cannot read the CPU topology, using %ld CPUs as physical cores\n", cpuCount);
+  memset(&systemTopology, 0, sizeof(Topology));
+  for (int cpu = 0; (cpu < cpuCount) && (cpu < TOPOLOGY_MAX_CORES); cpu++) {
+    PhysicalCore *core = &systemTopology.cores[systemTopology.coreCount++];
+    core->coreId = -1;
+    core->siblings[0] = cpu;
+    core->siblingCount = 1;
+    systemTopology.cpuCount++;
+  }
+  systemTopology.nodeCount = 1;
+  if (systemTopology.coreCount == 0) { // Not even sysconf, pin on CPU 0
+    systemTopology.coreCount = systemTopology.cpuCount = 1;
+    systemTopology.cores[0].siblingCount = 1;
+  }
+}
+
+
+
+const Topology *getTopology() {
+  pthread_once(&systemTopologyOnce, readSystemTopology);
+  return &systemTopology;
+}
+
+
+
+int topologySlots(const Topology *topology, int *cpus, int maxCount) {
+  int count = topology->coreCount < maxCount ? topology->coreCount : maxCount;
+  for (int c = 0; c < count; c++) {
+    cpus[c] = topology->cores[c].siblings[0];
+  }
+  return count;
+}
+
+
+
+int topologySibling(const Topology *topology, int cpu) {
+  for (int c = 0; c < topology->coreCount; c++) {
+    const PhysicalCore *core = &topology->cores[c];
+    for (int s = 0; s < core->siblingCount; s++) {
+      if (core->siblings[s] == cpu) {
+        for (int other = 0; other < core->siblingCount; other++) {
+          if (core->siblings[other] != cpu) return core->siblings[other];
+        }
+        return -1;
+      }
+    }
+  }
+  return -1;
+}
+
+
+
+int coreSlots(int *cpus, int maxCount) {
+  return topologySlots(getTopology(), cpus, maxCount);
+}
+
+
+
+int siblingCpu(int cpu) {
+  return topologySibling(getTopology(), cpu);
+}
+
+
+
+int printTopology(const Topology *topology) {
+  printf("%i logical CPUs, %i physical cores, %i NUMA nodes\n", topology->cpuCount, topology->coreCount, topology->nodeCount);
+  printf("slot\tpackage\tcore\tnode\tsiblings\n");
+  for (int c = 0; c < topology->coreCount; c++) {
+    const PhysicalCore *core = &topology->cores[c];
+    printf("%i\t%i\t%i\t%i\t", c, core->package, core->coreId, core->node);
+    for (int s = 0; s < core->siblingCount; s++) {
+      printf("%s%i", s == 0 ? "" : ",", core->siblings[s]);
+    }
+    printf("\n");
+  }
+  return 1;
+}
@@ -0,0 +1,112 @@
+/*!
+   \file topology.h
+   \brief CPU topology of the machine, read from sysfs.
+          Port contention happens between the SMT siblings of a physical core,
+          so the native components pin one thread per physical core, and the
+          logical CPUs are not always numbered core by core. This module groups
+          the online logical CPUs of /sys/devices/system/cpu in physical cores
+          (by their thread_siblings_list), with their package and NUMA node,
+          and hands out one CPU per physical core to pin on.
+          The TOPOLOGY_ROOT environment variable replaces the sysfs folder, to
+          run against a fake tree (see topologyInfo.c).
+*/
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#define TOPOLOGY_ROOT "/sys/devices/system/cpu"
+#define TOPOLOGY_ROOT_ENV "TOPOLOGY_ROOT"
+#define TOPOLOGY_MAX_CPUS 1024
+#define TOPOLOGY_MAX_CORES 512
+#define TOPOLOGY_MAX_SIBLINGS 8
+
+
+/*!
+   \struct PhysicalCore
+   \brief A physical core and its online SMT siblings
+*/
+typedef struct {
+  int package; // physical_package_id, 0 if unknown
+  int coreId; // core_id in the package, -1 if unknown
+  int node; // NUMA node, 0 if unknown
+  int siblings[TOPOLOGY_MAX_SIBLINGS]; // Logical CPUs, in increasing order
+  int siblingCount;
+} PhysicalCore;
+
+
+/*!
+   \struct Topology
+   \brief Physical cores of the machine, in the order of their first logical CPU
+*/
+typedef struct {
+  PhysicalCore cores[TOPOLOGY_MAX_CORES];
+  int coreCount;
+  int cpuCount; // Online logical CPUs
+  int nodeCount;
+} Topology;
+
+
+
+/*!
+   \fn int readTopology(Topology *topology, const char *root)
+   \brief Reads the topology of the online CPUs
+   \param topology Output
+   \param root Folder of the cpu<n> folders, usually TOPOLOGY_ROOT
+   \return 1 if ok, -1 if no online CPU could be read
+*/
+int readTopology(Topology *topology, const char *root);
+
+
+
+/*!
+   \fn const Topology *getTopology()
+   \brief Topology of this machine, read once from TOPOLOGY_ROOT (or the
+          folder of the TOPOLOGY_ROOT environment variable). If sysfs cannot be
+          read, every CPU of sysconf is its own physical core.
+*/
+const Topology *getTopology();
+
+
+
+/*!
+   \fn int coreSlots(int *cpus, int maxCount)
+   \brief Gives one logical CPU per physical core (its first SMT sibling)
+   \param cpus Output, maxCount CPUs at most
+   \return The number of CPUs written, at least 1
+*/
+int coreSlots(int *cpus, int maxCount);
+
+
+
+/*!
+   \fn int siblingCpu(int cpu)
+   \return Another SMT sibling of a logical CPU, -1 if it has none (no SMT,
+           or an SMT sibling offline): callers must not pin on it then
+*/
+int siblingCpu(int cpu);
+
+
+
+/*!
+   \fn int topologySlots(const Topology *topology, int *cpus, int maxCount)
+   \brief coreSlots on a given topology, e.g. one of readTopology
+*/
+int topologySlots(const Topology *topology, int *cpus, int maxCount);
+
+
+
+/*!
+   \fn int topologySibling(const Topology *topology, int cpu)
+   \brief siblingCpu on a given topology
+*/
+int topologySibling(const Topology *topology, int cpu);
+
+
+
+/*!
+   \fn int printTopology(const Topology *topology)
+   \brief Prints the physical cores and their siblings
+*/
+int printTopology(const Topology *topology);
+
+#endif
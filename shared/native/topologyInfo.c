@@ -0,0 +1,43 @@
+/*!
+   \file topologyInfo.c
+   \brief Prints the topology of topology.h and the CPUs the native components
+          pin their threads on. With -r, reads a fake sysfs tree instead, laid
+          out like /sys/devices/system/cpu: an online file and, in each
+          cpu<n> folder, topology/thread_siblings_list,
+          topology/physical_package_id, topology/core_id and a node<n> entry.
+*/
+
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+
+int main(int argc, char *argv[]) {
+  const char *root = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:h")) != -1) {
+    switch (opt) {
+      case 'r': root = optarg; break;
+      default:
+        printf("Usage: %s [-r root]\n", argv[0]);
+        printf("\t-r root\tFolder of the cpu<n> folders (default %s)\n", TOPOLOGY_ROOT);
+        return 1;
+    }
+  }
+  if (root != NULL) {
+    setenv(TOPOLOGY_ROOT_ENV, root, 1);
+  }
+  const Topology *topology = getTopology();
+  printTopology(topology);
+
+  int cpus[TOPOLOGY_MAX_CORES];
+  int count = coreSlots(cpus, TOPOLOGY_MAX_CORES);
+  printf("Pinned slots:");
+  for (int c = 0; c < count; c++) {
+    printf(" %i", cpus[c]);
+  }
+  printf("\nSMT sibling of CPU %i: %i\n", cpus[0], siblingCpu(cpus[0]));
+  return 0;
+}
@@ -19,6 +19,21 @@ function median (array) {
 
 
 
+/**
+ * median3 - Median of three numbers, without sorting nor branching on the
+ * values. Same result as median on a window of 3.
+ *
+ * @param  {Number} a
+ * @param  {Number} b
+ * @param  {Number} c
+ * @return {Number}   The median of a, b and c
+ */
+function median3 (a, b, c) {
+  return Math.max(Math.min(a, b), Math.min(Math.max(a, b), c));
+}
+
+
+
 /**
  * average - Computes the average of an array. Works on TypedArray!
  *